@@ -180,9 +180,11 @@ SOURCES += \
     backend/identitymanager.cpp \
     backend/nvcomputer.cpp \
     backend/nvhttp.cpp \
+    backend/nvserverinfo.cpp \
     backend/nvpairingmanager.cpp \
     backend/computermanager.cpp \
     backend/boxartmanager.cpp \
+    backend/hoststore.cpp \
     backend/richpresencemanager.cpp \
     cli/commandlineparser.cpp \
     cli/listapps.cpp \
@@ -199,16 +201,21 @@ SOURCES += \
     streaming/input/reltouch.cpp \
     streaming/session.cpp \
     streaming/audio/audio.cpp \
+    streaming/audio/channelmixer.cpp \
     streaming/audio/renderers/sdlaud.cpp \
     gui/computermodel.cpp \
     gui/appmodel.cpp \
     streaming/bandwidth.cpp \
+    streaming/avsync.cpp \
+    streaming/inputlatency.cpp \
+    streaming/statsexporter.cpp \
     streaming/streamutils.cpp \
     backend/autoupdatechecker.cpp \
     path.cpp \
     settings/mappingmanager.cpp \
     gui/sdlgamepadkeynavigation.cpp \
     streaming/video/overlaymanager.cpp \
+    streaming/video/frametimegraph.cpp \
     backend/systemproperties.cpp \
     wm.cpp
 
@@ -224,9 +231,11 @@ HEADERS += \
     backend/identitymanager.h \
     backend/nvcomputer.h \
     backend/nvhttp.h \
+    backend/nvserverinfo.h \
     backend/nvpairingmanager.h \
     backend/computermanager.h \
     backend/boxartmanager.h \
+    backend/hoststore.h \
     backend/richpresencemanager.h \
     cli/commandlineparser.h \
     cli/listapps.h \
@@ -235,18 +244,23 @@ HEADERS += \
     settings/streamingpreferences.h \
     streaming/input/input.h \
     streaming/session.h \
+    streaming/audio/channelmixer.h \
     streaming/audio/renderers/renderer.h \
     streaming/audio/renderers/sdl.h \
     gui/computermodel.h \
     gui/appmodel.h \
     streaming/video/decoder.h \
     streaming/bandwidth.h \
+    streaming/avsync.h \
+    streaming/inputlatency.h \
+    streaming/statsexporter.h \
     streaming/streamutils.h \
     backend/autoupdatechecker.h \
     path.h \
     settings/mappingmanager.h \
     gui/sdlgamepadkeynavigation.h \
     streaming/video/overlaymanager.h \
+    streaming/video/frametimegraph.h \
     backend/systemproperties.h
 
 # Platform-specific renderers and decoders
@@ -449,6 +463,13 @@ wayland {
     SOURCES += streaming/video/ffmpeg-renderers/pacer/waylandvsyncsource.cpp
     HEADERS += streaming/video/ffmpeg-renderers/pacer/waylandvsyncsource.h
 }
+linux:!disable-evdev {
+    message(Raw evdev mouse input enabled)
+
+    DEFINES += HAVE_EVDEV
+    SOURCES += streaming/input/evdevmouse.cpp
+    HEADERS += streaming/input/evdevmouse.h
+}
 
 RESOURCES += \
     resources.qrc \
@@ -3,6 +3,26 @@
 
 #include <QImageReader>
 #include <QImageWriter>
+#include <QBuffer>
+#include <QSaveFile>
+#include <QDateTime>
+
+// Box art is shown at 200x267 in the app grid. Thumbnails are scaled to fit
+// within twice that size, so they remain sharp on high DPI displays.
+#define THUMBNAIL_WIDTH 400
+#define THUMBNAIL_HEIGHT 534
+
+// Hosts don't tell us when an app's art changes, so cached art
+// is checked against the host's copy once this much time passes.
+#define REVALIDATE_INTERVAL_SECS (24 * 60 * 60)
+
+static bool isPlaceholderSize(const QSize& size)
+{
+    // AppView.qml detects these placeholders by their size, so we must
+    // always give it the original image rather than a thumbnail.
+    return size == QSize(130, 180) || // GFE 2.0 placeholder image
+           size == QSize(628, 888);   // GFE 3.0 placeholder image
+}
 
 BoxArtManager::BoxArtManager(QObject *parent) :
     QObject(parent),
@@ -12,7 +32,8 @@ BoxArtManager::BoxArtManager(QObject *parent) :
     // 4 is a good balance between fast loading for large
     // app grids and not crushing GFE with tons of requests
     // and causing UI jank from constantly stalling to decode
-    // new images.
+    // new images. Each AppModel has its own BoxArtManager,
+    // so this also serves as the limit for each host.
     m_ThreadPool.setMaxThreadCount(4);
     if (!m_BoxArtDir.exists()) {
         m_BoxArtDir.mkpath(".");
@@ -20,7 +41,7 @@ BoxArtManager::BoxArtManager(QObject *parent) :
 }
 
 QString
-BoxArtManager::getFilePathForBoxArt(NvComputer* computer, int appId)
+BoxArtManager::getFilePathForBoxArt(NvComputer* computer, int appId, const QByteArray& format)
 {
     QDir dir = m_BoxArtDir;
 
@@ -32,8 +53,59 @@ BoxArtManager::getFilePathForBoxArt(NvComputer* computer, int appId)
     // Change to this computer's box art cache folder
     dir.cd(computer->uuid);
 
-    // Try to open the cached file
-    return dir.filePath(QString::number(appId) + ".png");
+    // The original asset is stored as-is, named for the format of its contents
+    return dir.filePath(QString::number(appId) + "." + QString::fromLatin1(format));
+}
+
+QString
+BoxArtManager::findBoxArt(NvComputer* computer, int appId)
+{
+    QDir dir = m_BoxArtDir;
+    if (!dir.cd(computer->uuid)) {
+        return QString();
+    }
+
+    // Older versions always saved the art as a PNG, so that's checked first
+    QStringList nameFilters;
+    nameFilters.append(QString::number(appId) + ".png");
+    for (const QByteArray& format : QImageReader::supportedImageFormats()) {
+        if (format != "png") {
+            nameFilters.append(QString::number(appId) + "." + QString::fromLatin1(format));
+        }
+    }
+
+    for (const QString& fileName : dir.entryList(nameFilters, QDir::Files)) {
+        if (QFileInfo(dir, fileName).size() > 0) {
+            return dir.filePath(fileName);
+        }
+    }
+
+    return QString();
+}
+
+QString
+BoxArtManager::getFilePathForThumbnail(NvComputer* computer, int appId, bool opaque)
+{
+    QDir dir = m_BoxArtDir;
+    dir.cd(computer->uuid);
+
+    // JPEG is much faster to encode and decode, but only PNG preserves transparency
+    return dir.filePath(QString::number(appId) + (opaque ? "_thumb.jpg" : "_thumb.png"));
+}
+
+QString
+BoxArtManager::getFilePathForLastCheck(NvComputer* computer, int appId)
+{
+    QDir dir = m_BoxArtDir;
+    dir.cd(computer->uuid);
+
+    return dir.filePath(QString::number(appId) + "_checked");
+}
+
+QString
+BoxArtManager::getCacheKey(NvComputer* computer, int appId)
+{
+    return computer->uuid + "/" + QString::number(appId);
 }
 
 class NetworkBoxArtLoadTask : public QObject, public QRunnable
@@ -41,10 +113,11 @@ class NetworkBoxArtLoadTask : public QObject, public QRunnable
     Q_OBJECT
 
 public:
-    NetworkBoxArtLoadTask(BoxArtManager* boxArtManager, NvComputer* computer, NvApp& app)
+    NetworkBoxArtLoadTask(BoxArtManager* boxArtManager, NvComputer* computer, NvApp& app, bool revalidate)
         : m_Bam(boxArtManager),
           m_Computer(computer),
-          m_App(app)
+          m_App(app),
+          m_Revalidate(revalidate)
     {
         connect(this, &NetworkBoxArtLoadTask::boxArtFetchCompleted,
                 boxArtManager, &BoxArtManager::handleBoxArtLoadComplete);
@@ -56,10 +129,10 @@ signals:
 private:
     void run()
     {
-        QUrl image = m_Bam->loadBoxArtFromNetwork(m_Computer, m_App.id);
-        if (image.isEmpty()) {
+        QUrl image = m_Bam->loadBoxArtFromNetwork(m_Computer, m_App, m_Revalidate);
+        if (image.isEmpty() && !m_Revalidate) {
             // Give it another shot if it fails once
-            image = m_Bam->loadBoxArtFromNetwork(m_Computer, m_App.id);
+            image = m_Bam->loadBoxArtFromNetwork(m_Computer, m_App, m_Revalidate);
         }
         emit boxArtFetchCompleted(m_Computer, m_App, image);
     }
@@ -67,26 +140,78 @@ private:
     BoxArtManager* m_Bam;
     NvComputer* m_Computer;
     NvApp m_App;
+    bool m_Revalidate;
 };
 
 QUrl BoxArtManager::loadBoxArt(NvComputer* computer, NvApp& app)
 {
-    // Try to open the cached file if it exists and contains data
-    QFile cacheFile(getFilePathForBoxArt(computer, app.id));
-    if (cacheFile.exists() && cacheFile.size() > 0) {
-        return QUrl::fromLocalFile(cacheFile.fileName());
+    QString cacheKey = getCacheKey(computer, app.id);
+
+    // Avoid hitting the disk each time the view asks for art we've already found
+    auto cachedUrl = m_UrlCache.constFind(cacheKey);
+    if (cachedUrl != m_UrlCache.constEnd()) {
+        return *cachedUrl;
     }
 
-    // If we get here, we need to fetch asynchronously.
-    // Kick off a worker on our thread pool to do just that.
-    NetworkBoxArtLoadTask* netLoadTask = new NetworkBoxArtLoadTask(this, computer, app);
-    m_ThreadPool.start(netLoadTask);
+    // Return the cached art straight away if it exists, so the view doesn't
+    // show the placeholder first. It's checked against the host's copy in
+    // the background if it hasn't been checked recently.
+    bool current;
+    QUrl image = loadBoxArtFromCache(computer, app, current);
+    if (!image.isEmpty()) {
+        m_UrlCache.insert(cacheKey, image);
+    }
+
+    if ((image.isEmpty() || !current) && !m_PendingLoads.contains(cacheKey)) {
+        m_PendingLoads.insert(cacheKey);
+
+        NetworkBoxArtLoadTask* netLoadTask = new NetworkBoxArtLoadTask(this, computer, app, !image.isEmpty());
+        m_ThreadPool.start(netLoadTask);
+    }
+
+    if (!image.isEmpty()) {
+        return image;
+    }
 
     // Return the placeholder then we can notify the caller
     // later when the real image is ready.
     return QUrl("qrc:/res/no_app_image.png");
 }
 
+QUrl BoxArtManager::loadBoxArtFromCache(NvComputer* computer, const NvApp& app, bool& current)
+{
+    current = false;
+
+    // Prefer the thumbnail, but fall back to the original if the
+    // art is too small to need one or the cache predates thumbnails.
+    QString path;
+    for (const QString& thumbnailPath : { getFilePathForThumbnail(computer, app.id, true),
+                                          getFilePathForThumbnail(computer, app.id, false) }) {
+        QFileInfo thumbnailInfo(thumbnailPath);
+        if (thumbnailInfo.exists() && thumbnailInfo.size() > 0) {
+            path = thumbnailPath;
+            break;
+        }
+    }
+    if (path.isEmpty()) {
+        path = findBoxArt(computer, app.id);
+        if (path.isEmpty()) {
+            return QUrl();
+        }
+    }
+
+    // The art is current if we compared it with the host's copy recently
+    QFile lastCheckFile(getFilePathForLastCheck(computer, app.id));
+    if (lastCheckFile.open(QIODevice::ReadOnly)) {
+        qint64 elapsedSecs = QDateTime::currentSecsSinceEpoch() - lastCheckFile.readAll().toLongLong();
+
+        // A negative age means the clock went backwards, so check it again
+        current = elapsedSecs >= 0 && elapsedSecs < REVALIDATE_INTERVAL_SECS;
+    }
+
+    return QUrl::fromLocalFile(path);
+}
+
 void BoxArtManager::deleteBoxArt(NvComputer* computer)
 {
     QDir dir(Path::getBoxArtCacheDir());
@@ -99,33 +224,102 @@ void BoxArtManager::deleteBoxArt(NvComputer* computer)
 
 void BoxArtManager::handleBoxArtLoadComplete(NvComputer* computer, NvApp app, QUrl image)
 {
+    m_PendingLoads.remove(getCacheKey(computer, app.id));
+
     if (!image.isEmpty()) {
+        m_UrlCache.insert(getCacheKey(computer, app.id), image);
         emit boxArtLoadComplete(computer, app, image);
     }
 }
 
-QUrl BoxArtManager::loadBoxArtFromNetwork(NvComputer* computer, int appId)
+QUrl BoxArtManager::loadBoxArtFromNetwork(NvComputer* computer, const NvApp& app, bool revalidate)
 {
     NvHTTP http(computer);
+    int appId = app.id;
 
-    QString cachePath = getFilePathForBoxArt(computer, appId);
-    QImage image;
+    QByteArray boxArt;
     try {
-        image = http.getBoxArt(appId);
+        boxArt = http.getBoxArt(appId);
     } catch (...) {}
 
-    // Cache the box art on disk if it loaded
-    if (!image.isNull()) {
-        if (image.save(cachePath)) {
-            return QUrl::fromLocalFile(cachePath);
+    // Make sure this is an image we can read before caching it
+    QBuffer boxArtBuffer(&boxArt);
+    boxArtBuffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&boxArtBuffer);
+    QSize size = reader.size();
+    QByteArray format = reader.format();
+    if (boxArt.isEmpty() || !size.isValid() || format.isEmpty()) {
+        return QUrl();
+    }
+
+    QString cachePath = getFilePathForBoxArt(computer, appId, format);
+    QString oldCachePath = findBoxArt(computer, appId);
+
+    bool needsThumbnail = !isPlaceholderSize(size) &&
+                          (size.width() > THUMBNAIL_WIDTH || size.height() > THUMBNAIL_HEIGHT);
+
+    bool changed = true;
+    if (revalidate) {
+        QFile cacheFile(oldCachePath);
+        if (!oldCachePath.isEmpty() && cacheFile.open(QIODevice::ReadOnly) && cacheFile.readAll() == boxArt) {
+            // Regenerate the thumbnail if this art was cached before we made them
+            changed = needsThumbnail &&
+                    !QFile::exists(getFilePathForThumbnail(computer, appId, true)) &&
+                    !QFile::exists(getFilePathForThumbnail(computer, appId, false));
+        }
+    }
+
+    QUrl url;
+    if (changed) {
+        // Store the original bytes to avoid re-encoding the image
+        QSaveFile cacheFile(cachePath);
+        if (!cacheFile.open(QIODevice::WriteOnly) ||
+                cacheFile.write(boxArt) != boxArt.size() ||
+                !cacheFile.commit()) {
+            return QUrl();
         }
-        else {
-            // A failed save() may leave a zero byte file. Make sure that's removed.
-            QFile(cachePath).remove();
+        url = QUrl::fromLocalFile(cachePath);
+
+        // Don't leave behind a copy of the old art under another format's name
+        if (!oldCachePath.isEmpty() && oldCachePath != cachePath) {
+            QFile::remove(oldCachePath);
+        }
+
+        QFile::remove(getFilePathForThumbnail(computer, appId, true));
+        QFile::remove(getFilePathForThumbnail(computer, appId, false));
+
+        if (needsThumbnail) {
+            boxArtBuffer.seek(0);
+            QImageReader imageReader(&boxArtBuffer);
+            QImage thumbnail = imageReader.read().scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT,
+                                                         Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+            bool opaque = !thumbnail.hasAlphaChannel();
+            QString thumbnailPath = getFilePathForThumbnail(computer, appId, opaque);
+            QSaveFile thumbnailFile(thumbnailPath);
+            if (!thumbnail.isNull() && thumbnailFile.open(QIODevice::WriteOnly)) {
+                QImageWriter writer(&thumbnailFile, opaque ? "jpg" : "png");
+                writer.setQuality(90);
+                if (writer.write(thumbnail) && thumbnailFile.commit()) {
+                    url = QUrl::fromLocalFile(thumbnailPath);
+                }
+            }
         }
+
+        if (revalidate) {
+            // Make sure the view reloads the art rather than using its cached copy
+            url.setQuery("rev=" + QString::number(QDateTime::currentMSecsSinceEpoch()));
+        }
+    }
+
+    // Remember when this art was last checked against the host's copy
+    QSaveFile lastCheckFile(getFilePathForLastCheck(computer, appId));
+    if (lastCheckFile.open(QIODevice::WriteOnly)) {
+        lastCheckFile.write(QByteArray::number(QDateTime::currentSecsSinceEpoch()));
+        lastCheckFile.commit();
     }
 
-    return QUrl();
+    return url;
 }
 
 #include "boxartmanager.moc"
@@ -5,6 +5,8 @@
 #include <QImage>
 #include <QThreadPool>
 #include <QRunnable>
+#include <QHash>
+#include <QSet>
 
 class BoxArtManager : public QObject
 {
@@ -34,11 +36,30 @@ private slots:
 
 private:
     QUrl
-    loadBoxArtFromNetwork(NvComputer* computer, int appId);
+    loadBoxArtFromCache(NvComputer* computer, const NvApp& app, bool& current);
+
+    QUrl
+    loadBoxArtFromNetwork(NvComputer* computer, const NvApp& app, bool revalidate);
+
+    QString
+    getFilePathForBoxArt(NvComputer* computer, int appId, const QByteArray& format);
+
+    QString
+    findBoxArt(NvComputer* computer, int appId);
 
     QString
-    getFilePathForBoxArt(NvComputer* computer, int appId);
+    getFilePathForThumbnail(NvComputer* computer, int appId, bool opaque);
+
+    QString
+    getFilePathForLastCheck(NvComputer* computer, int appId);
+
+    QString
+    getCacheKey(NvComputer* computer, int appId);
 
     QDir m_BoxArtDir;
     QThreadPool m_ThreadPool;
+
+    // Only accessed on the thread that owns the BoxArtManager
+    QHash<QString, QUrl> m_UrlCache;
+    QSet<QString> m_PendingLoads;
 };
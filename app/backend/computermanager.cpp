@@ -1,5 +1,7 @@
 #include "computermanager.h"
 #include "boxartmanager.h"
+#include "hoststore.h"
+#include "utils.h"
 #include "nvhttp.h"
 #include "nvpairingmanager.h"
 
@@ -8,32 +10,102 @@
 
 #include <QThread>
 #include <QThreadPool>
+#include <QThreadStorage>
 #include <QCoreApplication>
 #include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QNetworkProxy>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSet>
+
+#include <functional>
 
 #define SER_HOSTS "hosts"
 #define SER_HOSTS_BACKUP "hostsbackup"
 
-class PcMonitorThread : public QThread
-{
-    Q_OBJECT
+#define SER_MDNS_HOSTNAME "hostname"
+#define SER_MDNS_ADDRESSES "addresses"
+#define SER_MDNS_PORT "port"
+#define SER_MDNS_EXPIRATION "expiration"
+
+// QMdnsEngine doesn't expose record TTLs, so we use the TTL recommended
+// for host address records by RFC 6762. Announcements within this time
+// reuse the cached addresses rather than resolving the host again.
+#define MDNS_HOST_TTL_SECS 120
+
+// Expired entries are still probed at launch, since hosts usually keep
+// their addresses. Hosts we haven't seen for this long are forgotten.
+#define MDNS_CACHE_RETENTION_SECS (30 * 24 * 60 * 60)
 
 #define TRIES_BEFORE_OFFLINING 2
 #define POLLS_PER_APPLIST_FETCH 10
 
+// Online hosts are polled at the base interval. Offline hosts back off
+// exponentially up to the maximum interval until they respond again.
+#define POLL_INTERVAL_MS 3000
+#define MAX_OFFLINE_POLL_INTERVAL_MS 15000
+
+// Poll intervals are randomized by +/- 10% to keep hosts from synchronizing
+#define POLL_JITTER_PERCENT 10
+
+// Connection attempts to a host's addresses are staggered by this delay (RFC 8305)
+// and each one is given this long to connect before the race is abandoned.
+#define CONNECTION_ATTEMPT_DELAY_MS 250
+#define CONNECTION_ATTEMPT_TIMEOUT_MS 2000
+
+// Hosts are polled at this interval for a while after we wake them,
+// so streaming can start as soon as the host is ready
+#define WAKE_POLL_INTERVAL_MS 500
+#define WAKE_POLL_DURATION_MS 60000
+
+// Polls are blocking network requests, so a few threads are enough for
+// a large number of hosts without one slow host holding up the rest.
+// Hosts that are offline and backing off are polled on their own threads,
+// since each of those polls runs until it times out. However many hosts
+// are unreachable, they can't hold up polls of the hosts that are online.
+#define MAX_POLL_THREADS 4
+#define MAX_OFFLINE_POLL_THREADS 2
+
+// Each polling thread keeps a QNetworkAccessManager which is shared by all
+// hosts polled on that thread. Each instance creates a worker thread, so this
+// ensures we are not spamming a new thread for every single polling attempt.
+static QThreadStorage<QNetworkAccessManager*> s_PollNams;
+
+class PcMonitorTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+
 public:
-    PcMonitorThread(NvComputer* computer)
-        : m_Computer(computer)
+    PcMonitorTask(ComputerManager* computerManager, NvComputer* computer, ComputerPollingEntry* entry, int generation)
+        : m_ComputerManager(computerManager),
+          m_Computer(computer),
+          m_Entry(entry),
+          m_Generation(generation)
     {
-        setObjectName("Polling thread for " + computer->name);
+
     }
 
+signals:
+    void computerStateChanged(NvComputer* computer);
+
+    void pollCompleted();
+
 private:
+    bool isInterruptionRequested()
+    {
+        return m_Entry->isInterrupted(m_Generation);
+    }
+
     bool tryPollComputer(QNetworkAccessManager* nam, NvAddress address, bool& changed)
     {
         NvHTTP http(address, 0, m_Computer->serverCert, nam);
 
-        QString serverInfo;
+        // Reuse the connection on the next poll of hosts that support it
+        http.setAllowKeepAlive(!m_Computer->isNvidiaServerSoftware);
+
+        NvServerInfo serverInfo;
         try {
             serverInfo = http.getServerInfo(NvHTTP::NvLogLevel::NVLL_NONE, true);
         } catch (...) {
@@ -52,15 +124,119 @@ private:
         return true;
     }
 
+    // Races TCP connections to the candidate addresses, starting the next attempt every
+    // CONNECTION_ATTEMPT_DELAY_MS or as soon as the previous one fails. The first address
+    // to connect is returned and removed from the list along with those that failed, so
+    // the caller can race the rest again if the winner fails to verify. Returns a null
+    // address if none of the candidates could be reached.
+    NvAddress raceAddresses(QVector<NvAddress>& candidates)
+    {
+        if (candidates.isEmpty()) {
+            return NvAddress();
+        }
+        else if (candidates.count() == 1) {
+            // Nothing to race, so let the poll connect to it directly
+            return candidates.takeFirst();
+        }
+
+        QEventLoop loop;
+        QTimer attemptTimer;
+        QTimer timeoutTimer;
+        QVector<QTcpSocket*> sockets;
+        QVector<bool> failed(candidates.count(), false);
+        int failures = 0;
+        int winner = -1;
+
+        std::function<void()> startNextAttempt = [&]() {
+            if (winner >= 0 || sockets.count() >= candidates.count()) {
+                return;
+            }
+
+            int index = sockets.count();
+            QTcpSocket* socket = new QTcpSocket();
+            socket->setProxy(QNetworkProxy::NoProxy);
+            sockets.append(socket);
+
+            connect(socket, &QAbstractSocket::stateChanged, &loop, [&, index](QAbstractSocket::SocketState state) {
+                if (state == QAbstractSocket::ConnectedState) {
+                    if (winner < 0) {
+                        winner = index;
+                        loop.quit();
+                    }
+                }
+                else if (state == QAbstractSocket::UnconnectedState && !failed[index]) {
+                    failed[index] = true;
+                    if (++failures == candidates.count()) {
+                        loop.quit();
+                    }
+                    else {
+                        // Don't wait out the delay if this attempt failed
+                        attemptTimer.start();
+                        startNextAttempt();
+                    }
+                }
+            });
+
+            // The race only times out once the latest attempt has had time to connect
+            timeoutTimer.start();
+            socket->connectToHost(candidates[index].address(), candidates[index].port());
+        };
+
+        attemptTimer.setInterval(CONNECTION_ATTEMPT_DELAY_MS);
+        connect(&attemptTimer, &QTimer::timeout, &loop, startNextAttempt);
+
+        timeoutTimer.setSingleShot(true);
+        timeoutTimer.setInterval(CONNECTION_ATTEMPT_TIMEOUT_MS);
+        connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, &loop, &QEventLoop::quit);
+
+        attemptTimer.start();
+        startNextAttempt();
+        if (winner < 0 && failures < candidates.count()) {
+            loop.exec(QEventLoop::ExcludeUserInputEvents);
+        }
+
+        // Cancel the attempts that lost the race
+        for (QTcpSocket* socket : std::as_const(sockets)) {
+            socket->disconnect(&loop);
+            socket->abort();
+            delete socket;
+        }
+
+        NvAddress winningAddress = winner >= 0 ? candidates[winner] : NvAddress();
+
+        QVector<NvAddress> remaining;
+        for (int i = 0; i < candidates.count(); i++) {
+            if (i != winner && !failed[i]) {
+                remaining.append(candidates[i]);
+            }
+        }
+        candidates = remaining;
+
+        return winningAddress;
+    }
+
     bool updateAppList(QNetworkAccessManager* nam, bool& changed)
     {
         NvHTTP http(m_Computer, nam);
 
         QVector<NvApp> appList;
 
+        // We need the persisted app list to carry client-side attributes forward
+        m_ComputerManager->loadAppList(m_Computer);
+
+        // Never trust the response hash if we have nothing to show for it
+        if (m_Computer->appList.isEmpty()) {
+            m_Entry->m_AppListResponseHash.clear();
+        }
+
         try {
-            appList = http.getAppList();
-            if (appList.isEmpty()) {
+            if (!http.getAppListIfChanged(appList, m_Entry->m_AppListResponseHash)) {
+                // Same response as last time, so there's nothing to parse or diff
+                return true;
+            }
+            else if (appList.isEmpty()) {
+                m_Entry->m_AppListResponseHash.clear();
                 return false;
             }
         } catch (...) {
@@ -72,122 +248,198 @@ private:
         return true;
     }
 
-    void run() override
+    bool pollComputer(QNetworkAccessManager* nam)
     {
-        // Reduce the power and performance impact of our
-        // computer status polling while it's running.
-        setPriority(QThread::LowPriority);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
-        setServiceLevel(QThread::QualityOfService::Eco);
-#endif
-
-        // Share the QNetworkAccessManager to conserve resources when polling.
-        // Each instance creates a worker thread, so sharing them ensures that
-        // we are not spamming a new thread for every single polling attempt.
-        //
-        // Since QThread inherit the priority of the current thread, this also
-        // ensures that the NAM's worker thread will inherit our lower priority.
-        QNetworkAccessManager nam;
-
-        // Always fetch the applist the first time
-        int pollsSinceLastAppListFetch = POLLS_PER_APPLIST_FETCH;
-        while (!isInterruptionRequested()) {
-            bool stateChanged = false;
-            bool online = false;
-            bool wasOnline = m_Computer->state == NvComputer::CS_ONLINE;
-            for (int i = 0; i < (wasOnline ? TRIES_BEFORE_OFFLINING : 1) && !online; i++) {
-                for (auto& address : m_Computer->uniqueAddresses()) {
-                    if (isInterruptionRequested()) {
-                        return;
-                    }
+        bool stateChanged = false;
+        bool online = false;
+        bool wasOnline = m_Computer->state == NvComputer::CS_ONLINE;
+        for (int i = 0; i < (wasOnline ? TRIES_BEFORE_OFFLINING : 1) && !online; i++) {
+            // The active address is first, so it gets a head start in the race
+            QVector<NvAddress> candidates = m_Computer->uniqueAddresses();
+
+            // While the host stays online, poll the address that answered last time
+            // directly. We only race the others when it stops answering.
+            NvAddress activeAddress = m_Computer->activeAddress;
+            if (wasOnline && candidates.removeOne(activeAddress)) {
+                if (isInterruptionRequested()) {
+                    return false;
+                }
 
-                    if (tryPollComputer(&nam, address, stateChanged)) {
-                        if (!wasOnline) {
-                            qInfo() << m_Computer->name << "is now online at" << m_Computer->activeAddress.toString();
-                        }
-                        online = true;
-                        break;
-                    }
+                if (tryPollComputer(nam, activeAddress, stateChanged)) {
+                    online = true;
+                    break;
                 }
             }
 
-            // Check if we failed after all retry attempts
-            // Note: we don't need to acquire the read lock here,
-            // because we're on the writing thread.
-            if (!online && m_Computer->state != NvComputer::CS_OFFLINE) {
-                qInfo() << m_Computer->name << "is now offline";
-                m_Computer->state = NvComputer::CS_OFFLINE;
-                stateChanged = true;
-            }
-
-            // Grab the applist if it's empty or it's been long enough that we need to refresh
-            pollsSinceLastAppListFetch++;
-            if (m_Computer->state == NvComputer::CS_ONLINE &&
-                    m_Computer->pairState == NvComputer::PS_PAIRED &&
-                    (m_Computer->appList.isEmpty() || pollsSinceLastAppListFetch >= POLLS_PER_APPLIST_FETCH)) {
-                // Notify prior to the app list poll since it may take a while, and we don't
-                // want to delay onlining of a machine, especially if we already have a cached list.
-                if (stateChanged) {
-                    emit computerStateChanged(m_Computer);
-                    stateChanged = false;
+            while (!candidates.isEmpty()) {
+                if (isInterruptionRequested()) {
+                    return false;
+                }
+
+                NvAddress address = raceAddresses(candidates);
+                if (address.isNull()) {
+                    break;
                 }
 
-                if (updateAppList(&nam, stateChanged)) {
-                    pollsSinceLastAppListFetch = 0;
+                if (tryPollComputer(nam, address, stateChanged)) {
+                    if (!wasOnline) {
+                        qInfo() << m_Computer->name << "is now online at" << m_Computer->activeAddress.toString();
+                    }
+                    online = true;
+                    break;
                 }
             }
+        }
+
+        // Check if we failed after all retry attempts
+        // Note: we don't need to acquire the read lock here,
+        // because we're on the writing thread.
+        if (!online && m_Computer->state != NvComputer::CS_OFFLINE) {
+            qInfo() << m_Computer->name << "is now offline";
+            m_Computer->state = NvComputer::CS_OFFLINE;
+            stateChanged = true;
+        }
 
+        // Grab the applist if it's empty or it's been long enough that we need to refresh
+        m_Entry->m_PollsSinceLastAppListFetch++;
+        if (m_Computer->state == NvComputer::CS_ONLINE &&
+                m_Computer->pairState == NvComputer::PS_PAIRED &&
+                (m_Computer->appList.isEmpty() || m_Entry->m_PollsSinceLastAppListFetch >= POLLS_PER_APPLIST_FETCH)) {
+            // Notify prior to the app list poll since it may take a while, and we don't
+            // want to delay onlining of a machine, especially if we already have a cached list.
             if (stateChanged) {
-                // Tell anyone listening that we've changed state
                 emit computerStateChanged(m_Computer);
+                stateChanged = false;
             }
 
-            // Wait a bit to poll again, but do it in 100 ms chunks
-            // so we can be interrupted reasonably quickly.
-            // FIXME: QWaitCondition would be better.
-            for (int i = 0; i < 30 && !isInterruptionRequested(); i++) {
-                QThread::msleep(100);
+            if (updateAppList(nam, stateChanged)) {
+                m_Entry->m_PollsSinceLastAppListFetch = 0;
             }
         }
+
+        if (stateChanged) {
+            // Tell anyone listening that we've changed state
+            emit computerStateChanged(m_Computer);
+        }
+
+        return online;
     }
 
-signals:
-   void computerStateChanged(NvComputer* computer);
+    void run() override
+    {
+        // Reduce the power and performance impact of our
+        // computer status polling while it's running.
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+        QThread::currentThread()->setServiceLevel(QThread::QualityOfService::Eco);
+#endif
 
-private:
+        // Since QThread inherit the priority of the current thread, this also
+        // ensures that the NAM's worker thread will inherit our lower priority.
+        if (!s_PollNams.hasLocalData()) {
+            s_PollNams.setLocalData(new QNetworkAccessManager());
+        }
+
+        // Start over on the first poll after polling was reactivated. Only one
+        // poll runs at a time, so no other thread can be using this state.
+        if (m_Entry->m_StateGeneration != m_Generation) {
+            m_Entry->m_StateGeneration = m_Generation;
+            m_Entry->m_OfflinePolls = 0;
+
+            // Always fetch and parse the applist the first time
+            m_Entry->m_PollsSinceLastAppListFetch = POLLS_PER_APPLIST_FETCH;
+            m_Entry->m_AppListResponseHash.clear();
+        }
+
+        QElapsedTimer pollTimer;
+        pollTimer.start();
+
+        int intervalMs = POLL_INTERVAL_MS;
+        bool backedOff = false;
+        if (!isInterruptionRequested()) {
+            bool online = pollComputer(s_PollNams.localData());
+            m_ComputerManager->recordPoll(pollTimer.elapsed(), online);
+
+            if (online) {
+                m_Entry->m_OfflinePolls = 0;
+                m_Entry->endWakePolling();
+            }
+            else if (m_Entry->isWakePolling()) {
+                // Keep a close eye on hosts that we're waking up
+                intervalMs = WAKE_POLL_INTERVAL_MS;
+            }
+            else if (!isInterruptionRequested()) {
+                // Back off exponentially while the host is offline
+                int backoff = qMin(m_Entry->m_OfflinePolls++, 3);
+                intervalMs = qMin(POLL_INTERVAL_MS << backoff, MAX_OFFLINE_POLL_INTERVAL_MS);
+                backedOff = true;
+            }
+        }
+
+        int jitterMs = intervalMs * POLL_JITTER_PERCENT / 100;
+        intervalMs += QRandomGenerator::global()->bounded(-jitterMs, jitterMs + 1);
+
+        // m_Entry and m_Computer may be freed after this call
+        m_Entry->endPoll(m_Generation, intervalMs, backedOff);
+
+        emit pollCompleted();
+    }
+
+    ComputerManager* m_ComputerManager;
     NvComputer* m_Computer;
+    ComputerPollingEntry* m_Entry;
+    int m_Generation;
 };
 
 ComputerManager::ComputerManager(StreamingPreferences* prefs)
     : m_Prefs(prefs),
       m_PollingRef(0),
+      m_PollCount(0),
+      m_OfflinePollCount(0),
+      m_TotalPollTimeMs(0),
+      m_MaxPollTimeMs(0),
       m_MdnsBrowser(nullptr),
+      m_ProbedMdnsCache(false),
+      m_LoggedFirstOnlineHost(false),
       m_CompatFetcher(nullptr),
-      m_NeedsDelayedFlush(false)
+      m_NeedsDelayedFlush(false),
+      m_NeedsMdnsCacheFlush(false)
 {
-    QSettings settings;
-
-    // If there's a hosts backup copy, we must have failed to commit
-    // a previous update before exiting. Restore the backup now.
-    int hosts = settings.beginReadArray(SER_HOSTS_BACKUP);
-    if (hosts == 0) {
-        // If there's no host backup, read from the primary location.
-        settings.endArray();
-        hosts = settings.beginReadArray(SER_HOSTS);
-    }
-
-    // Inflate our hosts from QSettings
-    for (int i = 0; i < hosts; i++) {
-        settings.setArrayIndex(i);
-        NvComputer* computer = new NvComputer(settings);
+    m_StartupTimer.start();
+
+    // Only the small host records are read at startup. App
+    // lists are loaded from the store when they're first needed.
+    // Hosts added after an incomplete migration only exist here,
+    // so the store is read even if the migration must be retried.
+    const QVector<NvComputer*> hosts = m_HostStore.loadHosts();
+    for (NvComputer* computer : hosts) {
         m_KnownHosts[computer->uuid] = computer;
         m_LastSerializedHosts[computer->uuid] = *computer;
     }
-    settings.endArray();
+
+    if (!m_HostStore.isComplete()) {
+        migrateHostsFromSettings();
+    }
+
+    loadMdnsCache();
 
     // Fetch latest compatibility data asynchronously
     m_CompatFetcher.start();
 
+    // All hosts are polled by small pools of threads. The poll timer
+    // is armed for whichever host is due to be polled next.
+    m_PollThreadPool.setMaxThreadCount(MAX_POLL_THREADS);
+    m_OfflinePollThreadPool.setMaxThreadCount(MAX_OFFLINE_POLL_THREADS);
+    m_PollTimer.setSingleShot(true);
+    connect(&m_PollTimer, &QTimer::timeout, this, &ComputerManager::schedulePolls);
+
+    // Periodically log polling load when POLL_STATS_INTERVAL is set (in seconds)
+    int pollStatsIntervalSecs;
+    if (Utils::getEnvironmentVariableOverride("POLL_STATS_INTERVAL", &pollStatsIntervalSecs) && pollStatsIntervalSecs > 0) {
+        connect(&m_PollStatsTimer, &QTimer::timeout, this, &ComputerManager::logPollStats);
+        m_PollStatsTimer.start(pollStatsIntervalSecs * 1000);
+    }
+
     // Start the delayed flush thread to handle saveHosts() calls
     m_DelayedFlushThread = new DelayedFlushThread(this);
     m_DelayedFlushThread->start();
@@ -235,19 +487,109 @@ ComputerManager::~ComputerManager()
         entry->interrupt();
     }
 
-    // Delete all polling entries (and associated threads)
+    // Delete all polling entries (waiting for any polls in progress)
     for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
         delete entry;
     }
 
+    // Wait for the poll tasks to finish signalling completion
+    m_PollThreadPool.waitForDone();
+    m_OfflinePollThreadPool.waitForDone();
+
     // Destroy all NvComputer objects now that polling is halted
     for (NvComputer* computer : std::as_const(m_KnownHosts)) {
         delete computer;
     }
 }
 
+void ComputerManager::migrateHostsFromSettings()
+{
+    QSettings settings;
+
+    // If there's a hosts backup copy, we must have failed to commit
+    // a previous update before exiting. Restore the backup now.
+    int hosts = settings.beginReadArray(SER_HOSTS_BACKUP);
+    if (hosts == 0) {
+        // If there's no host backup, read from the primary location.
+        settings.endArray();
+        hosts = settings.beginReadArray(SER_HOSTS);
+    }
+
+    // Inflate our hosts from QSettings
+    bool migrated = true;
+    for (int i = 0; i < hosts; i++) {
+        settings.setArrayIndex(i);
+        NvComputer* computer = new NvComputer(settings);
+
+        // A host already in the store was migrated by an earlier attempt that didn't
+        // complete. Its record is at least as new as QSettings, so we keep it and only
+        // fill in the app list if that attempt failed before writing it.
+        if (m_KnownHosts.contains(computer->uuid)) {
+            if (!computer->appList.isEmpty() &&
+                    m_HostStore.loadAppList(computer->uuid).isEmpty() &&
+                    !m_HostStore.saveAppList(*computer)) {
+                migrated = false;
+            }
+            delete computer;
+            continue;
+        }
+
+        m_KnownHosts[computer->uuid] = computer;
+        m_LastSerializedHosts[computer->uuid] = *computer;
+
+        if (!m_HostStore.saveHost(*computer) ||
+                (!computer->appList.isEmpty() && !m_HostStore.saveAppList(*computer))) {
+            migrated = false;
+        }
+    }
+    settings.endArray();
+
+    // QSettings is kept until the marker is written, so we try again next time
+    if (!migrated || !m_HostStore.markComplete()) {
+        qWarning() << "Failed to migrate hosts to the host store";
+        return;
+    }
+    else if (hosts == 0) {
+        return;
+    }
+
+    // The store is authoritative from now on
+    settings.remove(SER_HOSTS);
+    settings.remove(SER_HOSTS_BACKUP);
+    qInfo() << "Migrated" << hosts << "hosts to the host store";
+}
+
+void ComputerManager::loadAppList(NvComputer* computer)
+{
+    {
+        QReadLocker computerLock(&computer->lock);
+        if (computer->appListLoaded) {
+            return;
+        }
+    }
+
+    QJsonArray appList = m_HostStore.loadAppList(computer->uuid);
+
+    // Update the last serialized copy along with the host, so
+    // loading the app list doesn't cause it to be written back.
+    QMutexLocker lock(&m_DelayedFlushMutex);
+    if (computer->setPersistedAppList(appList)) {
+        QReadLocker computerLock(&computer->lock);
+        auto it = m_LastSerializedHosts.find(computer->uuid);
+        if (it != m_LastSerializedHosts.end()) {
+            it->appList = computer->appList;
+        }
+    }
+}
+
 void DelayedFlushThread::run() {
     for (;;) {
+        QVector<NvComputer> changedHosts;
+        QVector<bool> changedAppLists;
+        QStringList deletedHosts;
+        QJsonArray mdnsCache;
+        bool mdnsCacheChanged;
+
         // Wait for a delayed flush request or an interruption
         {
             QMutexLocker locker(&m_ComputerManager->m_DelayedFlushMutex);
@@ -266,47 +608,62 @@ void DelayedFlushThread::run() {
             // Reset the delayed flush flag to ensure any racing saveHosts() call will set it again
             m_ComputerManager->m_NeedsDelayedFlush = false;
 
-            // Update the last serialized hosts map under the delayed flush mutex
-            m_ComputerManager->m_LastSerializedHosts.clear();
+            // Take the latest mDNS cache snapshot, if one was queued
+            mdnsCacheChanged = m_ComputerManager->m_NeedsMdnsCacheFlush;
+            if (mdnsCacheChanged) {
+                mdnsCache = m_ComputerManager->m_PendingMdnsCache;
+                m_ComputerManager->m_PendingMdnsCache = QJsonArray();
+                m_ComputerManager->m_NeedsMdnsCacheFlush = false;
+            }
+
+            // Find the hosts that changed since the last flush and update the
+            // last serialized hosts map under the delayed flush mutex
+            QHash<QString, NvComputer>& lastSerializedHosts = m_ComputerManager->m_LastSerializedHosts;
+            QReadLocker lock(&m_ComputerManager->m_Lock);
             for (const NvComputer* computer : std::as_const(m_ComputerManager->m_KnownHosts)) {
+                QReadLocker computerLock(&computer->lock);
+
+                auto it = lastSerializedHosts.find(computer->uuid);
+                if (it != lastSerializedHosts.end() && it->isEqualSerialized(*computer)) {
+                    continue;
+                }
+
                 // Copy the current state of the NvComputer to allow us to check later if we need
                 // to serialize it again when attribute updates occur.
-                QReadLocker computerLock(&computer->lock);
-                m_ComputerManager->m_LastSerializedHosts[computer->uuid] = *computer;
+                changedAppLists.append(it == lastSerializedHosts.end() || it->appList != computer->appList);
+                changedHosts.append(*computer);
+                lastSerializedHosts[computer->uuid] = *computer;
             }
-        }
-
-        // Perform the flush
-        {
-            QSettings settings;
 
-            // First, write to the backup location
-            settings.beginWriteArray(SER_HOSTS_BACKUP);
-            {
-                QReadLocker lock(&m_ComputerManager->m_Lock);
-                int i = 0;
-                for (const NvComputer* computer : std::as_const(m_ComputerManager->m_KnownHosts)) {
-                    settings.setArrayIndex(i++);
-                    computer->serialize(settings, false);
+            for (auto it = lastSerializedHosts.begin(); it != lastSerializedHosts.end();) {
+                if (!m_ComputerManager->m_KnownHosts.contains(it.key())) {
+                    deletedHosts.append(it.key());
+                    it = lastSerializedHosts.erase(it);
+                }
+                else {
+                    it++;
                 }
             }
-            settings.endArray();
+        }
 
-            // Next, write to the primary location
-            settings.remove(SER_HOSTS);
-            settings.beginWriteArray(SER_HOSTS);
-            {
-                QReadLocker lock(&m_ComputerManager->m_Lock);
-                int i = 0;
-                for (const NvComputer* computer : std::as_const(m_ComputerManager->m_KnownHosts)) {
-                    settings.setArrayIndex(i++);
-                    computer->serialize(settings, true);
-                }
+        // Perform the flush, only rewriting the records that changed
+        for (int i = 0; i < changedHosts.count(); i++) {
+            const NvComputer& computer = changedHosts.at(i);
+
+            m_ComputerManager->m_HostStore.saveHost(computer);
+
+            // Avoid deleting an existing applist if we couldn't get one
+            if (changedAppLists.at(i) && !computer.appList.isEmpty()) {
+                m_ComputerManager->m_HostStore.saveAppList(computer);
             }
-            settings.endArray();
+        }
 
-            // Finally, delete the backup copy
-            settings.remove(SER_HOSTS_BACKUP);
+        for (const QString& uuid : std::as_const(deletedHosts)) {
+            m_ComputerManager->m_HostStore.deleteHost(uuid);
+        }
+
+        if (mdnsCacheChanged) {
+            m_ComputerManager->m_HostStore.saveMdnsCache(mdnsCache);
         }
     }
 }
@@ -315,14 +672,14 @@ void ComputerManager::saveHosts()
 {
     Q_ASSERT(m_DelayedFlushThread != nullptr && m_DelayedFlushThread->isRunning());
 
-    // Punt to a worker thread because QSettings on macOS can take ages (> 500 ms)
-    // to persist our host list to disk (especially when a host has a bunch of apps).
+    // Punt to a worker thread to keep disk I/O off the UI thread. Slow storage
+    // like SD cards can take a long time to persist a host with a bunch of apps.
     QMutexLocker locker(&m_DelayedFlushMutex);
     m_NeedsDelayedFlush = true;
     m_DelayedFlushCondition.wakeOne();
 }
 
-QHostAddress ComputerManager::getBestGlobalAddressV6(QVector<QHostAddress> &addresses)
+QHostAddress ComputerManager::getBestGlobalAddressV6(const QVector<QHostAddress> &addresses)
 {
     for (const QHostAddress& address : addresses) {
         if (address.protocol() == QAbstractSocket::IPv6Protocol) {
@@ -371,20 +728,19 @@ void ComputerManager::startPolling()
         m_MdnsServer.reset(new QMdnsEngine::Server());
         m_MdnsBrowser = new QMdnsEngine::Browser(m_MdnsServer.data(), "_nvstream._tcp.local.");
         connect(m_MdnsBrowser, &QMdnsEngine::Browser::serviceAdded,
-                this, [this](const QMdnsEngine::Service& service) {
-            qInfo() << "Discovered mDNS host:" << service.hostname();
+                this, &ComputerManager::handleMdnsServiceDiscovered);
 
-            MdnsPendingComputer* pendingComputer = new MdnsPendingComputer(m_MdnsServer, service);
-            connect(pendingComputer, &MdnsPendingComputer::resolvedHost,
-                    this, &ComputerManager::handleMdnsServiceResolved);
-            m_PendingResolution.append(pendingComputer);
-        });
+        // Probe the hosts we found last time without waiting for mDNS
+        if (!m_ProbedMdnsCache) {
+            m_ProbedMdnsCache = true;
+            probeMdnsCachedHosts();
+        }
     }
     else {
         qWarning() << "mDNS is disabled by user preference";
     }
 
-    // Start polling threads for each known host
+    // Start polling each known host
     QMapIterator<QString, NvComputer*> i(m_KnownHosts);
     while (i.hasNext()) {
         i.next();
@@ -409,30 +765,164 @@ void ComputerManager::startPollingComputer(NvComputer* computer)
     }
 
     if (!pollingEntry->isActive()) {
-        PcMonitorThread* thread = new PcMonitorThread(computer);
-        connect(thread, &PcMonitorThread::computerStateChanged,
-                this, &ComputerManager::handleComputerStateChanged);
-        pollingEntry->setActiveThread(thread);
-        thread->start();
+        pollingEntry->activate();
+
+        // We may be called on a worker thread, so let the scheduler
+        // pick this up on the main thread where the poll timer lives.
+        QMetaObject::invokeMethod(this, "schedulePolls", Qt::QueuedConnection);
+    }
+}
+
+void ComputerManager::schedulePolls()
+{
+    QReadLocker lock(&m_Lock);
+
+    qint64 nextPollMs = -1;
+    for (auto i = m_PollEntries.constBegin(); i != m_PollEntries.constEnd(); i++) {
+        ComputerPollingEntry* entry = i.value();
+
+        int generation = entry->beginPoll();
+        if (generation >= 0) {
+            NvComputer* computer = m_KnownHosts.value(i.key());
+            Q_ASSERT(computer != nullptr);
+
+            PcMonitorTask* task = new PcMonitorTask(this, computer, entry, generation);
+            connect(task, &PcMonitorTask::computerStateChanged,
+                    this, &ComputerManager::handleComputerStateChanged);
+            connect(task, &PcMonitorTask::pollCompleted,
+                    this, &ComputerManager::schedulePolls);
+            if (entry->isBackedOff()) {
+                m_OfflinePollThreadPool.start(task);
+            }
+            else {
+                m_PollThreadPool.start(task);
+            }
+            continue;
+        }
+
+        qint64 remainingMs = entry->remainingTimeUntilPoll();
+        if (remainingMs >= 0 && (nextPollMs < 0 || remainingMs < nextPollMs)) {
+            nextPollMs = remainingMs;
+        }
+    }
+
+    if (nextPollMs >= 0) {
+        m_PollTimer.start((int)nextPollMs);
+    }
+    else {
+        m_PollTimer.stop();
     }
 }
 
+void ComputerManager::recordPoll(qint64 durationMs, bool online)
+{
+    QMutexLocker locker(&m_PollStatsLock);
+
+    m_PollCount++;
+    if (!online) {
+        m_OfflinePollCount++;
+    }
+    m_TotalPollTimeMs += durationMs;
+    m_MaxPollTimeMs = qMax(m_MaxPollTimeMs, durationMs);
+}
+
+void ComputerManager::logPollStats()
+{
+    int pollCount, offlinePollCount;
+    qint64 totalPollTimeMs, maxPollTimeMs;
+
+    {
+        QMutexLocker locker(&m_PollStatsLock);
+
+        pollCount = m_PollCount;
+        offlinePollCount = m_OfflinePollCount;
+        totalPollTimeMs = m_TotalPollTimeMs;
+        maxPollTimeMs = m_MaxPollTimeMs;
+
+        m_PollCount = m_OfflinePollCount = 0;
+        m_TotalPollTimeMs = m_MaxPollTimeMs = 0;
+    }
+
+    int hostCount;
+    {
+        QReadLocker lock(&m_Lock);
+        hostCount = m_KnownHosts.count();
+    }
+
+    qInfo().nospace() << "Polling stats: " << hostCount << " hosts, "
+                      << pollCount << " polls (" << offlinePollCount << " offline), "
+                      << "avg " << (pollCount > 0 ? totalPollTimeMs / pollCount : 0) << " ms, "
+                      << "max " << maxPollTimeMs << " ms, "
+                      << m_PollThreadPool.activeThreadCount() << "/" << m_PollThreadPool.maxThreadCount() << " poll threads busy, "
+                      << m_OfflinePollThreadPool.activeThreadCount() << "/" << m_OfflinePollThreadPool.maxThreadCount() << " offline poll threads busy, "
+                      << m_PendingResolution.count() << " pending mDNS resolutions";
+}
+
+void ComputerManager::handleMdnsServiceDiscovered(const QMdnsEngine::Service& service)
+{
+    // Coalesce repeated announcements while we're still resolving the host
+    for (MdnsPendingComputer* pendingComputer : std::as_const(m_PendingResolution)) {
+        if (pendingComputer->hostname() == service.hostname()) {
+            return;
+        }
+    }
+
+    // Skip resolution if our cached addresses haven't expired yet
+    auto it = m_MdnsCache.constFind(service.hostname());
+    if (it != m_MdnsCache.constEnd() && it->port == service.port() &&
+            it->expiration > QDateTime::currentDateTimeUtc()) {
+        qInfo() << "Discovered mDNS host:" << service.hostname() << "(cached)";
+        addMdnsHost(service.hostname(), it->port, it->addresses);
+        return;
+    }
+
+    qInfo() << "Discovered mDNS host:" << service.hostname();
+
+    MdnsPendingComputer* pendingComputer = new MdnsPendingComputer(m_MdnsServer, service);
+    connect(pendingComputer, &MdnsPendingComputer::resolvedHost,
+            this, &ComputerManager::handleMdnsServiceResolved);
+    connect(pendingComputer, &MdnsPendingComputer::resolveFailed,
+            this, &ComputerManager::handleMdnsServiceResolveFailed);
+    m_PendingResolution.append(pendingComputer);
+}
+
 void ComputerManager::handleMdnsServiceResolved(MdnsPendingComputer* computer,
                                                 QVector<QHostAddress>& addresses)
+{
+    MdnsCachedHost& cachedHost = m_MdnsCache[computer->hostname()];
+    cachedHost.addresses = addresses;
+    cachedHost.port = computer->port();
+    cachedHost.expiration = QDateTime::currentDateTimeUtc().addSecs(MDNS_HOST_TTL_SECS);
+    saveMdnsCache();
+
+    addMdnsHost(computer->hostname(), computer->port(), addresses);
+
+    m_PendingResolution.removeOne(computer);
+    computer->deleteLater();
+}
+
+void ComputerManager::handleMdnsServiceResolveFailed(MdnsPendingComputer* computer)
+{
+    // Allow the next announcement from this host to try again
+    m_PendingResolution.removeOne(computer);
+    computer->deleteLater();
+}
+
+void ComputerManager::addMdnsHost(QString hostname, uint16_t port, const QVector<QHostAddress>& addresses)
 {
     QHostAddress v6Global = getBestGlobalAddressV6(addresses);
     bool added = false;
 
     // Add the host using the IPv4 address
-    for (const QHostAddress& address : std::as_const(addresses)) {
+    for (const QHostAddress& address : addresses) {
         if (address.protocol() == QAbstractSocket::IPv4Protocol) {
             // NB: We don't just call addNewHost() here with v6Global because the IPv6
             // address may not be reachable (if the user hasn't installed the IPv6 helper yet
             // or if this host lacks outbound IPv6 capability). We want to add IPv6 even if
             // it's not currently reachable.
-            addNewHost(NvAddress(address, computer->port()),
-                       true, computer->hostname(),
-                       NvAddress(v6Global, computer->port()));
+            addNewHost(NvAddress(address, port),
+                       true, hostname,
+                       NvAddress(v6Global, port));
             added = true;
             break;
         }
@@ -440,23 +930,112 @@ void ComputerManager::handleMdnsServiceResolved(MdnsPendingComputer* computer,
 
     if (!added) {
         // If we get here, there wasn't an IPv4 address so we'll do it v6-only
-        for (const QHostAddress& address : std::as_const(addresses)) {
+        for (const QHostAddress& address : addresses) {
             if (address.protocol() == QAbstractSocket::IPv6Protocol) {
                 // Use a link-local or site-local address for the "local address"
                 if (address.isInSubnet(QHostAddress("fe80::"), 10) ||
                         address.isInSubnet(QHostAddress("fec0::"), 10) ||
                         address.isInSubnet(QHostAddress("fc00::"), 7)) {
-                    addNewHost(NvAddress(address, computer->port()),
-                               true, computer->hostname(),
-                               NvAddress(v6Global, computer->port()));
+                    addNewHost(NvAddress(address, port),
+                               true, hostname,
+                               NvAddress(v6Global, port));
                     break;
                 }
             }
         }
     }
+}
 
-    m_PendingResolution.removeOne(computer);
-    computer->deleteLater();
+void ComputerManager::loadMdnsCache()
+{
+    const QDateTime oldestExpiration = QDateTime::currentDateTimeUtc().addSecs(-MDNS_CACHE_RETENTION_SECS);
+    const QJsonArray cache = m_HostStore.loadMdnsCache();
+    for (const QJsonValue& value : cache) {
+        QJsonObject entry = value.toObject();
+        QByteArray hostname = entry.value(SER_MDNS_HOSTNAME).toString().toUtf8();
+
+        MdnsCachedHost cachedHost;
+        const QJsonArray addresses = entry.value(SER_MDNS_ADDRESSES).toArray();
+        for (const QJsonValue& address : addresses) {
+            QHostAddress hostAddress(address.toString());
+            if (!hostAddress.isNull()) {
+                cachedHost.addresses.append(hostAddress);
+            }
+        }
+        cachedHost.port = (uint16_t)entry.value(SER_MDNS_PORT).toInt(DEFAULT_HTTP_PORT);
+        cachedHost.expiration = QDateTime::fromSecsSinceEpoch((qint64)entry.value(SER_MDNS_EXPIRATION).toDouble());
+
+        if (!hostname.isEmpty() && !cachedHost.addresses.isEmpty() &&
+                cachedHost.expiration >= oldestExpiration) {
+            m_MdnsCache.insert(hostname, cachedHost);
+        }
+    }
+}
+
+void ComputerManager::saveMdnsCache()
+{
+    Q_ASSERT(m_DelayedFlushThread != nullptr && m_DelayedFlushThread->isRunning());
+
+    // Forget hosts that haven't been seen in a long time
+    const QDateTime oldestExpiration = QDateTime::currentDateTimeUtc().addSecs(-MDNS_CACHE_RETENTION_SECS);
+    for (auto it = m_MdnsCache.begin(); it != m_MdnsCache.end();) {
+        if (it->expiration < oldestExpiration) {
+            it = m_MdnsCache.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+
+    QJsonArray cache;
+    for (auto it = m_MdnsCache.constBegin(); it != m_MdnsCache.constEnd(); it++) {
+        QJsonArray addresses;
+        for (const QHostAddress& address : it->addresses) {
+            addresses.append(address.toString());
+        }
+
+        QJsonObject entry;
+        entry.insert(SER_MDNS_HOSTNAME, QString::fromUtf8(it.key()));
+        entry.insert(SER_MDNS_ADDRESSES, addresses);
+        entry.insert(SER_MDNS_PORT, (int)it->port);
+        entry.insert(SER_MDNS_EXPIRATION, (double)it->expiration.toSecsSinceEpoch());
+        cache.append(entry);
+    }
+
+    // Hand the snapshot to the delayed flush thread to keep disk I/O off the UI thread
+    QMutexLocker locker(&m_DelayedFlushMutex);
+    m_PendingMdnsCache = cache;
+    m_NeedsMdnsCacheFlush = true;
+    m_NeedsDelayedFlush = true;
+    m_DelayedFlushCondition.wakeOne();
+}
+
+// Must hold m_Lock
+void ComputerManager::probeMdnsCachedHosts()
+{
+    // Hosts that we already know at these addresses are being polled anyway
+    QSet<QString> knownAddresses;
+    for (const NvComputer* computer : std::as_const(m_KnownHosts)) {
+        const QVector<NvAddress> addresses = computer->uniqueAddresses();
+        for (const NvAddress& address : addresses) {
+            knownAddresses.insert(QHostAddress(address.address()).toString());
+        }
+    }
+
+    for (auto it = m_MdnsCache.constBegin(); it != m_MdnsCache.constEnd(); it++) {
+        bool known = false;
+        for (const QHostAddress& address : it->addresses) {
+            if (knownAddresses.contains(address.toString())) {
+                known = true;
+                break;
+            }
+        }
+
+        if (!known) {
+            qInfo() << "Probing cached mDNS host:" << it.key();
+            addMdnsHost(it.key(), it->port, it->addresses);
+        }
+    }
 }
 
 void ComputerManager::saveHost(NvComputer *computer)
@@ -465,7 +1044,7 @@ void ComputerManager::saveHost(NvComputer *computer)
     QMutexLocker lock(&m_DelayedFlushMutex);
     QReadLocker computerLock(&computer->lock);
     if (!m_LastSerializedHosts.value(computer->uuid).isEqualSerialized(*computer)) {
-        // Queue a request for a delayed flush to QSettings outside of the lock
+        // Queue a request for a delayed flush to the host store outside of the lock
         computerLock.unlock();
         lock.unlock();
         saveHosts();
@@ -474,6 +1053,11 @@ void ComputerManager::saveHost(NvComputer *computer)
 
 void ComputerManager::handleComputerStateChanged(NvComputer* computer)
 {
+    if (!m_LoggedFirstOnlineHost && computer->state == NvComputer::CS_ONLINE) {
+        m_LoggedFirstOnlineHost = true;
+        qInfo() << "First host online after" << m_StartupTimer.elapsed() << "ms:" << computer->name;
+    }
+
     emit computerStateChanged(computer);
 
     if (computer->pendingQuit && computer->currentGameId == 0) {
@@ -521,14 +1105,14 @@ public:
         // Persist the new host list with this computer deleted
         m_ComputerManager->saveHosts();
 
-        // Delete the polling entry first. This will stop all polling threads too.
+        // Delete the polling entry first. This will wait for any poll in progress.
         delete pollingEntry;
 
         // Delete cached box art
         BoxArtManager::deleteBoxArt(m_Computer);
 
         // Finally, delete the computer itself. This must be done
-        // last because the polling thread might be using it.
+        // last because a poll in progress might be using it.
         delete m_Computer;
     }
 
@@ -540,7 +1124,7 @@ private:
 void ComputerManager::deleteHost(NvComputer* computer)
 {
     // Punt to a worker thread to avoid stalling the
-    // UI while waiting for the polling thread to die
+    // UI while waiting for a poll in progress to finish
     QThreadPool::globalInstance()->start(new DeferredHostDeletionTask(this, computer));
 }
 
@@ -563,12 +1147,73 @@ void ComputerManager::clientSideAttributeUpdated(NvComputer* computer)
     handleComputerStateChanged(computer);
 }
 
+class DeferredWakeHostTask : public QRunnable
+{
+public:
+    DeferredWakeHostTask(ComputerManager* cm, const QString& uuid)
+        : m_ComputerManager(cm),
+          m_Uuid(uuid) {}
+
+    void run()
+    {
+        NvComputer computer;
+
+        // The host may be deleted before this task runs, so we wake a copy
+        // rather than holding m_Lock while resolving its addresses.
+        {
+            QReadLocker lock(&m_ComputerManager->m_Lock);
+
+            NvComputer* knownComputer = m_ComputerManager->m_KnownHosts.value(m_Uuid);
+            if (knownComputer == nullptr) {
+                return;
+            }
+
+            QReadLocker computerLock(&knownComputer->lock);
+            computer = *knownComputer;
+        }
+
+        if (computer.wake()) {
+            m_ComputerManager->beginWakePolling(m_Uuid);
+        }
+    }
+
+private:
+    ComputerManager* m_ComputerManager;
+    QString m_Uuid;
+};
+
+void ComputerManager::wakeHost(NvComputer* computer)
+{
+    // Punt to a worker thread because resolving host names may block
+    QThreadPool::globalInstance()->start(new DeferredWakeHostTask(this, computer->uuid));
+}
+
+void ComputerManager::beginWakePolling(const QString& uuid)
+{
+    QWriteLocker lock(&m_Lock);
+
+    // The host may have been deleted while we were waking it
+    if (!m_KnownHosts.contains(uuid)) {
+        return;
+    }
+
+    // Create the polling entry if polling hasn't started yet, so the
+    // wake polling takes effect as soon as it does.
+    ComputerPollingEntry*& pollingEntry = m_PollEntries[uuid];
+    if (pollingEntry == nullptr) {
+        pollingEntry = new ComputerPollingEntry();
+    }
+
+    pollingEntry->beginWakePolling(WAKE_POLL_DURATION_MS);
+    QMetaObject::invokeMethod(this, "schedulePolls", Qt::QueuedConnection);
+}
+
 void ComputerManager::handleAboutToQuit()
 {
     QReadLocker lock(&m_Lock);
 
-    // Interrupt polling threads immediately, so they
-    // avoid making additional requests while quitting
+    // Interrupt polling immediately, so we avoid
+    // making additional requests while quitting
     for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
         entry->interrupt();
     }
@@ -720,7 +1365,7 @@ void ComputerManager::stopPollingAsync()
     m_MdnsBrowser = nullptr;
     m_MdnsServer.reset();
 
-    // Interrupt all threads, but don't wait for them to terminate
+    // Interrupt all polling, but don't wait for polls in progress to finish
     for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
         entry->interrupt();
     }
@@ -774,13 +1419,13 @@ private:
         m_AboutToQuit = true;
     }
 
-    QString fetchServerInfo(NvHTTP& http)
+    NvServerInfo fetchServerInfo(NvHTTP& http)
     {
-        QString serverInfo;
+        NvServerInfo serverInfo;
 
         // Do nothing if we're quitting
         if (m_AboutToQuit) {
-            return QString();
+            return NvServerInfo();
         }
 
         try {
@@ -819,7 +1464,7 @@ private:
 
                 emit computerAddCompleted(false, portTestResult != 0 && portTestResult != ML_TEST_RESULT_INCONCLUSIVE);
             }
-            return QString();
+            return NvServerInfo();
         }
     }
 
@@ -841,13 +1486,13 @@ private:
         }
 
         // Perform initial serverinfo fetch over HTTP since we don't know which cert to use
-        QString serverInfo = fetchServerInfo(http);
-        if (serverInfo.isEmpty() && !m_MdnsIpv6Address.isNull()) {
+        NvServerInfo serverInfo = fetchServerInfo(http);
+        if (!serverInfo.isValid() && !m_MdnsIpv6Address.isNull()) {
             // Retry using the global IPv6 address if the IPv4 or link-local IPv6 address fails
             http.setAddress(m_MdnsIpv6Address);
             serverInfo = fetchServerInfo(http);
         }
-        if (serverInfo.isEmpty()) {
+        if (!serverInfo.isValid()) {
             return;
         }
 
@@ -868,7 +1513,7 @@ private:
         if (existingComputer != nullptr) {
             Q_ASSERT(http.httpsPort() != 0);
             serverInfo = fetchServerInfo(http);
-            if (serverInfo.isEmpty()) {
+            if (!serverInfo.isValid()) {
                 return;
             }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nvcomputer.h"
+#include "hoststore.h"
 #include "settings/streamingpreferences.h"
 #include "settings/compatfetcher.h"
 
@@ -17,6 +18,11 @@
 #include <QTimer>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QThreadPool>
+#include <QDeadlineTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
 
 class ComputerManager;
 
@@ -37,6 +43,11 @@ private:
     ComputerManager* m_ComputerManager;
 };
 
+// The first address to resolve usually has its siblings right behind it,
+// so we wait briefly to collect both the IPv4 and IPv6 addresses.
+#define MDNS_RESOLVE_SETTLE_MS 250
+#define MDNS_RESOLVE_TIMEOUT_MS 2000
+
 class MdnsPendingComputer : public QObject
 {
     Q_OBJECT
@@ -49,6 +60,10 @@ public:
           m_ServerWeak(server),
           m_Resolver(nullptr)
     {
+        m_Timer.setSingleShot(true);
+        connect(&m_Timer, &QTimer::timeout,
+                this, &MdnsPendingComputer::handleResolvedTimeout);
+
         // Start resolving
         resolve();
     }
@@ -58,7 +73,7 @@ public:
         delete m_Resolver;
     }
 
-    QString hostname()
+    QByteArray hostname()
     {
         return m_Hostname;
     }
@@ -80,22 +95,35 @@ private slots:
             else {
                 qWarning() << "Giving up on resolving" << hostname() << "after repeated failures";
                 cleanup();
+                emit resolveFailed(this);
             }
         }
         else {
-            Q_ASSERT(!m_Addresses.isEmpty());
+            // Stop listening for more addresses now that we're done
+            cleanup();
             emit resolvedHost(this, m_Addresses);
         }
     }
 
     void handleResolvedAddress(const QHostAddress& address)
     {
+        if (m_Addresses.contains(address)) {
+            return;
+        }
+
+        if (m_Addresses.isEmpty()) {
+            // Don't wait out the full timeout once the host has answered
+            m_Timer.start(MDNS_RESOLVE_SETTLE_MS);
+        }
+
         m_Addresses.push_back(address);
     }
 
 signals:
     void resolvedHost(MdnsPendingComputer*,QVector<QHostAddress>&);
 
+    void resolveFailed(MdnsPendingComputer*);
+
 private:
     void cleanup()
     {
@@ -122,7 +150,7 @@ private:
         m_Resolver = new QMdnsEngine::Resolver(m_Server.data(), m_Hostname);
         connect(m_Resolver, &QMdnsEngine::Resolver::resolved,
                 this, &MdnsPendingComputer::handleResolvedAddress);
-        QTimer::singleShot(2000, this, &MdnsPendingComputer::handleResolvedTimeout);
+        m_Timer.start(MDNS_RESOLVE_TIMEOUT_MS);
     }
 
     QByteArray m_Hostname;
@@ -130,15 +158,34 @@ private:
     QWeakPointer<QMdnsEngine::Server> m_ServerWeak;
     QSharedPointer<QMdnsEngine::Server> m_Server;
     QMdnsEngine::Resolver* m_Resolver;
+    QTimer m_Timer;
     QVector<QHostAddress> m_Addresses;
     int m_Retries = 10;
 };
 
+// Last known addresses of a host found by mDNS. These are persisted,
+// so hosts can be probed at launch before mDNS has a chance to respond.
+class MdnsCachedHost
+{
+public:
+    QVector<QHostAddress> addresses;
+    uint16_t port;
+    QDateTime expiration;
+};
+
 class ComputerPollingEntry
 {
+    friend class PcMonitorTask;
+
 public:
     ComputerPollingEntry()
-        : m_ActiveThread(nullptr)
+        : m_Active(false),
+          m_InFlight(false),
+          m_BackedOff(false),
+          m_Generation(0),
+          m_StateGeneration(-1),
+          m_OfflinePolls(0),
+          m_PollsSinceLastAppListFetch(0)
     {
 
     }
@@ -147,64 +194,146 @@ public:
     {
         interrupt();
 
-        // interrupt() should have taken care of this
-        Q_ASSERT(m_ActiveThread == nullptr);
-
-        for (QThread* thread : std::as_const(m_InactiveList)) {
-            thread->wait();
-            delete thread;
+        // Wait for any poll in progress to notice the interruption,
+        // since it may still be using the NvComputer object.
+        QMutexLocker locker(&m_Mutex);
+        while (m_InFlight) {
+            m_IdleCondition.wait(&m_Mutex);
         }
     }
 
     bool isActive()
     {
-        cleanInactiveList();
+        QMutexLocker locker(&m_Mutex);
 
-        return m_ActiveThread != nullptr;
+        return m_Active;
     }
 
-    void setActiveThread(QThread* thread)
+    // Schedules a poll as soon as possible if we're not already polling
+    void activate()
     {
-        cleanInactiveList();
-
-        Q_ASSERT(!isActive());
-        m_ActiveThread = thread;
+        QMutexLocker locker(&m_Mutex);
+
+        // The poll state is reset by the first poll of the new generation,
+        // since an interrupted poll may still be using it.
+        if (!m_Active) {
+            m_Active = true;
+            m_BackedOff = false;
+            m_NextPoll = QDeadlineTimer(0);
+        }
     }
 
     void interrupt()
     {
-        cleanInactiveList();
+        QMutexLocker locker(&m_Mutex);
 
-        if (m_ActiveThread != nullptr) {
-            // Interrupt the active thread
-            m_ActiveThread->requestInterruption();
+        if (m_Active) {
+            m_Active = false;
 
-            // Place it on the inactive list awaiting death
-            m_InactiveList.append(m_ActiveThread);
+            // Any poll in progress will see the generation change and bail early
+            m_Generation.fetchAndAddOrdered(1);
+        }
+    }
+
+    // Returns the generation for a new poll if one is due, otherwise -1
+    int beginPoll()
+    {
+        QMutexLocker locker(&m_Mutex);
 
-            m_ActiveThread = nullptr;
+        if (!m_Active || m_InFlight || !m_NextPoll.hasExpired()) {
+            return -1;
         }
+
+        m_InFlight = true;
+        return m_Generation.loadAcquire();
     }
 
-private:
-    void cleanInactiveList()
+    void endPoll(int generation, qint64 nextPollDelayMs, bool backedOff)
     {
-        QMutableListIterator<QThread*> i(m_InactiveList);
+        QMutexLocker locker(&m_Mutex);
 
-        // Reap any threads that have finished
-        while (i.hasNext()) {
-            i.next();
+        Q_ASSERT(m_InFlight);
 
-            QThread* thread = i.value();
-            if (thread->isFinished()) {
-                delete thread;
-                i.remove();
-            }
+        // If we were interrupted and reactivated during this poll,
+        // keep the immediate poll scheduled by activate().
+        if (generation == m_Generation.loadAcquire()) {
+            m_NextPoll = QDeadlineTimer(nextPollDelayMs);
+            m_BackedOff = backedOff;
+        }
+
+        m_InFlight = false;
+        m_IdleCondition.wakeAll();
+    }
+
+    // Polls at a short interval until the host comes online or the duration passes
+    void beginWakePolling(qint64 durationMs)
+    {
+        QMutexLocker locker(&m_Mutex);
+
+        m_WakeDeadline = QDeadlineTimer(durationMs);
+        m_BackedOff = false;
+
+        // Start right away unless a poll is already in progress
+        if (!m_InFlight) {
+            m_NextPoll = QDeadlineTimer(0);
+        }
+    }
+
+    void endWakePolling()
+    {
+        QMutexLocker locker(&m_Mutex);
+
+        m_WakeDeadline = QDeadlineTimer();
+    }
+
+    bool isWakePolling()
+    {
+        QMutexLocker locker(&m_Mutex);
+
+        return !m_WakeDeadline.hasExpired();
+    }
+
+    // True if the host was offline and its polls are backing off
+    bool isBackedOff()
+    {
+        QMutexLocker locker(&m_Mutex);
+
+        return m_BackedOff;
+    }
+
+    bool isInterrupted(int generation)
+    {
+        return m_Generation.loadAcquire() != generation;
+    }
+
+    // Returns the time until the next poll, or -1 if none is pending
+    qint64 remainingTimeUntilPoll()
+    {
+        QMutexLocker locker(&m_Mutex);
+
+        if (!m_Active || m_InFlight) {
+            return -1;
         }
+
+        return m_NextPoll.remainingTime();
     }
 
-    QThread* m_ActiveThread;
-    QList<QThread*> m_InactiveList;
+private:
+    QMutex m_Mutex;
+    QWaitCondition m_IdleCondition;
+    bool m_Active;
+    bool m_InFlight;
+    bool m_BackedOff;
+    QAtomicInt m_Generation;
+    QDeadlineTimer m_NextPoll;
+
+    QDeadlineTimer m_WakeDeadline;
+
+    // Only accessed by the poll in progress
+    int m_StateGeneration;
+    int m_OfflinePolls;
+    int m_PollsSinceLastAppListFetch;
+    QByteArray m_AppListResponseHash;
 };
 
 class ComputerManager : public QObject
@@ -212,9 +341,11 @@ class ComputerManager : public QObject
     Q_OBJECT
 
     friend class DeferredHostDeletionTask;
+    friend class DeferredWakeHostTask;
     friend class PendingAddTask;
     friend class PendingPairingTask;
     friend class DelayedFlushThread;
+    friend class PcMonitorTask;
 
 public:
     explicit ComputerManager(StreamingPreferences* prefs);
@@ -244,6 +375,14 @@ public:
 
     void clientSideAttributeUpdated(NvComputer* computer);
 
+    // Sends Wake-on-LAN packets to the host, then polls it at a
+    // short interval to catch it as soon as it's ready to stream.
+    void wakeHost(NvComputer* computer);
+
+    // Reads the persisted app list for this host if it hasn't been loaded yet.
+    // This must be called before accessing the app list of a host.
+    void loadAppList(NvComputer* computer);
+
 signals:
     void computerStateChanged(NvComputer* computer);
 
@@ -260,12 +399,34 @@ private slots:
 
     void handleMdnsServiceResolved(MdnsPendingComputer* computer, QVector<QHostAddress>& addresses);
 
+    void handleMdnsServiceResolveFailed(MdnsPendingComputer* computer);
+
+    void schedulePolls();
+
+    void logPollStats();
+
 private:
+    void migrateHostsFromSettings();
+
+    void beginWakePolling(const QString& uuid);
+
+    void recordPoll(qint64 durationMs, bool online);
+
+    void handleMdnsServiceDiscovered(const QMdnsEngine::Service& service);
+
+    void addMdnsHost(QString hostname, uint16_t port, const QVector<QHostAddress>& addresses);
+
+    void loadMdnsCache();
+
+    void saveMdnsCache();
+
+    void probeMdnsCachedHosts();
+
     void saveHosts();
 
     void saveHost(NvComputer* computer);
 
-    QHostAddress getBestGlobalAddressV6(QVector<QHostAddress>& addresses);
+    QHostAddress getBestGlobalAddressV6(const QVector<QHostAddress>& addresses);
 
     void startPollingComputer(NvComputer* computer);
 
@@ -274,13 +435,29 @@ private:
     QReadWriteLock m_Lock;
     QMap<QString, NvComputer*> m_KnownHosts;
     QMap<QString, ComputerPollingEntry*> m_PollEntries;
+    QThreadPool m_PollThreadPool;
+    QThreadPool m_OfflinePollThreadPool;
+    QTimer m_PollTimer;
+    QTimer m_PollStatsTimer;
+    QMutex m_PollStatsLock;
+    int m_PollCount; // Protected by m_PollStatsLock
+    int m_OfflinePollCount; // Protected by m_PollStatsLock
+    qint64 m_TotalPollTimeMs; // Protected by m_PollStatsLock
+    qint64 m_MaxPollTimeMs; // Protected by m_PollStatsLock
+    HostStore m_HostStore;
     QHash<QString, NvComputer> m_LastSerializedHosts; // Protected by m_DelayedFlushMutex
     QSharedPointer<QMdnsEngine::Server> m_MdnsServer;
     QMdnsEngine::Browser* m_MdnsBrowser;
     QVector<MdnsPendingComputer*> m_PendingResolution;
+    QHash<QByteArray, MdnsCachedHost> m_MdnsCache; // Only accessed on the main thread
+    bool m_ProbedMdnsCache;
+    QElapsedTimer m_StartupTimer;
+    bool m_LoggedFirstOnlineHost;
     CompatFetcher m_CompatFetcher;
     DelayedFlushThread* m_DelayedFlushThread;
     QMutex m_DelayedFlushMutex; // Lock ordering: Must never be acquired while holding NvComputer lock
     QWaitCondition m_DelayedFlushCondition;
     bool m_NeedsDelayedFlush;
+    QJsonArray m_PendingMdnsCache; // Protected by m_DelayedFlushMutex
+    bool m_NeedsMdnsCacheFlush; // Protected by m_DelayedFlushMutex
 };
@@ -7,10 +7,11 @@ ComputerSeeker::ComputerSeeker(ComputerManager *manager, QString computerName, Q
       m_TimeoutTimer(new QTimer(this))
 {
     // If we know this computer, send a WOL packet to wake it up in case it is asleep.
+    // It will be polled rapidly afterwards, so we find it as soon as it's ready.
     const auto computers = m_ComputerManager->getComputers();
     for (NvComputer* computer : computers) {
         if (this->matchComputer(computer)) {
-            computer->wake();
+            m_ComputerManager->wakeHost(computer);
         }
     }
 
@@ -0,0 +1,153 @@
+#include "hoststore.h"
+#include "../path.h"
+
+#include <QtDebug>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QFile>
+
+// Bump this when making incompatible changes to the record format
+#define STORE_VERSION 1
+
+#define SER_VERSION "version"
+#define SER_HOST "host"
+#define SER_APPS "apps"
+#define SER_MDNSHOSTS "mdnshosts"
+
+#define HOST_FILE_SUFFIX ".host.json"
+#define APPS_FILE_SUFFIX ".apps.json"
+#define MDNS_CACHE_FILE "mdns.json"
+
+// Written once all hosts have been migrated from QSettings
+#define COMPLETE_MARKER_FILE "complete.json"
+
+HostStore::HostStore()
+    : m_Dir(Path::getHostStoreDir())
+{
+
+}
+
+bool HostStore::isComplete() const
+{
+    return m_Dir.exists(COMPLETE_MARKER_FILE);
+}
+
+bool HostStore::markComplete() const
+{
+    return writeRecord(m_Dir.filePath(COMPLETE_MARKER_FILE), QJsonObject());
+}
+
+QString HostStore::getFilePathForHost(const QString& uuid) const
+{
+    return m_Dir.filePath(uuid + HOST_FILE_SUFFIX);
+}
+
+QString HostStore::getFilePathForAppList(const QString& uuid) const
+{
+    return m_Dir.filePath(uuid + APPS_FILE_SUFFIX);
+}
+
+QJsonObject HostStore::readRecord(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!document.isObject()) {
+        qWarning() << "Failed to parse" << filePath << ":" << error.errorString();
+        return QJsonObject();
+    }
+
+    QJsonObject record = document.object();
+    int version = record.value(SER_VERSION).toInt();
+    if (version <= 0 || version > STORE_VERSION) {
+        qWarning() << "Ignoring" << filePath << "with unsupported version:" << version;
+        return QJsonObject();
+    }
+
+    return record;
+}
+
+bool HostStore::writeRecord(const QString& filePath, QJsonObject record) const
+{
+    if (!m_Dir.exists() && !m_Dir.mkpath(".")) {
+        qWarning() << "Failed to create host store:" << m_Dir.path();
+        return false;
+    }
+
+    record.insert(SER_VERSION, STORE_VERSION);
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) ||
+            file.write(QJsonDocument(record).toJson(QJsonDocument::Compact)) < 0 ||
+            !file.commit()) {
+        qWarning() << "Failed to write" << filePath << ":" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QVector<NvComputer*> HostStore::loadHosts() const
+{
+    QVector<NvComputer*> hosts;
+
+    const QStringList fileNames = m_Dir.entryList(QStringList() << "*" HOST_FILE_SUFFIX, QDir::Files);
+    for (const QString& fileName : fileNames) {
+        QJsonObject host = readRecord(m_Dir.filePath(fileName)).value(SER_HOST).toObject();
+        if (host.isEmpty()) {
+            continue;
+        }
+
+        NvComputer* computer = new NvComputer(host);
+        if (computer->uuid.isEmpty()) {
+            qWarning() << "Ignoring host record without UUID:" << fileName;
+            delete computer;
+            continue;
+        }
+
+        hosts.append(computer);
+    }
+
+    return hosts;
+}
+
+QJsonArray HostStore::loadAppList(const QString& uuid) const
+{
+    return readRecord(getFilePathForAppList(uuid)).value(SER_APPS).toArray();
+}
+
+bool HostStore::saveHost(const NvComputer& computer) const
+{
+    QJsonObject record;
+    record.insert(SER_HOST, computer.serialize());
+    return writeRecord(getFilePathForHost(computer.uuid), record);
+}
+
+bool HostStore::saveAppList(const NvComputer& computer) const
+{
+    QJsonObject record;
+    record.insert(SER_APPS, computer.serializeAppList());
+    return writeRecord(getFilePathForAppList(computer.uuid), record);
+}
+
+void HostStore::deleteHost(const QString& uuid) const
+{
+    QFile::remove(getFilePathForHost(uuid));
+    QFile::remove(getFilePathForAppList(uuid));
+}
+
+QJsonArray HostStore::loadMdnsCache() const
+{
+    return readRecord(m_Dir.filePath(MDNS_CACHE_FILE)).value(SER_MDNSHOSTS).toArray();
+}
+
+bool HostStore::saveMdnsCache(const QJsonArray& cache) const
+{
+    QJsonObject record;
+    record.insert(SER_MDNSHOSTS, cache);
+    return writeRecord(m_Dir.filePath(MDNS_CACHE_FILE), record);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "nvcomputer.h"
+
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonObject>
+
+// Persists each host as a separate compact JSON record, so updating one
+// host never rewrites the others. App lists live in their own file next
+// to the host record, which allows them to be loaded only when needed.
+// Every file is replaced atomically, so an interrupted write always
+// leaves the previous copy of that record intact.
+class HostStore
+{
+public:
+    HostStore();
+
+    // False until every host has been migrated into the store. A store
+    // without the marker may be missing hosts that are only in QSettings.
+    bool isComplete() const;
+
+    bool markComplete() const;
+
+    // Returns all hosts without their app lists. The caller owns them.
+    QVector<NvComputer*> loadHosts() const;
+
+    QJsonArray loadAppList(const QString& uuid) const;
+
+    bool saveHost(const NvComputer& computer) const;
+
+    bool saveAppList(const NvComputer& computer) const;
+
+    void deleteHost(const QString& uuid) const;
+
+    QJsonArray loadMdnsCache() const;
+
+    bool saveMdnsCache(const QJsonArray& cache) const;
+
+private:
+    QString getFilePathForHost(const QString& uuid) const;
+
+    QString getFilePathForAppList(const QString& uuid) const;
+
+    static QJsonObject readRecord(const QString& filePath);
+
+    bool writeRecord(const QString& filePath, QJsonObject record) const;
+
+    QDir m_Dir;
+};
@@ -17,12 +17,36 @@ NvApp::NvApp(QSettings& settings)
     directLaunch = settings.value(SER_DIRECTLAUNCH).toBool();
 }
 
-void NvApp::serialize(QSettings& settings) const
+NvApp::NvApp(const QJsonObject& json)
 {
-    settings.setValue(SER_APPNAME, name);
-    settings.setValue(SER_APPID, id);
-    settings.setValue(SER_APPHDR, hdrSupported);
-    settings.setValue(SER_APPCOLLECTOR, isAppCollectorGame);
-    settings.setValue(SER_HIDDEN, hidden);
-    settings.setValue(SER_DIRECTLAUNCH, directLaunch);
+    name = json.value(SER_APPNAME).toString();
+    id = json.value(SER_APPID).toInt();
+    hdrSupported = json.value(SER_APPHDR).toBool();
+    isAppCollectorGame = json.value(SER_APPCOLLECTOR).toBool();
+    hidden = json.value(SER_HIDDEN).toBool();
+    directLaunch = json.value(SER_DIRECTLAUNCH).toBool();
+}
+
+QJsonObject NvApp::serialize() const
+{
+    QJsonObject json;
+
+    json.insert(SER_APPNAME, name);
+    json.insert(SER_APPID, id);
+
+    // Omit false flags to keep records compact
+    if (hdrSupported) {
+        json.insert(SER_APPHDR, true);
+    }
+    if (isAppCollectorGame) {
+        json.insert(SER_APPCOLLECTOR, true);
+    }
+    if (hidden) {
+        json.insert(SER_HIDDEN, true);
+    }
+    if (directLaunch) {
+        json.insert(SER_DIRECTLAUNCH, true);
+    }
+
+    return json;
 }
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <QSettings>
+#include <QJsonObject>
 
 class NvApp
 {
 public:
     NvApp() {}
     explicit NvApp(QSettings& settings);
+    explicit NvApp(const QJsonObject& json);
 
     bool operator==(const NvApp& other) const
     {
@@ -28,8 +30,8 @@ public:
         return id != 0 && !name.isEmpty();
     }
 
-    void
-    serialize(QSettings& settings) const;
+    QJsonObject
+    serialize() const;
 
     int id = 0;
     QString name;
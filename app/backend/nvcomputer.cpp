@@ -6,6 +6,10 @@
 #include <QHostInfo>
 #include <QNetworkInterface>
 #include <QNetworkProxy>
+#include <QHash>
+#include <QJsonArray>
+#include <QEventLoop>
+#include <QTimer>
 
 #define SER_NAME "hostname"
 #define SER_UUID "uuid"
@@ -23,6 +27,28 @@
 #define SER_CUSTOMNAME "customname"
 #define SER_NVIDIASOFTWARE "nvidiasw"
 
+// Host names are resolved in parallel when waking a host, but
+// we won't wait longer than this for the slowest of them.
+#define WOL_RESOLVE_TIMEOUT_MS 3000
+
+static void serializeAddress(QJsonObject& json, const char* addressKey, const char* portKey, const NvAddress& address)
+{
+    if (!address.isNull()) {
+        json.insert(addressKey, address.address());
+        json.insert(portKey, (int)address.port());
+    }
+}
+
+static NvAddress deserializeAddress(const QJsonObject& json, const char* addressKey, const char* portKey)
+{
+    if (!json.contains(addressKey)) {
+        return NvAddress();
+    }
+
+    return NvAddress(json.value(addressKey).toString(),
+                     (uint16_t)json.value(portKey).toInt(DEFAULT_HTTP_PORT));
+}
+
 NvComputer::NvComputer(QSettings& settings)
 {
     this->name = settings.value(SER_NAME).toString();
@@ -49,8 +75,33 @@ NvComputer::NvComputer(QSettings& settings)
         this->appList.append(app);
     }
     settings.endArray();
-    sortAppList();
+    sortAppList(this->appList);
+    this->appListLoaded = true;
+
+    initializeEphemeralTraits();
+}
 
+NvComputer::NvComputer(const QJsonObject& json)
+{
+    this->name = json.value(SER_NAME).toString();
+    this->uuid = json.value(SER_UUID).toString();
+    this->hasCustomName = json.value(SER_CUSTOMNAME).toBool();
+    this->macAddress = QByteArray::fromHex(json.value(SER_MAC).toString().toLatin1());
+    this->localAddress = deserializeAddress(json, SER_LOCALADDR, SER_LOCALPORT);
+    this->remoteAddress = deserializeAddress(json, SER_REMOTEADDR, SER_REMOTEPORT);
+    this->ipv6Address = deserializeAddress(json, SER_IPV6ADDR, SER_IPV6PORT);
+    this->manualAddress = deserializeAddress(json, SER_MANUALADDR, SER_MANUALPORT);
+    this->serverCert = QSslCertificate(json.value(SER_SRVCERT).toString().toLatin1());
+    this->isNvidiaServerSoftware = json.value(SER_NVIDIASOFTWARE).toBool();
+
+    // The app list is stored separately and loaded on demand
+    this->appListLoaded = false;
+
+    initializeEphemeralTraits();
+}
+
+void NvComputer::initializeEphemeralTraits()
+{
     this->currentGameId = 0;
     this->pairState = PS_UNKNOWN;
     this->state = CS_UNKNOWN;
@@ -74,35 +125,55 @@ void NvComputer::setRemoteAddress(QHostAddress address)
     this->remoteAddress = NvAddress(address, this->externalPort);
 }
 
-void NvComputer::serialize(QSettings& settings, bool serializeApps) const
+QJsonObject NvComputer::serialize() const
 {
     QReadLocker lock(&this->lock);
+    QJsonObject json;
+
+    json.insert(SER_NAME, name);
+    json.insert(SER_CUSTOMNAME, hasCustomName);
+    json.insert(SER_UUID, uuid);
+    json.insert(SER_MAC, QString::fromLatin1(macAddress.toHex()));
+    serializeAddress(json, SER_LOCALADDR, SER_LOCALPORT, localAddress);
+    serializeAddress(json, SER_REMOTEADDR, SER_REMOTEPORT, remoteAddress);
+    serializeAddress(json, SER_IPV6ADDR, SER_IPV6PORT, ipv6Address);
+    serializeAddress(json, SER_MANUALADDR, SER_MANUALPORT, manualAddress);
+    json.insert(SER_SRVCERT, QString::fromLatin1(serverCert.toPem()));
+    json.insert(SER_NVIDIASOFTWARE, isNvidiaServerSoftware);
+
+    return json;
+}
 
-    settings.setValue(SER_NAME, name);
-    settings.setValue(SER_CUSTOMNAME, hasCustomName);
-    settings.setValue(SER_UUID, uuid);
-    settings.setValue(SER_MAC, macAddress);
-    settings.setValue(SER_LOCALADDR, localAddress.address());
-    settings.setValue(SER_LOCALPORT, localAddress.port());
-    settings.setValue(SER_REMOTEADDR, remoteAddress.address());
-    settings.setValue(SER_REMOTEPORT, remoteAddress.port());
-    settings.setValue(SER_IPV6ADDR, ipv6Address.address());
-    settings.setValue(SER_IPV6PORT, ipv6Address.port());
-    settings.setValue(SER_MANUALADDR, manualAddress.address());
-    settings.setValue(SER_MANUALPORT, manualAddress.port());
-    settings.setValue(SER_SRVCERT, serverCert.toPem());
-    settings.setValue(SER_NVIDIASOFTWARE, isNvidiaServerSoftware);
-
-    // Avoid deleting an existing applist if we couldn't get one
-    if (!appList.isEmpty() && serializeApps) {
-        settings.remove(SER_APPLIST);
-        settings.beginWriteArray(SER_APPLIST);
-        for (int i = 0; i < appList.count(); i++) {
-            settings.setArrayIndex(i);
-            appList.at(i).serialize(settings);
-        }
-        settings.endArray();
+QJsonArray NvComputer::serializeAppList() const
+{
+    QReadLocker lock(&this->lock);
+    QJsonArray json;
+
+    for (const NvApp& app : appList) {
+        json.append(app.serialize());
+    }
+
+    return json;
+}
+
+bool NvComputer::setPersistedAppList(const QJsonArray& json)
+{
+    QWriteLocker lock(&this->lock);
+
+    // Don't clobber an app list that was fetched before we got here
+    if (appListLoaded || !appList.isEmpty()) {
+        appListLoaded = true;
+        return false;
     }
+
+    appList.reserve(json.count());
+    for (const QJsonValue& app : json) {
+        appList.append(NvApp(app.toObject()));
+    }
+    sortAppList(appList);
+
+    appListLoaded = true;
+    return true;
 }
 
 bool NvComputer::isEqualSerialized(const NvComputer &that) const
@@ -120,50 +191,47 @@ bool NvComputer::isEqualSerialized(const NvComputer &that) const
            this->appList == that.appList;
 }
 
-void NvComputer::sortAppList()
+void NvComputer::sortAppList(QVector<NvApp>& apps)
 {
-    std::stable_sort(appList.begin(), appList.end(), [](const NvApp& app1, const NvApp& app2) {
+    std::stable_sort(apps.begin(), apps.end(), [](const NvApp& app1, const NvApp& app2) {
        return app1.name.toLower() < app2.name.toLower();
     });
 }
 
-NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
+NvComputer::NvComputer(NvHTTP& http, const NvServerInfo& serverInfo)
 {
     this->serverCert = http.serverCert();
 
     this->hasCustomName = false;
-    this->name = NvHTTP::getXmlString(serverInfo, "hostname");
+    this->name = serverInfo.hostname;
     if (this->name.isEmpty()) {
         this->name = "UNKNOWN";
     }
 
-    this->uuid = NvHTTP::getXmlString(serverInfo, "uniqueid");
-    QString newMacString = NvHTTP::getXmlString(serverInfo, "mac");
-    if (newMacString != "00:00:00:00:00:00") {
-        QStringList macOctets = newMacString.split(':');
+    this->uuid = serverInfo.uniqueId;
+    if (serverInfo.mac != "00:00:00:00:00:00") {
+        QStringList macOctets = serverInfo.mac.split(':');
         for (const QString& macOctet : std::as_const(macOctets)) {
             this->macAddress.append((char) macOctet.toInt(nullptr, 16));
         }
     }
 
-    QString codecSupport = NvHTTP::getXmlString(serverInfo, "ServerCodecModeSupport");
-    if (!codecSupport.isEmpty()) {
-        this->serverCodecModeSupport = codecSupport.toInt();
+    if (!serverInfo.serverCodecModeSupport.isEmpty()) {
+        this->serverCodecModeSupport = serverInfo.serverCodecModeSupport.toInt();
     }
     else {
         // Assume H.264 is always supported
         this->serverCodecModeSupport = SCM_H264;
     }
 
-    QString maxLumaPixelsHEVC = NvHTTP::getXmlString(serverInfo, "MaxLumaPixelsHEVC");
-    if (!maxLumaPixelsHEVC.isEmpty()) {
-        this->maxLumaPixelsHEVC = maxLumaPixelsHEVC.toInt();
+    if (!serverInfo.maxLumaPixelsHEVC.isEmpty()) {
+        this->maxLumaPixelsHEVC = serverInfo.maxLumaPixelsHEVC.toInt();
     }
     else {
         this->maxLumaPixelsHEVC = 0;
     }
 
-    this->displayModes = NvHTTP::getDisplayModeList(serverInfo);
+    this->displayModes = serverInfo.displayModes;
     std::stable_sort(this->displayModes.begin(), this->displayModes.end(),
                      [](const NvDisplayMode& mode1, const NvDisplayMode& mode2) {
         return (uint64_t)mode1.width * mode1.height * mode1.refreshRate <
@@ -171,26 +239,23 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
     });
 
     // We can get an IPv4 loopback address if we're using the GS IPv6 Forwarder
-    this->localAddress = NvAddress(NvHTTP::getXmlString(serverInfo, "LocalIP"), http.httpPort());
+    this->localAddress = NvAddress(serverInfo.localIp, http.httpPort());
     if (this->localAddress.address().startsWith("127.")) {
         this->localAddress = NvAddress();
     }
 
-    QString httpsPort = NvHTTP::getXmlString(serverInfo, "HttpsPort");
-    if (httpsPort.isEmpty() || (this->activeHttpsPort = httpsPort.toUShort()) == 0) {
+    if (serverInfo.httpsPort.isEmpty() || (this->activeHttpsPort = serverInfo.httpsPort.toUShort()) == 0) {
         this->activeHttpsPort = DEFAULT_HTTPS_PORT;
     }
 
     // This is an extension which is not present in GFE. It is present for Sunshine to be able
     // to support dynamic HTTP WAN ports without requiring the user to manually enter the port.
-    QString remotePortStr = NvHTTP::getXmlString(serverInfo, "ExternalPort");
-    if (remotePortStr.isEmpty() || (this->externalPort = remotePortStr.toUShort()) == 0) {
+    if (serverInfo.externalPort.isEmpty() || (this->externalPort = serverInfo.externalPort.toUShort()) == 0) {
         this->externalPort = http.httpPort();
     }
 
-    QString remoteAddress = NvHTTP::getXmlString(serverInfo, "ExternalIP");
-    if (!remoteAddress.isEmpty()) {
-        this->remoteAddress = NvAddress(remoteAddress, this->externalPort);
+    if (!serverInfo.externalIp.isEmpty()) {
+        this->remoteAddress = NvAddress(serverInfo.externalIp, this->externalPort);
     }
     else {
         this->remoteAddress = NvAddress();
@@ -199,14 +264,14 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
     // Real Nvidia host software (GeForce Experience and RTX Experience) both use the 'Mjolnir'
     // codename in the state field and no version of Sunshine does. We can use this to bypass
     // some assumptions about Nvidia hardware that don't apply to Sunshine hosts.
-    this->isNvidiaServerSoftware = NvHTTP::getXmlString(serverInfo, "state").contains("MJOLNIR");
+    this->isNvidiaServerSoftware = serverInfo.state.contains("MJOLNIR");
 
-    this->pairState = NvHTTP::getXmlString(serverInfo, "PairStatus") == "1" ?
+    this->pairState = serverInfo.pairStatus == "1" ?
                 PS_PAIRED : PS_NOT_PAIRED;
     this->currentGameId = NvHTTP::getCurrentGame(serverInfo);
-    this->appVersion = NvHTTP::getXmlString(serverInfo, "appversion");
-    this->gfeVersion = NvHTTP::getXmlString(serverInfo, "GfeVersion");
-    this->gpuModel = NvHTTP::getXmlString(serverInfo, "gputype");
+    this->appVersion = serverInfo.appVersion;
+    this->gfeVersion = serverInfo.gfeVersion;
+    this->gpuModel = serverInfo.gpuType;
     this->activeAddress = http.address();
     this->state = NvComputer::CS_ONLINE;
     this->pendingQuit = false;
@@ -289,33 +354,36 @@ bool NvComputer::wake() const
         }
     }
 
-    // Try all unique address strings or host names
     bool success = false;
-    for (auto i = addressMap.constBegin(); i != addressMap.constEnd(); i++) {
-        QHostAddress literalAddress;
-        QList<QHostAddress> addressList;
+    auto sendWolPackets = [&](const QHostAddress& address, quint16 knownBasePort) {
+        QUdpSocket sock;
+
+        // Send to all static ports
+        for (quint16 port : STATIC_WOL_PORTS) {
+            if (sock.writeDatagram(wolPayload, address, port)) {
+                qInfo().nospace().noquote() << "Sent WoL packet to " << name << " via " << address.toString() << ":" << port;
+                success = true;
+            }
+            else {
+                qWarning() << "Send failed:" << sock.error();
+            }
+        }
 
-        // If this is an IPv4/IPv6 literal, don't use QHostInfo::fromName() because that will
-        // try to perform a reverse DNS lookup that leads to delays sending WoL packets.
-        if (literalAddress.setAddress(i.key())) {
-            addressList.append(literalAddress);
+        QList<quint16> basePorts;
+        if (knownBasePort != 0) {
+            // If we have a known base port for this address, use only that port
+            basePorts.append(knownBasePort);
         }
         else {
-            QHostInfo hostInfo = QHostInfo::fromName(i.key());
-            if (hostInfo.error() != QHostInfo::NoError) {
-                qWarning() << "Error resolving" << i.key() << ":" << hostInfo.errorString();
-                continue;
-            }
-
-            addressList.append(hostInfo.addresses());
+            // If this is a broadcast address without a known HTTP port, try all of them
+            basePorts.append(basePortSet.values());
         }
 
-        // Try all IP addresses that this string resolves to
-        for (QHostAddress& address : addressList) {
-            QUdpSocket sock;
+        // Send to all dynamic ports using the HTTP port offset(s) for this address
+        for (quint16 basePort : basePorts) {
+            for (quint16 port : DYNAMIC_WOL_PORTS) {
+                port = (port - 47989) + basePort;
 
-            // Send to all static ports
-            for (quint16 port : STATIC_WOL_PORTS) {
                 if (sock.writeDatagram(wolPayload, address, port)) {
                     qInfo().nospace().noquote() << "Sent WoL packet to " << name << " via " << address.toString() << ":" << port;
                     success = true;
@@ -324,32 +392,49 @@ bool NvComputer::wake() const
                     qWarning() << "Send failed:" << sock.error();
                 }
             }
+        }
+    };
 
-            QList<quint16> basePorts;
-            if (i.value() != 0) {
-                // If we have a known base port for this address, use only that port
-                basePorts.append(i.value());
-            }
-            else {
-                // If this is a broadcast address without a known HTTP port, try all of them
-                basePorts.append(basePortSet.values());
-            }
+    // Send to all IPv4/IPv6 literals immediately. Don't use QHostInfo for these because
+    // it will try to perform a reverse DNS lookup that leads to delays sending WoL packets.
+    QStringList hostNames;
+    for (auto i = addressMap.constBegin(); i != addressMap.constEnd(); i++) {
+        QHostAddress literalAddress;
+        if (literalAddress.setAddress(i.key())) {
+            sendWolPackets(literalAddress, i.value());
+        }
+        else {
+            hostNames.append(i.key());
+        }
+    }
 
-            // Send to all dynamic ports using the HTTP port offset(s) for this address
-            for (quint16 basePort : basePorts) {
-                for (quint16 port : DYNAMIC_WOL_PORTS) {
-                    port = (port - 47989) + basePort;
+    // Resolve any host names in parallel, sending to each address as it resolves
+    if (!hostNames.isEmpty()) {
+        int pendingLookups = hostNames.count();
+        QEventLoop loop;
 
-                    if (sock.writeDatagram(wolPayload, address, port)) {
-                        qInfo().nospace().noquote() << "Sent WoL packet to " << name << " via " << address.toString() << ":" << port;
-                        success = true;
-                    }
-                    else {
-                        qWarning() << "Send failed:" << sock.error();
+        for (const QString& hostName : std::as_const(hostNames)) {
+            QHostInfo::lookupHost(hostName, &loop, [&, hostName](const QHostInfo& hostInfo) {
+                if (hostInfo.error() != QHostInfo::NoError) {
+                    qWarning() << "Error resolving" << hostName << ":" << hostInfo.errorString();
+                }
+                else {
+                    // Try all IP addresses that this string resolves to
+                    const auto addressList = hostInfo.addresses();
+                    for (const QHostAddress& address : addressList) {
+                        sendWolPackets(address, addressMap.value(hostName));
                     }
                 }
-            }
+
+                if (--pendingLookups == 0) {
+                    loop.quit();
+                }
+            });
         }
+
+        // Any lookups still pending are dropped when the loop is destroyed
+        QTimer::singleShot(WOL_RESOLVE_TIMEOUT_MS, &loop, &QEventLoop::quit);
+        loop.exec();
     }
 
     return success;
@@ -463,22 +548,28 @@ NvComputer::ReachabilityType NvComputer::getActiveAddressReachability() const
 }
 
 bool NvComputer::updateAppList(QVector<NvApp> newAppList) {
-    if (appList == newAppList) {
-        return false;
-    }
-
     // Propagate client-side attributes to the new app list
+    QHash<int, const NvApp*> existingApps;
+    existingApps.reserve(appList.count());
     for (const NvApp& existingApp : std::as_const(appList)) {
-        for (NvApp& newApp : newAppList) {
-            if (existingApp.id == newApp.id) {
-                newApp.hidden = existingApp.hidden;
-                newApp.directLaunch = existingApp.directLaunch;
-            }
+        existingApps.insert(existingApp.id, &existingApp);
+    }
+    for (NvApp& newApp : newAppList) {
+        const NvApp* existingApp = existingApps.value(newApp.id);
+        if (existingApp != nullptr) {
+            newApp.hidden = existingApp->hidden;
+            newApp.directLaunch = existingApp->directLaunch;
         }
     }
 
+    // The existing list is sorted, so the new one must be too before
+    // we can tell whether anything actually changed.
+    sortAppList(newAppList);
+    if (appList == newAppList) {
+        return false;
+    }
+
     appList = newAppList;
-    sortAppList();
     return true;
 }
 
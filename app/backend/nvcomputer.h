@@ -6,6 +6,8 @@
 #include <QThread>
 #include <QReadWriteLock>
 #include <QSettings>
+#include <QJsonObject>
+#include <QJsonArray>
 #include <QRunnable>
 
 class CopySafeReadWriteLock : public QReadWriteLock
@@ -20,17 +22,26 @@ public:
 
 class NvComputer
 {
-    friend class PcMonitorThread;
+    friend class PcMonitorTask;
     friend class ComputerManager;
     friend class PendingQuitTask;
 
 private:
-    void sortAppList();
+    static void sortAppList(QVector<NvApp>& apps);
 
     bool updateAppList(QVector<NvApp> newAppList);
 
+    void initializeEphemeralTraits();
+
+    // Installs the app list read from the host store unless it's already loaded.
+    // Returns false if the existing app list was kept.
+    bool setPersistedAppList(const QJsonArray& json);
+
     bool pendingQuit;
 
+    // False until the persisted app list is read from the host store
+    bool appListLoaded = true;
+
 public:
     NvComputer() = default;
 
@@ -40,16 +51,20 @@ public:
     // Caller is responsible for synchronizing read access to the other host
     NvComputer& operator=(const NvComputer &) = default;
 
-    explicit NvComputer(NvHTTP& http, QString serverInfo);
+    explicit NvComputer(NvHTTP& http, const NvServerInfo& serverInfo);
 
+    // Only used to migrate hosts from QSettings
     explicit NvComputer(QSettings& settings);
 
+    explicit NvComputer(const QJsonObject& json);
+
     void
     setRemoteAddress(QHostAddress);
 
     bool
     update(const NvComputer& that);
 
+    // Blocks while resolving host names, so avoid calling this on the UI thread
     bool
     wake() const;
 
@@ -66,8 +81,11 @@ public:
     QVector<NvAddress>
     uniqueAddresses() const;
 
-    void
-    serialize(QSettings& settings, bool serializeApps) const;
+    QJsonObject
+    serialize() const;
+
+    QJsonArray
+    serializeAppList() const;
 
     // Caller is responsible for synchronizing read access to both hosts
     bool
@@ -11,6 +11,10 @@
 #include <QImageReader>
 #include <QtEndian>
 #include <QNetworkProxy>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QHash>
+#include <QCryptographicHash>
 
 #define FAST_FAIL_TIMEOUT_MS 2000
 #define REQUEST_TIMEOUT_MS 5000
@@ -18,9 +22,20 @@
 #define RESUME_TIMEOUT_MS 30000
 #define QUIT_TIMEOUT_MS 30000
 
+// Idle time before a kept-alive connection to a non-GFE host is closed
+#define KEEPALIVE_TIMEOUT_SECS 10
+
+// TLS session tickets are shared between all NvHTTP instances, so requests made
+// with a different QNetworkAccessManager can still resume the host's session.
+static QMutex s_TlsSessionLock;
+static QHash<QString, QByteArray> s_TlsSessionTickets;
+static QAtomicInt s_TlsHandshakes;
+static QAtomicInt s_TlsResumedHandshakes;
+
 NvHTTP::NvHTTP(NvAddress address, uint16_t httpsPort, QSslCertificate serverCert, QNetworkAccessManager* nam) :
     m_Nam(nam ? nam : new QNetworkAccessManager(this)),
-    m_ServerCert(serverCert)
+    m_ServerCert(serverCert),
+    m_AllowKeepAlive(false)
 {
     m_BaseUrlHttp.setScheme("http");
     m_BaseUrlHttps.setScheme("https");
@@ -36,7 +51,13 @@ NvHTTP::NvHTTP(NvAddress address, uint16_t httpsPort, QSslCertificate serverCert
 NvHTTP::NvHTTP(NvComputer* computer, QNetworkAccessManager* nam) :
     NvHTTP(computer->activeAddress, computer->activeHttpsPort, computer->serverCert, nam)
 {
+    // GFE can't handle persistent connections, but other hosts can
+    m_AllowKeepAlive = !computer->isNvidiaServerSoftware;
+}
 
+void NvHTTP::setAllowKeepAlive(bool allowKeepAlive)
+{
+    m_AllowKeepAlive = allowKeepAlive;
 }
 
 void NvHTTP::setServerCert(QSslCertificate serverCert)
@@ -103,15 +124,14 @@ NvHTTP::parseQuad(QString quad)
 }
 
 int
-NvHTTP::getCurrentGame(QString serverInfo)
+NvHTTP::getCurrentGame(const NvServerInfo& serverInfo)
 {
     // GFE 2.8 started keeping currentgame set to the last game played. As a result, it no longer
     // has the semantics that its name would indicate. To contain the effects of this change as much
     // as possible, we'll force the current game to zero if the server isn't in a streaming session.
-    QString serverState = getXmlString(serverInfo, "state");
-    if (serverState != nullptr && serverState.endsWith("_SERVER_BUSY"))
+    if (!serverInfo.state.isNull() && serverInfo.state.endsWith("_SERVER_BUSY"))
     {
-        return getXmlString(serverInfo, "currentgame").toInt();
+        return serverInfo.currentGame.toInt();
     }
     else
     {
@@ -119,10 +139,10 @@ NvHTTP::getCurrentGame(QString serverInfo)
     }
 }
 
-QString
+NvServerInfo
 NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
 {
-    QString serverInfo;
+    NvServerInfo serverInfo;
 
     // Check if we have a pinned cert and HTTPS port for this host yet
     if (!m_ServerCert.isNull() && httpsPort() != 0)
@@ -131,11 +151,11 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
         {
             // Always try HTTPS first, since it properly reports
             // pairing status (and a few other attributes).
-            serverInfo = openConnectionToString(m_BaseUrlHttps,
-                                                "serverinfo",
-                                                nullptr,
-                                                fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
-                                                logLevel);
+            serverInfo = NvServerInfo::parse(openConnectionToByteArray(m_BaseUrlHttps,
+                                                                         "serverinfo",
+                                                                         nullptr,
+                                                                         fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
+                                                                         logLevel));
             // Throws if the request failed
             verifyResponseStatus(serverInfo);
         }
@@ -144,11 +164,11 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
             if (e.getStatusCode() == 401)
             {
                 // Certificate validation error, fallback to HTTP
-                serverInfo = openConnectionToString(m_BaseUrlHttp,
-                                                    "serverinfo",
-                                                    nullptr,
-                                                    fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
-                                                    logLevel);
+                serverInfo = NvServerInfo::parse(openConnectionToByteArray(m_BaseUrlHttp,
+                                                                             "serverinfo",
+                                                                             nullptr,
+                                                                             fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
+                                                                             logLevel));
                 verifyResponseStatus(serverInfo);
             }
             else
@@ -161,15 +181,15 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
     else
     {
         // Only use HTTP prior to pairing or fetching HTTPS port
-        serverInfo = openConnectionToString(m_BaseUrlHttp,
-                                            "serverinfo",
-                                            nullptr,
-                                            fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
-                                            logLevel);
+        serverInfo = NvServerInfo::parse(openConnectionToByteArray(m_BaseUrlHttp,
+                                                                   "serverinfo",
+                                                                   nullptr,
+                                                                   fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
+                                                                   logLevel));
         verifyResponseStatus(serverInfo);
 
         // Populate the HTTPS port
-        uint16_t httpsPort = getXmlString(serverInfo, "HttpsPort").toUShort();
+        uint16_t httpsPort = serverInfo.httpsPort.toUShort();
         if (httpsPort == 0) {
             httpsPort = DEFAULT_HTTPS_PORT;
         }
@@ -257,69 +277,114 @@ NvHTTP::quitApp()
     }
 }
 
-QVector<NvDisplayMode>
-NvHTTP::getDisplayModeList(QString serverInfo)
+QVector<NvApp>
+NvHTTP::getAppList()
 {
-    QXmlStreamReader xmlReader(serverInfo);
-    QVector<NvDisplayMode> modes;
+    QNetworkReply* reply = openConnection(m_BaseUrlHttps,
+                                          "applist",
+                                          nullptr,
+                                          REQUEST_TIMEOUT_MS,
+                                          NvLogLevel::NVLL_ERROR);
 
-    while (!xmlReader.atEnd()) {
-        while (xmlReader.readNextStartElement()) {
-            auto name = xmlReader.name();
-            if (name == QString("DisplayMode")) {
-                modes.append(NvDisplayMode());
-            }
-            else if (name == QString("Width")) {
-                modes.last().width = xmlReader.readElementText().toInt();
-            }
-            else if (name == QString("Height")) {
-                modes.last().height = xmlReader.readElementText().toInt();
-            }
-            else if (name == QString("RefreshRate")) {
-                modes.last().refreshRate = xmlReader.readElementText().toInt();
-            }
-        }
+    // Parse the reply body directly rather than buffering it into a QString
+    QXmlStreamReader xmlReader(reply);
+    QVector<NvApp> apps;
+    try {
+        apps = parseAppList(xmlReader);
+    } catch (...) {
+        delete reply;
+        throw;
     }
 
-    return modes;
+    delete reply;
+    return apps;
+}
+
+bool
+NvHTTP::getAppListIfChanged(QVector<NvApp>& apps, QByteArray& responseHash)
+{
+    QByteArray response = openConnectionToByteArray(m_BaseUrlHttps,
+                                                    "applist",
+                                                    nullptr,
+                                                    REQUEST_TIMEOUT_MS,
+                                                    NvLogLevel::NVLL_ERROR);
+
+    // GFE and Sunshine don't provide an ETag for the app list, so we hash
+    // the body ourselves to avoid parsing it when nothing has changed.
+    QByteArray newResponseHash = QCryptographicHash::hash(response, QCryptographicHash::Sha1);
+    if (newResponseHash == responseHash) {
+        return false;
+    }
+
+    QXmlStreamReader xmlReader(response);
+    apps = parseAppList(xmlReader);
+
+    // Only remember the hash once we know the response was valid
+    responseHash = newResponseHash;
+    return true;
 }
 
 QVector<NvApp>
-NvHTTP::getAppList()
+NvHTTP::parseAppList(QXmlStreamReader& xmlReader)
 {
-    QString appxml = openConnectionToString(m_BaseUrlHttps,
-                                            "applist",
-                                            nullptr,
-                                            REQUEST_TIMEOUT_MS,
-                                            NvLogLevel::NVLL_ERROR);
-    verifyResponseStatus(appxml);
-
-    QXmlStreamReader xmlReader(appxml);
+    // The status check happens on the root element in the same pass
     QVector<NvApp> apps;
-    while (!xmlReader.atEnd()) {
+    bool hasRoot = false;
+    bool invalidApp = false;
+    int statusCode = -1;
+    QString statusMessage;
+    while (!xmlReader.atEnd() && !invalidApp) {
         while (xmlReader.readNextStartElement()) {
             auto name = xmlReader.name();
-            if (name == QString("App")) {
+            if (name == QLatin1String("root")) {
+                hasRoot = true;
+                statusCode = (int)xmlReader.attributes().value("status_code").toUInt();
+                if (statusCode != 200) {
+                    statusMessage = xmlReader.attributes().value("status_message").toString();
+                    break;
+                }
+            }
+            else if (apps.isEmpty() && name != QLatin1String("App")) {
+                // Ignore anything before the first app
+                continue;
+            }
+            else if (name == QLatin1String("App")) {
                 // We must have a valid app before advancing to the next one
                 if (!apps.isEmpty() && !apps.last().isInitialized()) {
-                    qWarning() << "Invalid applist XML";
-                    throw std::runtime_error("Invalid applist XML");
+                    invalidApp = true;
+                    break;
                 }
                 apps.append(NvApp());
             }
-            else if (name == QString("AppTitle")) {
+            else if (name == QLatin1String("AppTitle")) {
                 apps.last().name = xmlReader.readElementText();
             }
-            else if (name == QString("ID")) {
+            else if (name == QLatin1String("ID")) {
                 apps.last().id = xmlReader.readElementText().toInt();
             }
-            else if (name == QString("IsHdrSupported")) {
-                apps.last().hdrSupported = xmlReader.readElementText() == "1";
+            else if (name == QLatin1String("IsHdrSupported")) {
+                apps.last().hdrSupported = xmlReader.readElementText() == QLatin1String("1");
             }
-            else if (name == QString("IsAppCollectorGame")) {
-                apps.last().isAppCollectorGame = xmlReader.readElementText() == "1";
+            else if (name == QLatin1String("IsAppCollectorGame")) {
+                apps.last().isAppCollectorGame = xmlReader.readElementText() == QLatin1String("1");
             }
         }
+
+        if (hasRoot && statusCode != 200) {
+            break;
+        }
+    }
+
+    if (!hasRoot) {
+        throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+    }
+
+    // Throws if the request failed
+    throwIfStatusError(statusCode, statusMessage);
+
+    if (invalidApp) {
+        qWarning() << "Invalid applist XML";
+        throw std::runtime_error("Invalid applist XML");
     }
 
     return apps;
@@ -345,18 +410,7 @@ NvHTTP::verifyResponseStatus(QString xml)
             }
             else
             {
-                QString statusMessage = xmlReader.attributes().value("status_message").toString();
-                if (statusCode != 401) {
-                    // 401 is expected for unpaired PCs when we fetch serverinfo over HTTPS
-                    qWarning() << "Request failed:" << statusCode << statusMessage;
-                }
-                if (statusCode == -1 && statusMessage == "Invalid") {
-                    // Special case handling an audio capture error which GFE doesn't
-                    // provide any useful status message for.
-                    statusCode = 418;
-                    statusMessage = tr("Missing audio capture device. Reinstalling GeForce Experience should resolve this error.");
-                }
-                throw GfeHttpResponseException(statusCode, statusMessage);
+                throwIfStatusError(statusCode, xmlReader.attributes().value("status_message").toString());
             }
         }
     }
@@ -364,19 +418,49 @@ NvHTTP::verifyResponseStatus(QString xml)
     throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
 }
 
-QImage
-NvHTTP::getBoxArt(int appId)
+void
+NvHTTP::verifyResponseStatus(const NvServerInfo& serverInfo)
 {
-    QNetworkReply* reply = openConnection(m_BaseUrlHttps,
-                                          "appasset",
-                                          "appid="+QString::number(appId)+
-                                          "&AssetType=2&AssetIdx=0",
-                                          REQUEST_TIMEOUT_MS,
-                                          NvLogLevel::NVLL_VERBOSE);
-    QImage image = QImageReader(reply).read();
-    delete reply;
+    if (!serverInfo.hasRoot)
+    {
+        throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+    }
 
-    return image;
+    throwIfStatusError(serverInfo.statusCode, serverInfo.statusMessage);
+}
+
+void
+NvHTTP::throwIfStatusError(int statusCode, QString statusMessage)
+{
+    if (statusCode == 200)
+    {
+        // Successful
+        return;
+    }
+
+    if (statusCode != 401) {
+        // 401 is expected for unpaired PCs when we fetch serverinfo over HTTPS
+        qWarning() << "Request failed:" << statusCode << statusMessage;
+    }
+    if (statusCode == -1 && statusMessage == "Invalid") {
+        // Special case handling an audio capture error which GFE doesn't
+        // provide any useful status message for.
+        statusCode = 418;
+        statusMessage = tr("Missing audio capture device. Reinstalling GeForce Experience should resolve this error.");
+    }
+    throw GfeHttpResponseException(statusCode, statusMessage);
+}
+
+QByteArray
+NvHTTP::getBoxArt(int appId)
+{
+    // Return the encoded asset as-is to avoid decoding it here
+    return openConnectionToByteArray(m_BaseUrlHttps,
+                                     "appasset",
+                                     "appid="+QString::number(appId)+
+                                     "&AssetType=2&AssetIdx=0",
+                                     REQUEST_TIMEOUT_MS,
+                                     NvLogLevel::NVLL_VERBOSE);
 }
 
 QByteArray
@@ -460,6 +544,20 @@ NvHTTP::openConnectionToString(QUrl baseUrl,
     return ret;
 }
 
+QByteArray
+NvHTTP::openConnectionToByteArray(QUrl baseUrl,
+                                  QString command,
+                                  QString arguments,
+                                  int timeoutMs,
+                                  NvLogLevel logLevel)
+{
+    QNetworkReply* reply = openConnection(baseUrl, command, arguments, timeoutMs, logLevel);
+    QByteArray ret = reply->readAll();
+    delete reply;
+
+    return ret;
+}
+
 QNetworkReply*
 NvHTTP::openConnection(QUrl baseUrl,
                        QString command,
@@ -484,7 +582,23 @@ NvHTTP::openConnection(QUrl baseUrl,
     QNetworkRequest request(url);
 
     // Add our client certificate
-    request.setSslConfiguration(IdentityManager::get()->getSslConfig());
+    QSslConfiguration sslConfig = IdentityManager::get()->getSslConfig();
+
+    // Resume the last TLS session with this host if we have a ticket for it.
+    // This avoids a full handshake (and client certificate exchange) for
+    // each NvHTTP instance that talks to the host.
+    QString sessionKey = url.host() + ":" + QString::number(url.port());
+    QByteArray offeredSessionTicket;
+    if (url.scheme() == "https") {
+        sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+
+        QMutexLocker locker(&s_TlsSessionLock);
+        offeredSessionTicket = s_TlsSessionTickets.value(sessionKey);
+        if (!offeredSessionTicket.isEmpty()) {
+            sslConfig.setSessionTicket(offeredSessionTicket);
+        }
+    }
+    request.setSslConfiguration(sslConfig);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     // Disable HTTP/2 (GFE 3.22 doesn't like it) and Qt 6 enables it by default
@@ -494,13 +608,51 @@ NvHTTP::openConnection(QUrl baseUrl,
 #if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
     // Use fine-grained idle timeouts to avoid calling QNetworkAccessManager::clearAccessCache(),
     // which tears down the NAM's global thread each time. We must not keep persistent connections
-    // or GFE will puke.
-    request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute, 0);
+    // or GFE will puke, but other hosts can reuse the connection for subsequent requests.
+    request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute,
+                         m_AllowKeepAlive ? KEEPALIVE_TIMEOUT_SECS : 0);
 #endif
 
     auto sslErrorsConnection = connect(m_Nam, &QNetworkAccessManager::sslErrors, this, &NvHTTP::handleSslErrors);
+    QElapsedTimer requestTimer;
+    requestTimer.start();
     QNetworkReply* reply = m_Nam->get(request);
 
+    // This is only emitted when a new TLS connection is established,
+    // not when a kept-alive connection is reused.
+    auto encryptedConnection = connect(reply, &QNetworkReply::encrypted, this, [&]() {
+        // Qt doesn't tell us directly whether the host accepted our ticket. When it does,
+        // the handshake completes with the session we offered, so the session Qt reports
+        // is the one we passed in. A full handshake always yields a new session. Hosts that
+        // issue a fresh ticket while resuming are counted as full handshakes, so this
+        // may undercount resumptions but never overcounts them.
+        bool resumed = !offeredSessionTicket.isEmpty() &&
+                reply->sslConfiguration().sessionTicket() == offeredSessionTicket;
+
+        int handshakes = s_TlsHandshakes.fetchAndAddRelaxed(1) + 1;
+        if (resumed) {
+            s_TlsResumedHandshakes.fetchAndAddRelaxed(1);
+        }
+
+        if (logLevel >= NvLogLevel::NVLL_VERBOSE) {
+            const char* handshakeType;
+            if (resumed) {
+                handshakeType = " (session resumed)";
+            }
+            else if (!offeredSessionTicket.isEmpty()) {
+                handshakeType = " (session ticket rejected)";
+            }
+            else {
+                handshakeType = " (full handshake)";
+            }
+
+            qInfo().nospace() << "TLS handshake with " << sessionKey << " took " << requestTimer.elapsed() << " ms"
+                              << handshakeType
+                              << ": " << s_TlsResumedHandshakes.loadAcquire() << " of " << handshakes
+                              << " handshakes resumed a session";
+        }
+    });
+
     // Run the request with a timeout if requested
     QEventLoop loop;
     connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
@@ -527,6 +679,21 @@ NvHTTP::openConnection(QUrl baseUrl,
     m_Nam->clearAccessCache();
 #endif
     disconnect(sslErrorsConnection);
+    disconnect(encryptedConnection);
+
+    // Save the session ticket for the next request to this host
+    if (url.scheme() == "https" && reply->error() == QNetworkReply::NoError) {
+        QByteArray sessionTicket = reply->sslConfiguration().sessionTicket();
+        if (!sessionTicket.isEmpty()) {
+            QMutexLocker locker(&s_TlsSessionLock);
+            s_TlsSessionTickets.insert(sessionKey, sessionTicket);
+        }
+    }
+    else if (reply->error() == QNetworkReply::SslHandshakeFailedError) {
+        // Don't try to resume a session with a host that rejected our handshake
+        QMutexLocker locker(&s_TlsSessionLock);
+        s_TlsSessionTickets.remove(sessionKey);
+    }
 
     // Handle error
     if (reply->error() != QNetworkReply::NoError)
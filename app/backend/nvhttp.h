@@ -3,6 +3,7 @@
 #include "identitymanager.h"
 #include "nvapp.h"
 #include "nvaddress.h"
+#include "nvserverinfo.h"
 
 #include <Limelight.h>
 
@@ -11,22 +12,7 @@
 #include <QNetworkReply>
 
 class NvComputer;
-
-class NvDisplayMode
-{
-public:
-    bool operator==(const NvDisplayMode& other) const
-    {
-        return width == other.width &&
-                height == other.height &&
-                refreshRate == other.refreshRate;
-    }
-
-    int width;
-    int height;
-    int refreshRate;
-};
-Q_DECLARE_TYPEINFO(NvDisplayMode, Q_PRIMITIVE_TYPE);
+class QXmlStreamReader;
 
 class GfeHttpResponseException : public std::exception
 {
@@ -115,15 +101,19 @@ public:
 
     static
     int
-    getCurrentGame(QString serverInfo);
+    getCurrentGame(const NvServerInfo& serverInfo);
 
-    QString
+    NvServerInfo
     getServerInfo(NvLogLevel logLevel, bool fastFail = false);
 
     static
     void
     verifyResponseStatus(QString xml);
 
+    static
+    void
+    verifyResponseStatus(const NvServerInfo& serverInfo);
+
     static
     QString
     getXmlString(QString xml,
@@ -141,11 +131,22 @@ public:
                            int timeoutMs,
                            NvLogLevel logLevel = NvLogLevel::NVLL_VERBOSE);
 
+    QByteArray
+    openConnectionToByteArray(QUrl baseUrl,
+                              QString command,
+                              QString arguments,
+                              int timeoutMs,
+                              NvLogLevel logLevel = NvLogLevel::NVLL_VERBOSE);
+
     void setServerCert(QSslCertificate serverCert);
 
     void setAddress(NvAddress address);
     void setHttpsPort(uint16_t port);
 
+    // Keeps connections open between requests where supported. GFE hosts can't
+    // handle persistent connections, so this must stay off for them.
+    void setAllowKeepAlive(bool allowKeepAlive);
+
     NvAddress address();
 
     QSslCertificate serverCert();
@@ -175,16 +176,25 @@ public:
     QVector<NvApp>
     getAppList();
 
-    QImage
-    getBoxArt(int appId);
+    // Returns false without parsing if the response matches responseHash.
+    // Otherwise, apps and responseHash are updated with the new app list.
+    bool
+    getAppListIfChanged(QVector<NvApp>& apps, QByteArray& responseHash);
 
-    static
-    QVector<NvDisplayMode>
-    getDisplayModeList(QString serverInfo);
+    QByteArray
+    getBoxArt(int appId);
 
     QUrl m_BaseUrlHttp;
     QUrl m_BaseUrlHttps;
 private:
+    static
+    void
+    throwIfStatusError(int statusCode, QString statusMessage);
+
+    static
+    QVector<NvApp>
+    parseAppList(QXmlStreamReader& xmlReader);
+
     void
     handleSslErrors(QNetworkReply* reply, const QList<QSslError>& errors);
 
@@ -198,4 +208,5 @@ private:
     NvAddress m_Address;
     QNetworkAccessManager* m_Nam;
     QSslCertificate m_ServerCert;
+    bool m_AllowKeepAlive;
 };
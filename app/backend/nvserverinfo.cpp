@@ -0,0 +1,100 @@
+#include "nvserverinfo.h"
+
+#include <QXmlStreamReader>
+
+NvServerInfo
+NvServerInfo::parse(const QByteArray& xml)
+{
+    // QXmlStreamReader decodes the raw bytes itself, so we avoid converting
+    // the whole document to a QString and rescanning it for each field.
+    QXmlStreamReader xmlReader(xml);
+    NvServerInfo info;
+
+    // Like NvHTTP::getXmlString(), the first occurrence of each tag wins
+    auto readField = [&xmlReader](QString& field) {
+        QString text = xmlReader.readElementText();
+        if (field.isNull()) {
+            field = text.isNull() ? QString("") : text;
+        }
+    };
+
+    while (!xmlReader.atEnd())
+    {
+        if (xmlReader.readNext() != QXmlStreamReader::StartElement)
+        {
+            continue;
+        }
+
+        auto name = xmlReader.name();
+        if (name == QLatin1String("root")) {
+            if (!info.hasRoot) {
+                // Status code can be 0xFFFFFFFF in some rare cases on GFE 3.20.3, so
+                // parse it as unsigned and cast the result (see verifyResponseStatus()).
+                info.hasRoot = true;
+                info.statusCode = (int)xmlReader.attributes().value("status_code").toUInt();
+                info.statusMessage = xmlReader.attributes().value("status_message").toString();
+            }
+        }
+        else if (name == QLatin1String("hostname")) {
+            readField(info.hostname);
+        }
+        else if (name == QLatin1String("uniqueid")) {
+            readField(info.uniqueId);
+        }
+        else if (name == QLatin1String("mac")) {
+            readField(info.mac);
+        }
+        else if (name == QLatin1String("LocalIP")) {
+            readField(info.localIp);
+        }
+        else if (name == QLatin1String("ExternalIP")) {
+            readField(info.externalIp);
+        }
+        else if (name == QLatin1String("ExternalPort")) {
+            readField(info.externalPort);
+        }
+        else if (name == QLatin1String("HttpsPort")) {
+            readField(info.httpsPort);
+        }
+        else if (name == QLatin1String("state")) {
+            readField(info.state);
+        }
+        else if (name == QLatin1String("currentgame")) {
+            readField(info.currentGame);
+        }
+        else if (name == QLatin1String("PairStatus")) {
+            readField(info.pairStatus);
+        }
+        else if (name == QLatin1String("appversion")) {
+            readField(info.appVersion);
+        }
+        else if (name == QLatin1String("GfeVersion")) {
+            readField(info.gfeVersion);
+        }
+        else if (name == QLatin1String("gputype")) {
+            readField(info.gpuType);
+        }
+        else if (name == QLatin1String("ServerCodecModeSupport")) {
+            readField(info.serverCodecModeSupport);
+        }
+        else if (name == QLatin1String("MaxLumaPixelsHEVC")) {
+            readField(info.maxLumaPixelsHEVC);
+        }
+        else if (name == QLatin1String("DisplayMode")) {
+            info.displayModes.append(NvDisplayMode());
+        }
+        else if (!info.displayModes.isEmpty()) {
+            if (name == QLatin1String("Width")) {
+                info.displayModes.last().width = xmlReader.readElementText().toInt();
+            }
+            else if (name == QLatin1String("Height")) {
+                info.displayModes.last().height = xmlReader.readElementText().toInt();
+            }
+            else if (name == QLatin1String("RefreshRate")) {
+                info.displayModes.last().refreshRate = xmlReader.readElementText().toInt();
+            }
+        }
+    }
+
+    return info;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+class NvDisplayMode
+{
+public:
+    bool operator==(const NvDisplayMode& other) const
+    {
+        return width == other.width &&
+                height == other.height &&
+                refreshRate == other.refreshRate;
+    }
+
+    int width;
+    int height;
+    int refreshRate;
+};
+Q_DECLARE_TYPEINFO(NvDisplayMode, Q_PRIMITIVE_TYPE);
+
+// Typed view of a serverinfo response, populated in a single pass over
+// the XML. Fields are null if the tag was missing from the response.
+class NvServerInfo
+{
+public:
+    static NvServerInfo parse(const QByteArray& xml);
+
+    bool isValid() const
+    {
+        return hasRoot && statusCode == 200;
+    }
+
+    bool hasRoot = false;
+    int statusCode = -1;
+    QString statusMessage;
+
+    QString hostname;
+    QString uniqueId;
+    QString mac;
+    QString localIp;
+    QString externalIp;
+    QString externalPort;
+    QString httpsPort;
+    QString state;
+    QString currentGame;
+    QString pairStatus;
+    QString appVersion;
+    QString gfeVersion;
+    QString gpuType;
+    QString serverCodecModeSupport;
+    QString maxLumaPixelsHEVC;
+    QVector<NvDisplayMode> displayModes;
+};
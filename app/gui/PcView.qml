@@ -12,6 +12,10 @@ import SdlGamepadKeyNavigation 1.0
 CenteredGridView {
     property ComputerModel computerModel : createModel()
 
+    // UUID of the PC that we're waking to continue into its app grid. Rows
+    // can move while it wakes up, so we can't hold onto its index.
+    property string wakingPcUuid: ""
+
     id: pcGrid
     focus: true
     activeFocusOnTab: true
@@ -42,6 +46,7 @@ CenteredGridView {
 
     StackView.onDeactivating: {
         ComputerManager.computerAddCompleted.disconnect(addComplete)
+        wakingPcUuid = ""
     }
 
     function pairingComplete(error)
@@ -111,6 +116,19 @@ CenteredGridView {
         grid: pcGrid
 
         property alias pcContextMenu : pcContextMenuLoader.item
+        property bool pcOnline : model.online
+
+        onPcOnlineChanged: {
+            // Continue straight to the app grid when a PC we woke is ready
+            if (pcOnline && model.uuid === pcGrid.wakingPcUuid) {
+                pcGrid.wakingPcUuid = ""
+                if (model.paired && model.serverSupported) {
+                    var component = Qt.createComponent("AppView.qml")
+                    var appView = component.createObject(stackView, {"computerIndex": index, "objectName": model.name})
+                    stackView.push(appView)
+                }
+            }
+        }
 
         Image {
             id: pcIcon
@@ -182,7 +200,10 @@ CenteredGridView {
                 }
                 NavigableMenuItem {
                     text: qsTr("Wake PC")
-                    onTriggered: computerModel.wakeComputer(index)
+                    onTriggered: {
+                        pcGrid.wakingPcUuid = model.uuid
+                        computerModel.wakeComputer(index)
+                    }
                     visible: !model.online && model.wakeable
                 }
                 NavigableMenuItem {
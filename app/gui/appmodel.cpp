@@ -18,6 +18,8 @@ void AppModel::initialize(ComputerManager* computerManager, int computerIndex, b
     m_CurrentGameId = m_Computer->currentGameId;
     m_ShowHiddenGames = showHiddenGames;
 
+    m_ComputerManager->loadAppList(m_Computer);
+
     updateAppList(m_Computer->appList);
 }
 
@@ -118,26 +120,23 @@ void AppModel::quitRunningApp()
     m_ComputerManager->quitRunningApp(m_Computer);
 }
 
-bool AppModel::isAppCurrentlyVisible(const NvApp& app)
-{
-    for (const NvApp& visibleApp : std::as_const(m_VisibleApps)) {
-        if (app.id == visibleApp.id) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 QVector<NvApp> AppModel::getVisibleApps(const QVector<NvApp>& appList)
 {
     QVector<NvApp> visibleApps;
 
+    QSet<int> currentlyVisibleAppIds;
+    if (!m_ShowHiddenGames) {
+        currentlyVisibleAppIds.reserve(m_VisibleApps.count());
+        for (const NvApp& visibleApp : std::as_const(m_VisibleApps)) {
+            currentlyVisibleAppIds.insert(visibleApp.id);
+        }
+    }
+
     for (const NvApp& app : appList) {
         // Don't immediately hide games that were previously visible. This
         // allows users to easily uncheck the "Hide App" checkbox if they
         // check it by mistake.
-        if (m_ShowHiddenGames || !app.hidden || isAppCurrentlyVisible(app)) {
+        if (m_ShowHiddenGames || !app.hidden || currentlyVisibleAppIds.contains(app.id)) {
             visibleApps.append(app);
         }
     }
@@ -145,64 +144,100 @@ QVector<NvApp> AppModel::getVisibleApps(const QVector<NvApp>& appList)
     return visibleApps;
 }
 
+QVector<int> AppModel::getChangedRoles(const NvApp& oldApp, const NvApp& newApp)
+{
+    QVector<int> roles;
+
+    if (oldApp.hidden != newApp.hidden) {
+        roles << HiddenRole;
+    }
+    if (oldApp.directLaunch != newApp.directLaunch) {
+        roles << DirectLaunchRole;
+    }
+    if (oldApp.isAppCollectorGame != newApp.isAppCollectorGame) {
+        roles << AppCollectorGameRole;
+    }
+
+    return roles;
+}
+
 void AppModel::updateAppList(QVector<NvApp> newList)
 {
     m_AllApps = newList;
 
     QVector<NvApp> newVisibleList = getVisibleApps(newList);
 
-    // Process removals and updates first
-    for (int i = 0; i < m_VisibleApps.count(); i++) {
-        const NvApp& existingApp = m_VisibleApps.at(i);
-
-        bool found = false;
-        for (const NvApp& newApp : std::as_const(newVisibleList)) {
-            if (existingApp.id == newApp.id) {
-                // If the data changed, update it in our list
-                if (existingApp != newApp) {
-                    m_VisibleApps.replace(i, newApp);
-                    emit dataChanged(createIndex(i, 0), createIndex(i, 0));
-                }
+    QHash<int, int> newIndexById;
+    newIndexById.reserve(newVisibleList.count());
+    for (int i = 0; i < newVisibleList.count(); i++) {
+        newIndexById.insert(newVisibleList[i].id, i);
+    }
 
-                found = true;
-                break;
+    // Process removals and updates first. Renamed apps are removed here
+    // and reinserted below, since their position in the list may change.
+    auto isRemoved = [&](const NvApp& existingApp) {
+        auto it = newIndexById.constFind(existingApp.id);
+        return it == newIndexById.constEnd() || newVisibleList[*it].name != existingApp.name;
+    };
+    for (int i = 0; i < m_VisibleApps.count();) {
+        if (isRemoved(m_VisibleApps[i])) {
+            // Remove contiguous runs of apps at once
+            int last = i;
+            while (last + 1 < m_VisibleApps.count() && isRemoved(m_VisibleApps[last + 1])) {
+                last++;
             }
-        }
 
-        if (!found) {
-            beginRemoveRows(QModelIndex(), i, i);
-            m_VisibleApps.removeAt(i);
+            beginRemoveRows(QModelIndex(), i, last);
+            m_VisibleApps.remove(i, last - i + 1);
             endRemoveRows();
-            i--;
+            continue;
         }
-    }
 
-    // Process additions now
-    for (const NvApp& newApp : std::as_const(newVisibleList)) {
-        int insertionIndex = m_VisibleApps.size();
-        bool found = false;
+        // If the data changed, update it in our list
+        const NvApp& newApp = newVisibleList[newIndexById.value(m_VisibleApps[i].id)];
+        if (m_VisibleApps[i] != newApp) {
+            QVector<int> roles = getChangedRoles(m_VisibleApps[i], newApp);
+            m_VisibleApps.replace(i, newApp);
+            if (!roles.isEmpty()) {
+                emit dataChanged(createIndex(i, 0), createIndex(i, 0), roles);
+            }
+        }
 
-        for (int i = 0; i < m_VisibleApps.count(); i++) {
-            const NvApp& existingApp = m_VisibleApps.at(i);
+        i++;
+    }
 
-            if (existingApp.id == newApp.id) {
-                found = true;
-                break;
-            }
-            else if (existingApp.name.toLower() > newApp.name.toLower()) {
-                insertionIndex = i;
-                break;
-            }
+    // Both lists are in the same order now, so additions can be merged
+    // in with a single pass over each of them.
+    int existingIndex = 0;
+    for (int newIndex = 0; newIndex < newVisibleList.count();) {
+        if (existingIndex < m_VisibleApps.count() &&
+                m_VisibleApps[existingIndex].id == newVisibleList[newIndex].id) {
+            existingIndex++;
+            newIndex++;
+            continue;
+        }
+
+        // Insert contiguous runs of new apps at once
+        int first = newIndex;
+        while (newIndex < newVisibleList.count() &&
+               (existingIndex >= m_VisibleApps.count() ||
+                m_VisibleApps[existingIndex].id != newVisibleList[newIndex].id)) {
+            newIndex++;
         }
 
-        if (!found) {
-            beginInsertRows(QModelIndex(), insertionIndex, insertionIndex);
-            m_VisibleApps.insert(insertionIndex, newApp);
-            endInsertRows();
+        beginInsertRows(QModelIndex(), existingIndex, existingIndex + (newIndex - first) - 1);
+        for (int i = first; i < newIndex; i++) {
+            m_VisibleApps.insert(existingIndex++, newVisibleList[i]);
         }
+        endInsertRows();
     }
 
-    Q_ASSERT(newVisibleList == m_VisibleApps);
+    // This only happens if the host reordered apps with identical names
+    if (newVisibleList != m_VisibleApps) {
+        beginResetModel();
+        m_VisibleApps = newVisibleList;
+        endResetModel();
+    }
 }
 
 void AppModel::setAppHidden(int appIndex, bool hidden)
@@ -60,7 +60,7 @@ private:
 
     QVector<NvApp> getVisibleApps(const QVector<NvApp>& appList);
 
-    bool isAppCurrentlyVisible(const NvApp& app);
+    static QVector<int> getChangedRoles(const NvApp& oldApp, const NvApp& newApp);
 
     NvComputer* m_Computer;
     BoxArtManager m_BoxArtManager;
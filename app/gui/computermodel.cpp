@@ -82,6 +82,8 @@ QVariant ComputerModel::data(const QModelIndex& index, int role) const
                tr("Running Game ID: %1").arg(computer->state == NvComputer::CS_ONLINE ? QString::number(computer->currentGameId) : tr("Unknown")) + '\n' +
                tr("HTTPS Port: %1").arg(computer->state == NvComputer::CS_ONLINE ? QString::number(computer->activeHttpsPort) : tr("Unknown"));
     }
+    case UuidRole:
+        return computer->uuid;
     default:
         return QVariant();
     }
@@ -110,6 +112,7 @@ QHash<int, QByteArray> ComputerModel::roleNames() const
     names[StatusUnknownRole] = "statusUnknown";
     names[ServerSupportedRole] = "serverSupported";
     names[DetailsRole] = "details";
+    names[UuidRole] = "uuid";
 
     return names;
 }
@@ -123,6 +126,8 @@ Session* ComputerModel::createSessionForCurrentGame(int computerIndex)
     // We must currently be streaming a game to use this function
     Q_ASSERT(computer->currentGameId != 0);
 
+    m_ComputerManager->loadAppList(computer);
+
     for (NvApp& app : computer->appList) {
         if (app.id == computer->currentGameId) {
             return new Session(computer, app);
@@ -149,27 +154,11 @@ void ComputerModel::deleteComputer(int computerIndex)
     endRemoveRows();
 }
 
-class DeferredWakeHostTask : public QRunnable
-{
-public:
-    DeferredWakeHostTask(NvComputer* computer)
-        : m_Computer(computer) {}
-
-    void run()
-    {
-        m_Computer->wake();
-    }
-
-private:
-    NvComputer* m_Computer;
-};
-
 void ComputerModel::wakeComputer(int computerIndex)
 {
     Q_ASSERT(computerIndex < m_Computers.count());
 
-    DeferredWakeHostTask* wakeTask = new DeferredWakeHostTask(m_Computers[computerIndex]);
-    QThreadPool::globalInstance()->start(wakeTask);
+    m_ComputerManager->wakeHost(m_Computers[computerIndex]);
 }
 
 void ComputerModel::renameComputer(int computerIndex, QString name)
@@ -9,6 +9,14 @@
 
 #include <Limelight.h>
 
+#include <chrono>
+
+// Helper function to get current time in microseconds
+static inline uint64_t getMicroseconds() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 #define TRY_INIT_RENDERER(renderer, opusConfig)        \
 {                                                      \
     IAudioRenderer* __renderer = new renderer();       \
@@ -66,6 +74,8 @@ bool Session::initializeAudioRenderer()
         return false;
     }
 
+    m_AudioRenderer->setAudioStats(&m_ActiveWndAudioStats);
+
     // Allow the chosen renderer to remap Opus channels as needed to ensure proper output
     m_ActiveAudioConfig = m_OriginalAudioConfig;
     m_AudioRenderer->remapChannels(&m_ActiveAudioConfig);
@@ -140,6 +150,10 @@ int Session::arInit(int /* audioConfiguration */,
 
 void Session::arCleanup()
 {
+    // The audio thread has terminated, so we're the only ones touching these now
+    s_ActiveSession->addAudioStats(s_ActiveSession->m_ActiveWndAudioStats, s_ActiveSession->m_GlobalAudioStats);
+    s_ActiveSession->logAudioStats(s_ActiveSession->m_GlobalAudioStats, "Global audio stats");
+
     delete s_ActiveSession->m_AudioRenderer;
     s_ActiveSession->m_AudioRenderer = nullptr;
 
@@ -149,7 +163,8 @@ void Session::arCleanup()
 
 void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
 {
-    int samplesDecoded;
+    AUDIO_STATS& activeStats = s_ActiveSession->m_ActiveWndAudioStats;
+    uint64_t nowUs = getMicroseconds();
 
 #ifndef STEAM_LINK
     // Set this thread to high priority to reduce the chance of missing
@@ -165,6 +180,27 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
     }
 #endif
 
+    // Flip stats windows roughly every second
+    if (activeStats.measurementStartUs == 0) {
+        activeStats.measurementStartUs = nowUs;
+    }
+    else if (nowUs > activeStats.measurementStartUs + 1000000) {
+        // Only the overlay and stats exporter read these windows from another thread
+        SDL_AtomicLock(&s_ActiveSession->m_AudioStatsLock);
+        s_ActiveSession->addAudioStats(activeStats, s_ActiveSession->m_GlobalAudioStats);
+        SDL_memcpy(&s_ActiveSession->m_LastWndAudioStats, &activeStats, sizeof(activeStats));
+        SDL_AtomicUnlock(&s_ActiveSession->m_AudioStatsLock);
+
+        s_ActiveSession->m_StatsExporter.submitAudioStats(activeStats);
+
+        SDL_zero(activeStats);
+        activeStats.measurementStartUs = nowUs;
+    }
+
+    if (sampleData != nullptr) {
+        activeStats.receivedPackets++;
+    }
+
     // See if we need to drop this sample
     if (s_ActiveSession->m_DropAudioEndTime != 0) {
         if (SDL_TICKS_PASSED(SDL_GetTicks(), s_ActiveSession->m_DropAudioEndTime)) {
@@ -176,6 +212,10 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
         }
         else {
             // We're still in the drop window
+            if (sampleData != nullptr) {
+                activeStats.dropWindowPackets++;
+            }
+            s_ActiveSession->m_AudioLossPending = false;
             return;
         }
     }
@@ -184,53 +224,46 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
 
     // If audio is muted, don't decode or play the audio
     if (s_ActiveSession->m_AudioMuted) {
+        s_ActiveSession->m_AudioLossPending = false;
         return;
     }
 
     if (s_ActiveSession->m_AudioRenderer != nullptr) {
-        int sampleSize = s_ActiveSession->m_AudioRenderer->getAudioBufferSampleSize();
-        int frameSize = sampleSize * s_ActiveSession->m_ActiveAudioConfig.channelCount;
-        int desiredBufferSize = frameSize * s_ActiveSession->m_ActiveAudioConfig.samplesPerFrame;
-        void* buffer = s_ActiveSession->m_AudioRenderer->getAudioBuffer(&desiredBufferSize);
-        if (buffer == nullptr) {
-            return;
-        }
-
-        if (s_ActiveSession->m_AudioRenderer->getAudioBufferFormat() == IAudioRenderer::AudioFormat::Float32NE) {
-            samplesDecoded = opus_multistream_decode_float(s_ActiveSession->m_OpusDecoder,
-                                                           (unsigned char*)sampleData,
-                                                           sampleLength,
-                                                           (float*)buffer,
-                                                           desiredBufferSize / frameSize,
-                                                           0);
-        }
-        else {
-            samplesDecoded = opus_multistream_decode(s_ActiveSession->m_OpusDecoder,
-                                                     (unsigned char*)sampleData,
-                                                     sampleLength,
-                                                     (short*)buffer,
-                                                     desiredBufferSize / frameSize,
-                                                     0);
-        }
-
-        // Update desiredSize with the number of bytes actually populated by the decoding operation
-        if (samplesDecoded > 0) {
-            SDL_assert(desiredBufferSize >= frameSize * samplesDecoded);
-            desiredBufferSize = frameSize * samplesDecoded;
+        bool rendererOk = true;
+
+        // moonlight-common-c signals a lost packet by passing a NULL buffer. Rather
+        // than concealing it immediately, we wait for the next packet so we can try
+        // to recover the lost audio from its in-band FEC data. If we're already
+        // waiting on a lost packet, conceal that one now to keep the renderer fed.
+        if (sampleData == nullptr) {
+            if (s_ActiveSession->m_AudioLossPending) {
+                rendererOk = s_ActiveSession->decodeAndSubmitAudio(nullptr, 0, false);
+            }
+            s_ActiveSession->m_AudioLossPending = true;
         }
         else {
-            desiredBufferSize = 0;
+            if (s_ActiveSession->m_AudioLossPending) {
+                s_ActiveSession->m_AudioLossPending = false;
+                rendererOk = s_ActiveSession->decodeAndSubmitAudio(sampleData, sampleLength, true);
+            }
+
+            if (rendererOk) {
+                rendererOk = s_ActiveSession->decodeAndSubmitAudio(sampleData, sampleLength, false);
+            }
         }
 
-        if (!s_ActiveSession->m_AudioRenderer->submitAudio(desiredBufferSize)) {
+        if (!rendererOk) {
             SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
                         "Reinitializing audio renderer after failure");
+            activeStats.reinitializations++;
 
             opus_multistream_decoder_destroy(s_ActiveSession->m_OpusDecoder);
             s_ActiveSession->m_OpusDecoder = nullptr;
 
             delete s_ActiveSession->m_AudioRenderer;
             s_ActiveSession->m_AudioRenderer = nullptr;
+
+            s_ActiveSession->m_AudioLossPending = false;
         }
     }
 
@@ -253,3 +286,170 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
         }
     }
 }
+
+bool Session::decodeAndSubmitAudio(char* sampleData, int sampleLength, bool decodeFec)
+{
+    AUDIO_STATS& activeStats = m_ActiveWndAudioStats;
+    int samplesDecoded;
+
+    int sampleSize = m_AudioRenderer->getAudioBufferSampleSize();
+    int frameSize = sampleSize * m_ActiveAudioConfig.channelCount;
+    int desiredBufferSize = frameSize * m_ActiveAudioConfig.samplesPerFrame;
+    void* buffer = m_AudioRenderer->getAudioBuffer(&desiredBufferSize);
+    if (buffer == nullptr) {
+        return true;
+    }
+
+    // A NULL buffer invokes Opus packet loss concealment. When concealing or
+    // decoding FEC data, the frame size must match the duration of the lost
+    // packet exactly, since Opus will synthesize exactly that many samples.
+    int maxSamples = desiredBufferSize / frameSize;
+    if (sampleData == nullptr || decodeFec) {
+        maxSamples = SDL_min(maxSamples, m_ActiveAudioConfig.samplesPerFrame);
+    }
+
+    uint64_t decodeStartUs = getMicroseconds();
+    if (m_AudioRenderer->getAudioBufferFormat() == IAudioRenderer::AudioFormat::Float32NE) {
+        samplesDecoded = opus_multistream_decode_float(m_OpusDecoder,
+                                                       (unsigned char*)sampleData,
+                                                       sampleLength,
+                                                       (float*)buffer,
+                                                       maxSamples,
+                                                       decodeFec ? 1 : 0);
+    }
+    else {
+        samplesDecoded = opus_multistream_decode(m_OpusDecoder,
+                                                 (unsigned char*)sampleData,
+                                                 sampleLength,
+                                                 (short*)buffer,
+                                                 maxSamples,
+                                                 decodeFec ? 1 : 0);
+    }
+
+    activeStats.totalDecodeTimeUs += getMicroseconds() - decodeStartUs;
+
+    // Update desiredSize with the number of bytes actually populated by the decoding operation
+    if (samplesDecoded > 0) {
+        if (sampleData == nullptr || decodeFec) {
+            activeStats.concealedPackets++;
+        }
+        else {
+            activeStats.decodedPackets++;
+        }
+
+        SDL_assert(desiredBufferSize >= frameSize * samplesDecoded);
+        desiredBufferSize = frameSize * samplesDecoded;
+    }
+    else {
+        desiredBufferSize = 0;
+    }
+
+    if (!m_AudioRenderer->submitAudio(desiredBufferSize)) {
+        return false;
+    }
+    else if (desiredBufferSize > 0) {
+        // This sample waited in the audio queue for roughly the duration still
+        // pending behind it, and will play once the renderer's queue drains.
+        uint64_t queuedTimeUs = LiGetPendingAudioDuration() * 1000ULL +
+                                m_AudioRenderer->getOutputLatencyUs();
+        m_AVSyncTracker.submitAudioLatency(queuedTimeUs);
+
+        activeStats.totalQueuedTimeUs += queuedTimeUs;
+        activeStats.maxQueuedTimeUs = qMax(activeStats.maxQueuedTimeUs, (uint32_t)queuedTimeUs);
+        activeStats.queuedTimeSamples++;
+    }
+
+    return true;
+}
+
+void Session::addAudioStats(AUDIO_STATS& src, AUDIO_STATS& dst)
+{
+    dst.receivedPackets += src.receivedPackets;
+    dst.decodedPackets += src.decodedPackets;
+    dst.droppedPackets += src.droppedPackets;
+    dst.dropWindowPackets += src.dropWindowPackets;
+    dst.concealedPackets += src.concealedPackets;
+    dst.underruns += src.underruns;
+    dst.reinitializations += src.reinitializations;
+    dst.totalDecodeTimeUs += src.totalDecodeTimeUs;
+    dst.totalQueuedTimeUs += src.totalQueuedTimeUs;
+    dst.maxQueuedTimeUs = qMax(dst.maxQueuedTimeUs, src.maxQueuedTimeUs);
+    dst.queuedTimeSamples += src.queuedTimeSamples;
+
+    // Initialize the measurement start point if this is the first audio stat window
+    if (!dst.measurementStartUs) {
+        dst.measurementStartUs = src.measurementStartUs;
+    }
+}
+
+void Session::stringifyAudioStats(AUDIO_STATS& stats, char* output, int length)
+{
+    int offset = 0;
+    int ret;
+
+    // Start with an empty string
+    output[offset] = 0;
+
+    if (stats.receivedPackets == 0) {
+        return;
+    }
+
+    ret = snprintf(&output[offset],
+                   length - offset,
+                   "Audio stream: %d channels at %d Hz\n"
+                   "Audio packets dropped due to queued audio: %.2f%%\n"
+                   "Audio packets concealed: %u, underruns: %u, reinitializations: %u\n",
+                   m_ActiveAudioConfig.channelCount,
+                   m_ActiveAudioConfig.sampleRate,
+                   (float)(stats.droppedPackets + stats.dropWindowPackets) / stats.receivedPackets * 100,
+                   stats.concealedPackets,
+                   stats.underruns,
+                   stats.reinitializations);
+    if (ret < 0 || ret >= length - offset) {
+        SDL_assert(false);
+        return;
+    }
+
+    offset += ret;
+
+    if (stats.decodedPackets != 0 && stats.queuedTimeSamples != 0) {
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "Average audio decoding time: %.2f ms\n"
+                       "Audio queue delay average/max: %.1f/%.1f ms\n",
+                       (double)(stats.totalDecodeTimeUs / 1000.0) / stats.decodedPackets,
+                       (double)(stats.totalQueuedTimeUs / 1000.0) / stats.queuedTimeSamples,
+                       stats.maxQueuedTimeUs / 1000.0);
+        if (ret < 0 || ret >= length - offset) {
+            SDL_assert(false);
+            return;
+        }
+
+        offset += ret;
+    }
+}
+
+void Session::stringifyLastAudioStats(char* output, int length)
+{
+    AUDIO_STATS lastWndStats;
+
+    // The active window is owned by the audio thread, so we can
+    // only display the most recently completed window here.
+    SDL_AtomicLock(&m_AudioStatsLock);
+    SDL_memcpy(&lastWndStats, &m_LastWndAudioStats, sizeof(lastWndStats));
+    SDL_AtomicUnlock(&m_AudioStatsLock);
+
+    stringifyAudioStats(lastWndStats, output, length);
+}
+
+void Session::logAudioStats(AUDIO_STATS& stats, const char* title)
+{
+    if (stats.receivedPackets != 0) {
+        char audioStatsStr[512];
+        stringifyAudioStats(stats, audioStatsStr, sizeof(audioStatsStr));
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "\n%s\n------------------\n%s",
+                    title, audioStatsStr);
+    }
+}
@@ -0,0 +1,331 @@
+#include "channelmixer.h"
+
+#include "SDL_compat.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MIXER_USE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIXER_USE_NEON
+#endif
+
+// Channel indices in Moonlight's default channel order
+#define CH_FL 0
+#define CH_FR 1
+#define CH_C 2
+#define CH_LFE 3
+#define CH_RL 4
+#define CH_RR 5
+#define CH_SL 6
+#define CH_SR 7
+
+// -3 dB for center and surround channels folded into the fronts
+#define MIX_LEVEL_3DB 0.70710678f
+
+// -6 dB for LFE folded into the fronts
+#define MIX_LEVEL_LFE 0.5f
+
+// The limiter keeps peaks just under full scale and recovers
+// roughly 5% of the remaining headroom per processed buffer
+#define LIMITER_THRESHOLD 0.98f
+#define LIMITER_RELEASE 0.05f
+
+AudioChannelMixer::AudioChannelMixer()
+    : m_InputChannels(0),
+      m_OutputChannels(0),
+      m_Volume(1.0f),
+      m_LimiterGain(1.0f)
+{
+    SDL_zero(m_Matrix);
+}
+
+bool AudioChannelMixer::isConversionSupported(int inputChannels, int outputChannels)
+{
+    if (inputChannels <= 0 || inputChannels > AUDIO_MIXER_MAX_CHANNELS ||
+            outputChannels <= 0 || outputChannels > AUDIO_MIXER_MAX_CHANNELS) {
+        return false;
+    }
+    else if (inputChannels == outputChannels) {
+        // Volume and limiter only
+        return true;
+    }
+    else if (inputChannels != 6 && inputChannels != 8) {
+        // Only surround streams can be folded down
+        return false;
+    }
+
+    switch (outputChannels) {
+    case 1:
+    case 2:
+    case 4:
+        return true;
+    case 6:
+        return inputChannels == 8;
+    default:
+        return false;
+    }
+}
+
+bool AudioChannelMixer::initialize(int inputChannels, int outputChannels)
+{
+    if (!isConversionSupported(inputChannels, outputChannels)) {
+        return false;
+    }
+
+    m_InputChannels = inputChannels;
+    m_OutputChannels = outputChannels;
+    m_LimiterGain = 1.0f;
+
+    // Start with an identity matrix and fold the layout down one stage at a time
+    float matrix[AUDIO_MIXER_MAX_CHANNELS][AUDIO_MIXER_MAX_CHANNELS] = {};
+    for (int i = 0; i < inputChannels; i++) {
+        matrix[i][i] = 1.0f;
+    }
+
+    int channels = inputChannels;
+
+    // 7.1 -> 5.1: Fold the side channels into the surrounds
+    if (channels == 8 && outputChannels < 8) {
+        for (int i = 0; i < inputChannels; i++) {
+            float sl = matrix[CH_SL][i];
+            float sr = matrix[CH_SR][i];
+
+            matrix[CH_RL][i] = MIX_LEVEL_3DB * (matrix[CH_RL][i] + sl);
+            matrix[CH_RR][i] = MIX_LEVEL_3DB * (matrix[CH_RR][i] + sr);
+            matrix[CH_SL][i] = matrix[CH_SR][i] = 0.0f;
+        }
+
+        channels = 6;
+    }
+
+    // 5.1 -> quad: Fold the center and LFE into the fronts and move the surrounds down
+    if (channels == 6 && outputChannels < 6) {
+        for (int i = 0; i < inputChannels; i++) {
+            float center = matrix[CH_C][i] * MIX_LEVEL_3DB + matrix[CH_LFE][i] * MIX_LEVEL_LFE;
+            float rl = matrix[CH_RL][i];
+            float rr = matrix[CH_RR][i];
+
+            matrix[CH_FL][i] += center;
+            matrix[CH_FR][i] += center;
+            matrix[2][i] = rl;
+            matrix[3][i] = rr;
+            matrix[4][i] = matrix[5][i] = 0.0f;
+        }
+
+        channels = 4;
+    }
+
+    // Quad -> stereo: Fold the surrounds into the fronts
+    if (channels == 4 && outputChannels < 4) {
+        for (int i = 0; i < inputChannels; i++) {
+            matrix[0][i] += matrix[2][i] * MIX_LEVEL_3DB;
+            matrix[1][i] += matrix[3][i] * MIX_LEVEL_3DB;
+            matrix[2][i] = matrix[3][i] = 0.0f;
+        }
+
+        channels = 2;
+    }
+
+    // Stereo -> mono
+    if (channels == 2 && outputChannels < 2) {
+        for (int i = 0; i < inputChannels; i++) {
+            matrix[0][i] = 0.5f * (matrix[0][i] + matrix[1][i]);
+            matrix[1][i] = 0.0f;
+        }
+
+        channels = 1;
+    }
+
+    SDL_assert(channels == outputChannels);
+    SDL_memcpy(m_Matrix, matrix, sizeof(m_Matrix));
+
+    if (inputChannels != outputChannels) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Downmixing %d channel audio to %d channels",
+                    inputChannels,
+                    outputChannels);
+    }
+
+    return true;
+}
+
+void AudioChannelMixer::setVolume(float volume)
+{
+    m_Volume = SDL_max(volume, 0.0f);
+}
+
+bool AudioChannelMixer::isPassthrough()
+{
+    return m_InputChannels == m_OutputChannels && m_Volume == 1.0f;
+}
+
+int AudioChannelMixer::getInputChannels()
+{
+    return m_InputChannels;
+}
+
+int AudioChannelMixer::getOutputChannels()
+{
+    return m_OutputChannels;
+}
+
+void AudioChannelMixer::process(float* buffer, int frames)
+{
+    if (frames <= 0 || isPassthrough()) {
+        return;
+    }
+
+    if (m_InputChannels != m_OutputChannels) {
+        if (m_OutputChannels == 2) {
+            downmixStereo(buffer, frames);
+        }
+        else {
+            downmixGeneric(buffer, frames);
+        }
+    }
+
+    applyGainAndLimit(buffer, frames * m_OutputChannels);
+}
+
+void AudioChannelMixer::downmixGeneric(float* buffer, int frames)
+{
+    float in[AUDIO_MIXER_MAX_CHANNELS];
+
+    // Output frames are never larger than input frames, so processing
+    // front to back never overwrites input samples we haven't read yet.
+    for (int i = 0; i < frames; i++) {
+        SDL_memcpy(in, &buffer[i * m_InputChannels], m_InputChannels * sizeof(float));
+
+        float* out = &buffer[i * m_OutputChannels];
+        for (int o = 0; o < m_OutputChannels; o++) {
+            float sample = 0.0f;
+            for (int c = 0; c < m_InputChannels; c++) {
+                sample += m_Matrix[o][c] * in[c];
+            }
+            out[o] = sample;
+        }
+    }
+}
+
+void AudioChannelMixer::downmixStereo(float* buffer, int frames)
+{
+    int i = 0;
+
+#if defined(MIXER_USE_SSE) || defined(MIXER_USE_NEON)
+    // The vector path always loads 8 samples per input frame, so the
+    // final frame of a 5.1 stream must be left for the scalar path.
+    int vectorFrames = m_InputChannels == 8 ? frames : frames - 1;
+    int stride = m_InputChannels;
+
+#if defined(MIXER_USE_SSE)
+    const __m128 l0 = _mm_loadu_ps(&m_Matrix[0][0]);
+    const __m128 l1 = _mm_loadu_ps(&m_Matrix[0][4]);
+    const __m128 r0 = _mm_loadu_ps(&m_Matrix[1][0]);
+    const __m128 r1 = _mm_loadu_ps(&m_Matrix[1][4]);
+
+    for (; i + 2 <= vectorFrames; i += 2) {
+        const float* f0 = &buffer[i * stride];
+        const float* f1 = f0 + stride;
+
+        __m128 a0 = _mm_loadu_ps(f0);
+        __m128 b0 = _mm_loadu_ps(f0 + 4);
+        __m128 a1 = _mm_loadu_ps(f1);
+        __m128 b1 = _mm_loadu_ps(f1 + 4);
+
+        __m128 outL0 = _mm_add_ps(_mm_mul_ps(a0, l0), _mm_mul_ps(b0, l1));
+        __m128 outR0 = _mm_add_ps(_mm_mul_ps(a0, r0), _mm_mul_ps(b0, r1));
+        __m128 outL1 = _mm_add_ps(_mm_mul_ps(a1, l0), _mm_mul_ps(b1, l1));
+        __m128 outR1 = _mm_add_ps(_mm_mul_ps(a1, r0), _mm_mul_ps(b1, r1));
+
+        // Transpose and sum to get the horizontal sums as L0, R0, L1, R1
+        _MM_TRANSPOSE4_PS(outL0, outR0, outL1, outR1);
+        __m128 out = _mm_add_ps(_mm_add_ps(outL0, outR0), _mm_add_ps(outL1, outR1));
+
+        // This is behind the read position of the next iteration
+        _mm_storeu_ps(&buffer[i * 2], out);
+    }
+#else
+    const float32x4_t l0 = vld1q_f32(&m_Matrix[0][0]);
+    const float32x4_t l1 = vld1q_f32(&m_Matrix[0][4]);
+    const float32x4_t r0 = vld1q_f32(&m_Matrix[1][0]);
+    const float32x4_t r1 = vld1q_f32(&m_Matrix[1][4]);
+
+    for (; i + 2 <= vectorFrames; i += 2) {
+        const float* f0 = &buffer[i * stride];
+        const float* f1 = f0 + stride;
+
+        float32x4_t a0 = vld1q_f32(f0);
+        float32x4_t b0 = vld1q_f32(f0 + 4);
+        float32x4_t a1 = vld1q_f32(f1);
+        float32x4_t b1 = vld1q_f32(f1 + 4);
+
+        float32x4_t outL0 = vmlaq_f32(vmulq_f32(a0, l0), b0, l1);
+        float32x4_t outR0 = vmlaq_f32(vmulq_f32(a0, r0), b0, r1);
+        float32x4_t outL1 = vmlaq_f32(vmulq_f32(a1, l0), b1, l1);
+        float32x4_t outR1 = vmlaq_f32(vmulq_f32(a1, r0), b1, r1);
+
+        // Pairwise adds reduce each vector to a single sample
+        float32x2_t lr0 = vpadd_f32(vpadd_f32(vget_low_f32(outL0), vget_high_f32(outL0)),
+                                    vpadd_f32(vget_low_f32(outR0), vget_high_f32(outR0)));
+        float32x2_t lr1 = vpadd_f32(vpadd_f32(vget_low_f32(outL1), vget_high_f32(outL1)),
+                                    vpadd_f32(vget_low_f32(outR1), vget_high_f32(outR1)));
+
+        // This is behind the read position of the next iteration
+        vst1q_f32(&buffer[i * 2], vcombine_f32(lr0, lr1));
+    }
+#endif
+#endif
+
+    // Handle any remaining frames one at a time
+    for (; i < frames; i++) {
+        float in[AUDIO_MIXER_MAX_CHANNELS];
+        SDL_memcpy(in, &buffer[i * m_InputChannels], m_InputChannels * sizeof(float));
+
+        float left = 0.0f, right = 0.0f;
+        for (int c = 0; c < m_InputChannels; c++) {
+            left += m_Matrix[0][c] * in[c];
+            right += m_Matrix[1][c] * in[c];
+        }
+
+        buffer[i * 2] = left;
+        buffer[i * 2 + 1] = right;
+    }
+}
+
+void AudioChannelMixer::applyGainAndLimit(float* buffer, int samples)
+{
+    float peak = 0.0f;
+    for (int i = 0; i < samples; i++) {
+        peak = SDL_max(peak, fabsf(buffer[i]));
+    }
+    peak *= m_Volume;
+
+    float targetGain = peak > LIMITER_THRESHOLD ? LIMITER_THRESHOLD / peak : 1.0f;
+    float startGain, endGain;
+
+    if (targetGain < m_LimiterGain) {
+        // Attack instantly so nothing in this buffer can clip
+        startGain = endGain = targetGain;
+    }
+    else {
+        // Release gradually across the buffer to avoid audible pumping
+        startGain = m_LimiterGain;
+        endGain = SDL_min(targetGain, m_LimiterGain + (1.0f - m_LimiterGain) * LIMITER_RELEASE);
+    }
+
+    m_LimiterGain = endGain;
+
+    if (startGain == 1.0f && endGain == 1.0f && m_Volume == 1.0f) {
+        return;
+    }
+
+    float gain = startGain * m_Volume;
+    float gainStep = (endGain - startGain) * m_Volume / samples;
+    for (int i = 0; i < samples; i++) {
+        buffer[i] *= gain;
+        gain += gainStep;
+    }
+}
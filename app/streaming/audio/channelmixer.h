@@ -0,0 +1,53 @@
+#pragma once
+
+// Maximum channel count of any GameStream audio configuration (7.1)
+#define AUDIO_MIXER_MAX_CHANNELS 8
+
+// In-place post-processing stage for decoded float audio. This folds
+// surround streams down to the channel count of the output device and
+// applies volume and a peak limiter to the result.
+//
+// Input channels are expected in Moonlight's default channel order:
+// FL, FR, C, LFE, RL, RR, SL, SR
+class AudioChannelMixer
+{
+public:
+    AudioChannelMixer();
+
+    // Returns false if the conversion is not supported
+    bool initialize(int inputChannels, int outputChannels);
+
+    static bool isConversionSupported(int inputChannels, int outputChannels);
+
+    // Linear gain applied after downmixing (1.0 = unity)
+    void setVolume(float volume);
+
+    // True if process() would leave the samples unmodified
+    bool isPassthrough();
+
+    int getInputChannels();
+
+    int getOutputChannels();
+
+    // Processes interleaved float samples in place. The buffer must hold
+    // frames * inputChannels samples on entry and will hold
+    // frames * outputChannels samples on return.
+    void process(float* buffer, int frames);
+
+private:
+    void downmixGeneric(float* buffer, int frames);
+
+    void downmixStereo(float* buffer, int frames);
+
+    void applyGainAndLimit(float* buffer, int samples);
+
+    int m_InputChannels;
+    int m_OutputChannels;
+
+    // Row-major [output][input] coefficients. Unused entries are zero,
+    // which allows SIMD paths to load a full 8 channel input frame.
+    float m_Matrix[AUDIO_MIXER_MAX_CHANNELS][AUDIO_MIXER_MAX_CHANNELS];
+
+    float m_Volume;
+    float m_LimiterGain;
+};
@@ -3,11 +3,33 @@
 #include <Limelight.h>
 #include <QtGlobal>
 
+typedef struct _AUDIO_STATS {
+    uint32_t receivedPackets;
+    uint32_t decodedPackets;
+    uint32_t droppedPackets;                   // dropped by the renderer to bound queued audio
+    uint32_t dropWindowPackets;                // dropped to catch up after renderer reinitialization
+    uint32_t concealedPackets;                 // synthesized by Opus packet loss concealment or FEC
+    uint32_t underruns;                        // renderer ran out of audio to play
+    uint32_t reinitializations;                // renderer failures requiring reinitialization
+    uint64_t totalDecodeTimeUs;                // high-res (1us)
+    uint64_t totalQueuedTimeUs;                // high-res (1us)
+    uint32_t maxQueuedTimeUs;                  // high-res (1us)
+    uint32_t queuedTimeSamples;
+    uint64_t measurementStartUs;               // microseconds
+} AUDIO_STATS, *PAUDIO_STATS;
+
 class IAudioRenderer
 {
 public:
+    IAudioRenderer() : m_AudioStats(nullptr) {}
+
     virtual ~IAudioRenderer() {}
 
+    // Statistics are only updated from the audio playback thread
+    void setAudioStats(PAUDIO_STATS audioStats) {
+        m_AudioStats = audioStats;
+    }
+
     virtual bool prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig) = 0;
 
     virtual void* getAudioBuffer(int* size) = 0;
@@ -15,6 +37,11 @@ public:
     // Return false if an unrecoverable error has occurred and the renderer must be reinitialized
     virtual bool submitAudio(int bytesWritten) = 0;
 
+    // Estimated time until audio submitted now is heard, or 0 if unknown
+    virtual uint32_t getOutputLatencyUs() {
+        return 0;
+    }
+
     virtual void remapChannels(POPUS_MULTISTREAM_CONFIGURATION) {
         // Use default channel mapping:
         // 0 - Front Left
@@ -41,4 +68,7 @@ public:
             Q_UNREACHABLE();
         }
     }
+
+protected:
+    PAUDIO_STATS m_AudioStats;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer.h"
+#include "../channelmixer.h"
 #include "SDL_compat.h"
 
 class SdlAudioRenderer : public IAudioRenderer
@@ -18,8 +19,18 @@ public:
 
     virtual AudioFormat getAudioBufferFormat();
 
+    virtual uint32_t getOutputLatencyUs();
+
 private:
     SDL_AudioDeviceID m_AudioDevice;
     void* m_AudioBuffer;
     int m_FrameSize;
+    int m_OutputFrameSize;
+    int m_SampleRate;
+    int m_SamplesPerFrame;
+    int m_DeviceBufferSamples;
+    bool m_HasQueuedAudio;
+    Uint64 m_LastQueueTime;
+    Uint32 m_LastQueuedSamples;
+    AudioChannelMixer m_Mixer;
 };
@@ -1,10 +1,19 @@
 #include "sdl.h"
+#include "utils.h"
 
 #include <Limelight.h>
 
 SdlAudioRenderer::SdlAudioRenderer()
     : m_AudioDevice(0),
-      m_AudioBuffer(nullptr)
+      m_AudioBuffer(nullptr),
+      m_FrameSize(0),
+      m_OutputFrameSize(0),
+      m_SampleRate(0),
+      m_SamplesPerFrame(0),
+      m_DeviceBufferSamples(0),
+      m_HasQueuedAudio(false),
+      m_LastQueueTime(0),
+      m_LastQueuedSamples(0)
 {
     SDL_assert(!SDL_WasInit(SDL_INIT_AUDIO));
 
@@ -36,7 +45,32 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
                   opusConfig->channelCount *
                   getAudioBufferSampleSize();
 
-    m_AudioDevice = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    // Let the device choose its native channel count if we can fold the stream down
+    // to it ourselves, rather than relying on SDL's generic converter. Otherwise,
+    // SDL must convert to the device layout, so we ask for the stream's layout.
+    int deviceChannels = 0;
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+    SDL_AudioSpec deviceSpec;
+    if (SDL_GetDefaultAudioInfo(nullptr, &deviceSpec, 0) == 0) {
+        deviceChannels = deviceSpec.channels;
+    }
+#endif
+
+    int allowedChanges = 0;
+    if (deviceChannels > 0) {
+        if (deviceChannels != want.channels &&
+                AudioChannelMixer::isConversionSupported(want.channels, deviceChannels)) {
+            allowedChanges = SDL_AUDIO_ALLOW_CHANNELS_CHANGE;
+        }
+    }
+    else if (AudioChannelMixer::isConversionSupported(want.channels, 2) &&
+             AudioChannelMixer::isConversionSupported(want.channels, 4)) {
+        // We don't know the device layout, so only allow a change when the
+        // stream can be folded down to the common stereo and quad layouts.
+        allowedChanges = SDL_AUDIO_ALLOW_CHANNELS_CHANGE;
+    }
+
+    m_AudioDevice = SDL_OpenAudioDevice(NULL, 0, &want, &have, allowedChanges);
     if (m_AudioDevice == 0) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                      "Failed to open audio device: %s",
@@ -44,6 +78,42 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
         return false;
     }
 
+    if (!m_Mixer.initialize(want.channels, have.channels)) {
+        // This can only happen if the device layout changed since we queried it,
+        // or if we had to guess it. Reopen and let SDL handle the conversion.
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Unable to mix %d channels to %d channels natively",
+                    want.channels,
+                    have.channels);
+
+        SDL_CloseAudioDevice(m_AudioDevice);
+        m_AudioDevice = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+        if (m_AudioDevice == 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "Failed to open audio device: %s",
+                         SDL_GetError());
+            return false;
+        }
+
+        SDL_assert(have.channels == want.channels);
+        m_Mixer.initialize(want.channels, want.channels);
+    }
+
+    int volumePercent;
+    if (Utils::getEnvironmentVariableOverride("AUDIO_VOLUME", &volumePercent)) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using audio volume override: %d%%",
+                    volumePercent);
+        m_Mixer.setVolume(volumePercent / 100.0f);
+    }
+
+    m_OutputFrameSize = opusConfig->samplesPerFrame *
+                        have.channels *
+                        getAudioBufferSampleSize();
+    m_SampleRate = have.freq;
+    m_SamplesPerFrame = opusConfig->samplesPerFrame;
+    m_DeviceBufferSamples = have.samples;
+
     m_AudioBuffer = SDL_malloc(m_FrameSize);
     if (m_AudioBuffer == nullptr) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
@@ -57,9 +127,10 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
                 want.samples * want.channels * getAudioBufferSampleSize());
 
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
-                "Obtained audio buffer: %u samples (%u bytes)",
+                "Obtained audio buffer: %u samples (%u bytes) with %u channels",
                 have.samples,
-                have.size);
+                have.size,
+                have.channels);
 
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "SDL audio driver: %s",
@@ -102,6 +173,9 @@ bool SdlAudioRenderer::submitAudio(int bytesWritten)
     // Don't queue if there's already more than 30 ms of audio data waiting
     // in Moonlight's audio queue.
     if (LiGetPendingAudioDuration() > 30) {
+        if (m_AudioStats != nullptr) {
+            m_AudioStats->droppedPackets++;
+        }
         return true;
     }
 
@@ -116,18 +190,41 @@ bool SdlAudioRenderer::submitAudio(int bytesWritten)
         }
 
         // Only queue more samples where there are 10 frames or less in SDL's queue
-        if (SDL_GetQueuedAudioSize(m_AudioDevice) / m_FrameSize <= 10) {
+        if (SDL_GetQueuedAudioSize(m_AudioDevice) / m_OutputFrameSize <= 10) {
             break;
         }
 
         SDL_Delay(1);
     }
 
+    // Downmix and apply volume in place before queuing
+    if (!m_Mixer.isPassthrough()) {
+        int frames = bytesWritten / (m_Mixer.getInputChannels() * getAudioBufferSampleSize());
+        m_Mixer.process((float*)m_AudioBuffer, frames);
+        bytesWritten = frames * m_Mixer.getOutputChannels() * getAudioBufferSampleSize();
+    }
+
+    // An empty queue alone is normal, since the device pulls whole buffers out of it.
+    // The device only ran dry if more time passed since our last submission than the
+    // audio we left queued plus a full device buffer could cover.
+    if (m_HasQueuedAudio && m_AudioStats != nullptr && SDL_GetQueuedAudioSize(m_AudioDevice) == 0) {
+        Uint64 elapsedUs = (SDL_GetPerformanceCounter() - m_LastQueueTime) * 1000000 / SDL_GetPerformanceFrequency();
+        Uint64 bufferedUs = ((Uint64)m_LastQueuedSamples + m_DeviceBufferSamples) * 1000000 / m_SampleRate;
+        if (elapsedUs > bufferedUs) {
+            m_AudioStats->underruns++;
+        }
+    }
+
     if (SDL_QueueAudio(m_AudioDevice, m_AudioBuffer, bytesWritten) < 0) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                      "Failed to queue audio sample: %s",
                      SDL_GetError());
     }
+    else {
+        m_HasQueuedAudio = true;
+        m_LastQueueTime = SDL_GetPerformanceCounter();
+        m_LastQueuedSamples = SDL_GetQueuedAudioSize(m_AudioDevice) / (m_OutputFrameSize / m_SamplesPerFrame);
+    }
 
     return true;
 }
@@ -136,3 +233,10 @@ IAudioRenderer::AudioFormat SdlAudioRenderer::getAudioBufferFormat()
 {
     return AudioFormat::Float32NE;
 }
+
+uint32_t SdlAudioRenderer::getOutputLatencyUs()
+{
+    // Audio waiting in SDL's queue plays after the device's current buffer drains
+    Uint32 queuedSamples = SDL_GetQueuedAudioSize(m_AudioDevice) / (m_OutputFrameSize / m_SamplesPerFrame);
+    return (uint32_t)(((uint64_t)queuedSamples + m_DeviceBufferSamples) * 1000000 / m_SampleRate);
+}
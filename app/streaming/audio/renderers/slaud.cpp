@@ -5,7 +5,11 @@
 SLAudioRenderer::SLAudioRenderer()
     : m_AudioContext(nullptr),
       m_AudioStream(nullptr),
-      m_AudioBuffer(nullptr)
+      m_AudioBuffer(nullptr),
+      m_FrameDurationUs(0),
+      m_QueuedAudioUs(0),
+      m_LastSubmitTime(0),
+      m_HasSubmittedAudio(false)
 {
     SLAudio_SetLogFunction(SLAudioRenderer::slLogCallback, nullptr);
 }
@@ -26,6 +30,7 @@ bool SLAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* o
     m_AudioBufferSize = opusConfig->samplesPerFrame *
                         opusConfig->channelCount *
                         getAudioBufferSampleSize();
+    m_FrameDurationUs = (Uint64)opusConfig->samplesPerFrame * 1000000 / opusConfig->sampleRate;
     m_AudioStream = SLAudio_CreateStream(m_AudioContext,
                                          opusConfig->sampleRate,
                                          opusConfig->channelCount,
@@ -102,13 +107,40 @@ bool SLAudioRenderer::submitAudio(int bytesWritten)
     }
 
     if (LiGetPendingAudioDuration() < m_MaxQueuedAudioMs) {
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        // SLAudio doesn't report how much audio it has queued, so we track what
+        // we've submitted against the time that has passed since. The stream
+        // only ran dry if more time passed than that audio plus the frame being
+        // played out could cover.
+        if (m_HasSubmittedAudio) {
+            Uint64 elapsedUs = (now - m_LastSubmitTime) * 1000000 / SDL_GetPerformanceFrequency();
+            if (elapsedUs > m_QueuedAudioUs + m_FrameDurationUs) {
+                if (m_AudioStats != nullptr) {
+                    m_AudioStats->underruns++;
+                }
+                m_QueuedAudioUs = 0;
+            }
+            else {
+                m_QueuedAudioUs -= SDL_min(elapsedUs, m_QueuedAudioUs);
+            }
+        }
+
         SLAudio_SubmitFrame(m_AudioStream);
         m_AudioBuffer = nullptr;
+
+        m_QueuedAudioUs += m_FrameDurationUs;
+        m_LastSubmitTime = now;
+        m_HasSubmittedAudio = true;
     }
     else {
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                     "Too many queued audio frames: %d",
                     LiGetPendingAudioFrames());
+
+        if (m_AudioStats != nullptr) {
+            m_AudioStats->droppedPackets++;
+        }
     }
 
     return true;
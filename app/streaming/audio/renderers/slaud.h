@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer.h"
+#include "SDL_compat.h"
 #include <SLAudio.h>
 
 class SLAudioRenderer : public IAudioRenderer
@@ -29,4 +30,10 @@ private:
     void* m_AudioBuffer;
     int m_AudioBufferSize;
     int m_MaxQueuedAudioMs;
+
+    // Estimate of the audio left to play, used to detect underruns
+    Uint64 m_FrameDurationUs;
+    Uint64 m_QueuedAudioUs;
+    Uint64 m_LastSubmitTime;
+    bool m_HasSubmittedAudio;
 };
@@ -0,0 +1,112 @@
+#include "avsync.h"
+#include "utils.h"
+
+// Latencies are smoothed with an EWMA over roughly the last 16 samples
+#define LATENCY_EWMA_SHIFT 4
+
+// Skew within this range is imperceptible, so we don't try to correct it
+#define SYNC_TOLERANCE_US 15000
+
+// Decoded frames are held in the Pacer, which releases them early once its
+// queue is full. The delay that takes effect is therefore also limited to a
+// few frame intervals, depending on the stream frame rate.
+#define MAX_VIDEO_DELAY_US 100000
+
+// Fraction of the remaining skew corrected per video frame (1/64). This is kept
+// small relative to the smoothing to avoid oscillating around the target.
+#define CORRECTION_SHIFT 6
+
+AVSyncTracker::AVSyncTracker()
+{
+    int correction;
+    if (!Utils::getEnvironmentVariableOverride("AV_SYNC_CORRECTION", &correction)) {
+        correction = 0;
+    }
+    m_CorrectionEnabled = correction != 0;
+
+    reset();
+}
+
+void AVSyncTracker::reset()
+{
+    m_AudioLatencyAvgUs = -1;
+    m_VideoLatencyAvgUs = -1;
+    SDL_AtomicSet(&m_PublishedAudioLatencyUs, -1);
+    SDL_AtomicSet(&m_PublishedVideoLatencyUs, -1);
+    SDL_AtomicSet(&m_VideoDelayUs, 0);
+}
+
+static int64_t updateAverage(int64_t average, uint64_t sample)
+{
+    if (average < 0) {
+        return (int64_t)sample;
+    }
+
+    return average + (((int64_t)sample - average) >> LATENCY_EWMA_SHIFT);
+}
+
+void AVSyncTracker::submitAudioLatency(uint64_t latencyUs)
+{
+    m_AudioLatencyAvgUs = updateAverage(m_AudioLatencyAvgUs, latencyUs);
+    SDL_AtomicSet(&m_PublishedAudioLatencyUs, (int)SDL_min(m_AudioLatencyAvgUs, (int64_t)SDL_MAX_SINT32));
+}
+
+void AVSyncTracker::submitVideoLatency(uint64_t latencyUs)
+{
+    m_VideoLatencyAvgUs = updateAverage(m_VideoLatencyAvgUs, latencyUs);
+    SDL_AtomicSet(&m_PublishedVideoLatencyUs, (int)SDL_min(m_VideoLatencyAvgUs, (int64_t)SDL_MAX_SINT32));
+
+    if (m_CorrectionEnabled) {
+        updateCorrection();
+    }
+}
+
+bool AVSyncTracker::getSkewUs(int32_t* skewUs)
+{
+    int audioLatencyUs = SDL_AtomicGet(&m_PublishedAudioLatencyUs);
+    int videoLatencyUs = SDL_AtomicGet(&m_PublishedVideoLatencyUs);
+
+    if (audioLatencyUs < 0 || videoLatencyUs < 0) {
+        return false;
+    }
+
+    *skewUs = audioLatencyUs - videoLatencyUs;
+    return true;
+}
+
+uint32_t AVSyncTracker::getVideoDelayUs()
+{
+    return (uint32_t)SDL_AtomicGet(&m_VideoDelayUs);
+}
+
+void AVSyncTracker::updateCorrection()
+{
+    int32_t skewUs;
+
+    if (!getSkewUs(&skewUs)) {
+        return;
+    }
+
+    int delayUs = SDL_AtomicGet(&m_VideoDelayUs);
+
+    // Audio late: move the video delay up towards the audio latency.
+    // Video late: back the delay off until it reaches zero again.
+    if (skewUs > SYNC_TOLERANCE_US || (skewUs < -SYNC_TOLERANCE_US && delayUs > 0)) {
+        int step = skewUs / (1 << CORRECTION_SHIFT);
+        if (step == 0) {
+            step = skewUs > 0 ? 1 : -1;
+        }
+
+        int newDelayUs = SDL_clamp(delayUs + step, 0, MAX_VIDEO_DELAY_US);
+        if (newDelayUs != delayUs) {
+            if ((delayUs == 0) != (newDelayUs == 0)) {
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                            "A/V sync correction %s (skew: %d ms)",
+                            newDelayUs != 0 ? "started" : "stopped",
+                            skewUs / 1000);
+            }
+
+            SDL_AtomicSet(&m_VideoDelayUs, newDelayUs);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "SDL_compat.h"
+
+#include <cstdint>
+
+/**
+ * @brief The AVSyncTracker class measures the offset between the audio and video pipelines.
+ *
+ * Each pipeline reports the local latency between a packet arriving from the network and
+ * its contents reaching the user: for audio, the time queued in moonlight-common-c plus
+ * the time until the renderer plays it out, and for video the time from frame arrival to
+ * the renderer's present. The host captures both streams at the same moment, so the
+ * difference between the smoothed latencies is the A/V skew seen by the user.
+ *
+ * When correction is enabled (AV_SYNC_CORRECTION=1), the tracker computes an additional
+ * delay for the video pipeline that brings video back in line with a slower audio path,
+ * such as a Bluetooth sink with a deep buffer.
+ *
+ * Audio and video latency are expected to be submitted from one thread each. The getters
+ * may be called from any thread.
+ */
+class AVSyncTracker
+{
+public:
+    AVSyncTracker();
+
+    /**
+     * @brief Resets all measurements. Must not race with the submit functions.
+     */
+    void reset();
+
+    /**
+     * @brief Records the arrival-to-playback latency of an audio packet.
+     */
+    void submitAudioLatency(uint64_t latencyUs);
+
+    /**
+     * @brief Records the arrival-to-present latency of a video frame.
+     *
+     * This includes any delay returned by getVideoDelayUs().
+     */
+    void submitVideoLatency(uint64_t latencyUs);
+
+    /**
+     * @brief Returns the smoothed audio latency minus video latency.
+     *
+     * Positive values mean audio is heard after the matching video frame is shown.
+     *
+     * @return false if either pipeline has not reported yet.
+     */
+    bool getSkewUs(int32_t* skewUs);
+
+    /**
+     * @brief Returns the delay the video pipeline should add before presenting a frame.
+     */
+    uint32_t getVideoDelayUs();
+
+private:
+    void updateCorrection();
+
+    bool m_CorrectionEnabled;
+
+    // Only touched by the submitting threads
+    int64_t m_AudioLatencyAvgUs;
+    int64_t m_VideoLatencyAvgUs;
+
+    // Published for other threads
+    SDL_atomic_t m_PublishedAudioLatencyUs;
+    SDL_atomic_t m_PublishedVideoLatencyUs;
+    SDL_atomic_t m_VideoDelayUs;
+};
@@ -19,6 +19,9 @@
 // How far the finger can move before it can override the double tap deadzone
 #define DOUBLE_TAP_DEAD_ZONE_DELTA 0.025f
 
+// Weight of the newest sample in the smoothed touch velocity used for prediction
+#define TOUCH_VELOCITY_SMOOTHING 0.5f
+
 Uint32 SdlInputHandler::longPressTimerCallback(Uint32, void*)
 {
     // Raise the left click and start a right click
@@ -126,16 +129,13 @@ void SdlInputHandler::handleAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
             }
         }
 
-        if (isPen) {
-            LiSendPenEvent(eventType, LI_TOOL_TYPE_PEN, 0, vidrelx / dst.w, vidrely / dst.h, event->pressure,
-                           0.0f, 0.0f, LI_ROT_UNKNOWN, LI_TILT_UNKNOWN);
-        }
-        else
+#else
+        bool isPen = false;
 #endif
-        {
-            LiSendTouchEvent(eventType, pointerId, vidrelx / dst.w, vidrely / dst.h, event->pressure,
-                             0.0f, 0.0f, LI_ROT_UNKNOWN);
-        }
+
+        sendNativeTouchEvent(eventType, pointerId, isPen,
+                             vidrelx / dst.w, vidrely / dst.h,
+                             event->pressure, event->timestamp);
 
         if (!m_DisabledTouchFeedback) {
             // Disable touch feedback when passing touch natively
@@ -148,6 +148,154 @@ void SdlInputHandler::handleAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
     }
 }
 
+void SdlInputHandler::sendNativeTouchEvent(uint8_t eventType, uint32_t pointerId, bool isPen,
+                                           float x, float y, float pressure, uint32_t timestamp)
+{
+    TouchPointerState* pointer = nullptr;
+    TouchPointerState* freePointer = nullptr;
+
+    for (int i = 0; i < MAX_TOUCH_POINTERS; i++) {
+        if (!m_TouchPointers[i].active) {
+            if (freePointer == nullptr) {
+                freePointer = &m_TouchPointers[i];
+            }
+        }
+        else if (m_TouchPointers[i].pointerId == pointerId && m_TouchPointers[i].isPen == isPen) {
+            pointer = &m_TouchPointers[i];
+            break;
+        }
+    }
+
+    if (eventType == LI_TOUCH_EVENT_DOWN) {
+        if (pointer == nullptr) {
+            pointer = freePointer;
+        }
+        if (pointer != nullptr) {
+            SDL_zerop(pointer);
+            pointer->active = true;
+            pointer->isPen = isPen;
+            pointer->pointerId = pointerId;
+            pointer->lastSendTime = SDL_GetTicks();
+        }
+    }
+    else if (pointer != nullptr) {
+        if (eventType == LI_TOUCH_EVENT_MOVE) {
+            // Track the velocity of the raw samples for prediction
+            if (SDL_TICKS_PASSED(timestamp, pointer->lastEventTime) && timestamp != pointer->lastEventTime) {
+                float dt = timestamp - pointer->lastEventTime;
+                pointer->velocityX += TOUCH_VELOCITY_SMOOTHING * ((x - pointer->x) / dt - pointer->velocityX);
+                pointer->velocityY += TOUCH_VELOCITY_SMOOTHING * ((y - pointer->y) / dt - pointer->velocityY);
+            }
+
+            pointer->x = x;
+            pointer->y = y;
+            pointer->pressure = pressure;
+            pointer->lastEventTime = timestamp;
+            if (!pointer->motionPending) {
+                pointer->pendingEventTime = timestamp;
+            }
+
+            if (SDL_GetTicks() - pointer->lastSendTime < m_TouchCoalesceWindowMs) {
+                // Hold this position and replace it with anything else arriving
+                // for this pointer until the window is over.
+                pointer->motionPending = true;
+                scheduleTouchFlush();
+            }
+            else {
+                sendTouchPointerMotion(pointer);
+            }
+            return;
+        }
+        else if (pointer->motionPending) {
+            // Deliver the held motion before the edge, without prediction
+            // so the host sees the pointer lift at its real position.
+            pointer->velocityX = pointer->velocityY = 0;
+            sendTouchPointerMotion(pointer);
+        }
+
+        if (eventType == LI_TOUCH_EVENT_UP) {
+            pointer->active = false;
+        }
+    }
+
+    if (pointer != nullptr) {
+        pointer->x = x;
+        pointer->y = y;
+        pointer->pressure = pressure;
+        pointer->lastEventTime = timestamp;
+    }
+
+    // If we have no slot to track this pointer, everything goes out immediately
+    if (isPen) {
+        LiSendPenEvent(eventType, LI_TOOL_TYPE_PEN, 0, x, y, pressure,
+                       0.0f, 0.0f, LI_ROT_UNKNOWN, LI_TILT_UNKNOWN);
+    }
+    else {
+        LiSendTouchEvent(eventType, pointerId, x, y, pressure,
+                         0.0f, 0.0f, LI_ROT_UNKNOWN);
+    }
+    submitInputLatency(InputLatencyTracker::Touch, timestamp);
+}
+
+void SdlInputHandler::sendTouchPointerMotion(TouchPointerState* pointer)
+{
+    float x = pointer->x;
+    float y = pointer->y;
+
+    if (m_TouchPredictionMs > 0) {
+        x = qBound(0.0f, x + pointer->velocityX * m_TouchPredictionMs, 1.0f);
+        y = qBound(0.0f, y + pointer->velocityY * m_TouchPredictionMs, 1.0f);
+    }
+
+    if (pointer->isPen) {
+        LiSendPenEvent(LI_TOUCH_EVENT_MOVE, LI_TOOL_TYPE_PEN, 0, x, y, pointer->pressure,
+                       0.0f, 0.0f, LI_ROT_UNKNOWN, LI_TILT_UNKNOWN);
+    }
+    else {
+        LiSendTouchEvent(LI_TOUCH_EVENT_MOVE, pointer->pointerId, x, y, pointer->pressure,
+                         0.0f, 0.0f, LI_ROT_UNKNOWN);
+    }
+
+    submitInputLatency(InputLatencyTracker::Touch, pointer->pendingEventTime);
+
+    pointer->motionPending = false;
+    pointer->lastSendTime = SDL_GetTicks();
+}
+
+void SdlInputHandler::scheduleTouchFlush()
+{
+    if (m_TouchFlushTimer == 0) {
+        m_TouchFlushTimer = SDL_AddTimer(m_TouchCoalesceWindowMs,
+                                         SdlInputHandler::touchFlushTimerCallback,
+                                         nullptr);
+    }
+}
+
+void SdlInputHandler::flushPendingTouchMotion()
+{
+    // The timer is one-shot and has already fired
+    m_TouchFlushTimer = 0;
+
+    for (int i = 0; i < MAX_TOUCH_POINTERS; i++) {
+        if (m_TouchPointers[i].active && m_TouchPointers[i].motionPending) {
+            sendTouchPointerMotion(&m_TouchPointers[i]);
+        }
+    }
+
+    sendPendingTouchDelta();
+}
+
+Uint32 SdlInputHandler::touchFlushTimerCallback(Uint32, void*)
+{
+    // Send the pending motion from the main thread, which owns the touch state
+    SDL_Event event = {};
+    event.type = SDL_USEREVENT;
+    event.user.code = SDL_CODE_TOUCH_FLUSH_STATE;
+    SDL_PushEvent(&event);
+
+    return 0;
+}
+
 void SdlInputHandler::emulateAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
 {
     // Observations on Windows 10: x and y appear to be relative to 0,0 of the window client area.
@@ -166,6 +314,9 @@ void SdlInputHandler::emulateAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
         return;
     }
 
+    // Emulated mouse input is sent straight away
+    submitInputLatency(InputLatencyTracker::Touch, event->timestamp);
+
     SDL_Rect src, dst;
     int windowWidth, windowHeight;
 
@@ -0,0 +1,435 @@
+#include "evdevmouse.h"
+#include "utils.h"
+
+#include <Limelight.h>
+
+#include <QDir>
+
+#include <climits>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+// Older kernel headers don't have these accessors
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+#define DEFAULT_FLUSH_RATE_HZ 1000
+
+// Wheel detents are reported as 120 units by the high-res wheel axes
+#define WHEEL_DELTA 120
+
+#define TEST_BIT(bits, bit) ((bits)[(bit) / (8 * sizeof(unsigned long))] & (1UL << ((bit) % (8 * sizeof(unsigned long)))))
+#define BITS_TO_LONGS(n) (((n) + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long)))
+
+static uint64_t getMonotonicTimeUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t getEventTimeUs(const struct input_event& event)
+{
+    return (uint64_t)event.input_event_sec * 1000000 + event.input_event_usec;
+}
+
+EvdevMouseReader* EvdevMouseReader::create(InputLatencyTracker* latencyTracker,
+                                           bool swapMouseButtons, bool reverseScrollDirection)
+{
+    int enabled;
+    if (!Utils::getEnvironmentVariableOverride("EVDEV_MOUSE", &enabled) || !enabled) {
+        return nullptr;
+    }
+
+    QVector<Device> devices;
+    QDir inputDir("/dev/input");
+    const QStringList nodes = inputDir.entryList(QStringList() << "event*", QDir::System);
+    for (const QString& node : nodes) {
+        int fd = open(inputDir.filePath(node).toUtf8().constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        unsigned long evBits[BITS_TO_LONGS(EV_CNT)] = {};
+        unsigned long relBits[BITS_TO_LONGS(REL_CNT)] = {};
+        unsigned long keyBits[BITS_TO_LONGS(KEY_CNT)] = {};
+        if (ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), evBits) < 0 ||
+                ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relBits)), relBits) < 0 ||
+                ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0 ||
+                !TEST_BIT(evBits, EV_REL) || !TEST_BIT(relBits, REL_X) || !TEST_BIT(relBits, REL_Y) ||
+                !TEST_BIT(keyBits, BTN_LEFT)) {
+            // Not a relative mouse
+            close(fd);
+            continue;
+        }
+
+        // Timestamp events on the same clock we use to measure latency
+        int clockId = CLOCK_MONOTONIC;
+        ioctl(fd, EVIOCSCLOCKID, &clockId);
+
+        char name[128] = {};
+        ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using raw evdev mouse: %s (%s)",
+                    name,
+                    qPrintable(node));
+
+        Device device;
+        device.fd = fd;
+#ifdef REL_WHEEL_HI_RES
+        device.hasHighResWheel = TEST_BIT(relBits, REL_WHEEL_HI_RES);
+        device.hasHighResHWheel = TEST_BIT(relBits, REL_HWHEEL_HI_RES);
+#else
+        device.hasHighResWheel = device.hasHighResHWheel = false;
+#endif
+        devices.append(device);
+    }
+
+    if (devices.isEmpty()) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "No accessible evdev mice found. Falling back to SDL mouse input.");
+        return nullptr;
+    }
+
+    int wakePipe[2];
+    if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "pipe2() failed: %d",
+                     errno);
+        for (const Device& device : devices) {
+            close(device.fd);
+        }
+        return nullptr;
+    }
+
+    return new EvdevMouseReader(latencyTracker, devices, wakePipe, swapMouseButtons, reverseScrollDirection);
+}
+
+EvdevMouseReader::EvdevMouseReader(InputLatencyTracker* latencyTracker,
+                                   const QVector<Device>& devices, int wakePipe[2],
+                                   bool swapMouseButtons, bool reverseScrollDirection)
+    : m_LatencyTracker(latencyTracker),
+      m_Devices(devices),
+      m_SwapMouseButtons(swapMouseButtons),
+      m_ReverseScrollDirection(reverseScrollDirection),
+      m_WasGrabbed(false),
+      m_PendingDeltaX(0),
+      m_PendingDeltaY(0),
+      m_PendingMotionTimeUs(0),
+      m_LastFlushTimeUs(0),
+      m_ButtonsDown(0),
+      m_MotionEvents(0),
+      m_MotionFlushes(0),
+      m_MotionDelayTotalUs(0),
+      m_MotionDelayMaxUs(0)
+{
+    m_WakePipe[0] = wakePipe[0];
+    m_WakePipe[1] = wakePipe[1];
+
+    int flushRateHz;
+    if (!Utils::getEnvironmentVariableOverride("EVDEV_MOUSE_FLUSH_HZ", &flushRateHz) || flushRateHz <= 0) {
+        flushRateHz = DEFAULT_FLUSH_RATE_HZ;
+    }
+    m_FlushIntervalUs = 1000000 / flushRateHz;
+
+    SDL_AtomicSet(&m_Grabbed, 0);
+    SDL_AtomicSet(&m_Stopping, 0);
+
+    m_Thread = SDL_CreateThread(EvdevMouseReader::readerThreadProc, "EvdevMouse", this);
+}
+
+EvdevMouseReader::~EvdevMouseReader()
+{
+    setGrabbed(false);
+
+    SDL_AtomicSet(&m_Stopping, 1);
+    (void)!write(m_WakePipe[1], "", 1);
+    SDL_WaitThread(m_Thread, nullptr);
+
+    for (const Device& device : m_Devices) {
+        close(device.fd);
+    }
+    close(m_WakePipe[0]);
+    close(m_WakePipe[1]);
+
+    logStats();
+}
+
+bool EvdevMouseReader::setGrabbed(bool grabbed)
+{
+    if (!!SDL_AtomicGet(&m_Grabbed) == grabbed) {
+        return true;
+    }
+
+    for (const Device& device : m_Devices) {
+        if (ioctl(device.fd, EVIOCGRAB, grabbed ? 1 : 0) < 0 && grabbed) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                        "EVIOCGRAB failed: %d",
+                        errno);
+
+            // SDL would see the motion from any mouse we couldn't grab,
+            // so don't forward anything unless we have all of them.
+            for (const Device& grabbedDevice : m_Devices) {
+                ioctl(grabbedDevice.fd, EVIOCGRAB, 0);
+            }
+            return false;
+        }
+    }
+
+    SDL_AtomicSet(&m_Grabbed, grabbed ? 1 : 0);
+
+    // Wake the reader so it can release any buttons held at ungrab time
+    (void)!write(m_WakePipe[1], "", 1);
+    return true;
+}
+
+int EvdevMouseReader::readerThreadProc(void* context)
+{
+    static_cast<EvdevMouseReader*>(context)->readerThread();
+    return 0;
+}
+
+void EvdevMouseReader::readerThread()
+{
+    QVector<struct pollfd> pollFds;
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+    for (const Device& device : m_Devices) {
+        pollFds.append({ device.fd, POLLIN, 0 });
+    }
+    pollFds.append({ m_WakePipe[0], POLLIN, 0 });
+
+    while (!SDL_AtomicGet(&m_Stopping)) {
+        struct timespec timeout;
+        struct timespec* timeoutPtr = nullptr;
+
+        // Only wake up for the flush deadline if we have motion pending
+        if (m_PendingMotionTimeUs != 0) {
+            uint64_t nowUs = getMonotonicTimeUs();
+            uint64_t deadlineUs = m_LastFlushTimeUs + m_FlushIntervalUs;
+            uint64_t waitUs = deadlineUs > nowUs ? deadlineUs - nowUs : 0;
+
+            timeout.tv_sec = waitUs / 1000000;
+            timeout.tv_nsec = (waitUs % 1000000) * 1000;
+            timeoutPtr = &timeout;
+        }
+
+        int ret = ppoll(pollFds.data(), pollFds.size(), timeoutPtr, nullptr);
+        if (ret < 0 && errno != EINTR) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "ppoll() failed: %d",
+                         errno);
+            break;
+        }
+
+        if (pollFds.last().revents & POLLIN) {
+            char buf[16];
+            while (read(m_WakePipe[0], buf, sizeof(buf)) > 0);
+        }
+
+        bool grabbed = SDL_AtomicGet(&m_Grabbed) != 0;
+        if (m_WasGrabbed && !grabbed) {
+            // Don't leave buttons stuck down on the host when SDL takes over
+            flushMotion();
+            releaseButtons();
+        }
+        m_WasGrabbed = grabbed;
+
+        for (int i = 0; i < m_Devices.size(); i++) {
+            if (!(pollFds[i].revents & (POLLIN | POLLERR | POLLHUP))) {
+                continue;
+            }
+
+            struct input_event events[64];
+            ssize_t bytesRead;
+            while ((bytesRead = read(m_Devices[i].fd, events, sizeof(events))) > 0) {
+                // Events read while ungrabbed are also seen by SDL
+                if (!grabbed) {
+                    continue;
+                }
+
+                for (size_t j = 0; j < bytesRead / sizeof(events[0]); j++) {
+                    handleEvent(m_Devices[i], events[j]);
+                }
+            }
+
+            if (bytesRead < 0 && errno == ENODEV) {
+                // The mouse was unplugged. Stop polling it.
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                            "Raw evdev mouse removed");
+                pollFds[i].fd = -1;
+            }
+        }
+
+        if (m_PendingMotionTimeUs != 0 && getMonotonicTimeUs() - m_LastFlushTimeUs >= m_FlushIntervalUs) {
+            flushMotion();
+        }
+    }
+}
+
+void EvdevMouseReader::handleEvent(const Device& device, const struct input_event& event)
+{
+    int button;
+
+    switch (event.type) {
+    case EV_REL:
+        switch (event.code) {
+        case REL_X:
+        case REL_Y:
+            if (m_PendingMotionTimeUs == 0) {
+                m_PendingMotionTimeUs = getEventTimeUs(event);
+            }
+            if (event.code == REL_X) {
+                m_PendingDeltaX += event.value;
+            }
+            else {
+                m_PendingDeltaY += event.value;
+            }
+            m_MotionEvents++;
+            return;
+        case REL_WHEEL:
+        case REL_HWHEEL:
+#ifdef REL_WHEEL_HI_RES
+        case REL_WHEEL_HI_RES:
+        case REL_HWHEEL_HI_RES:
+#endif
+        {
+            bool horizontal = event.code == REL_HWHEEL;
+            int amount = event.value * WHEEL_DELTA;
+
+#ifdef REL_WHEEL_HI_RES
+            // Devices with high-res wheels report both axes, so only use one of them
+            if ((event.code == REL_WHEEL && device.hasHighResWheel) ||
+                    (event.code == REL_HWHEEL && device.hasHighResHWheel)) {
+                return;
+            }
+            else if (event.code == REL_WHEEL_HI_RES || event.code == REL_HWHEEL_HI_RES) {
+                horizontal = event.code == REL_HWHEEL_HI_RES;
+                amount = event.value;
+            }
+#else
+            Q_UNUSED(device);
+#endif
+
+            // Invert the scroll direction if needed
+            if (m_ReverseScrollDirection) {
+                amount = -amount;
+            }
+
+            // Keep wheel events ordered after the motion preceding them
+            flushMotion();
+            if (horizontal) {
+                LiSendHighResHScrollEvent((short)SDL_clamp(amount, SHRT_MIN, SHRT_MAX));
+            }
+            else {
+                LiSendHighResScrollEvent((short)SDL_clamp(amount, SHRT_MIN, SHRT_MAX));
+            }
+            return;
+        }
+        default:
+            return;
+        }
+
+    case EV_KEY:
+    {
+        switch (event.code) {
+        case BTN_LEFT:
+            button = m_SwapMouseButtons ? BUTTON_RIGHT : BUTTON_LEFT;
+            break;
+        case BTN_RIGHT:
+            button = m_SwapMouseButtons ? BUTTON_LEFT : BUTTON_RIGHT;
+            break;
+        case BTN_MIDDLE:
+            button = BUTTON_MIDDLE;
+            break;
+        case BTN_SIDE:
+            button = BUTTON_X1;
+            break;
+        case BTN_EXTRA:
+            button = BUTTON_X2;
+            break;
+        default:
+            return;
+        }
+
+        // Ignore autorepeat
+        if (event.value == 2) {
+            return;
+        }
+
+        // Keep button events ordered after the motion preceding them
+        flushMotion();
+        if (event.value) {
+            m_ButtonsDown |= 1 << button;
+        }
+        else {
+            m_ButtonsDown &= ~(1 << button);
+        }
+        LiSendMouseButtonEvent(event.value ? BUTTON_ACTION_PRESS : BUTTON_ACTION_RELEASE, button);
+
+        uint64_t nowUs = getMonotonicTimeUs();
+        uint64_t eventTimeUs = getEventTimeUs(event);
+        m_LatencyTracker->submit(InputLatencyTracker::Mouse, nowUs > eventTimeUs ? nowUs - eventTimeUs : 0);
+        return;
+    }
+
+    default:
+        return;
+    }
+}
+
+void EvdevMouseReader::flushMotion()
+{
+    if (m_PendingMotionTimeUs == 0) {
+        return;
+    }
+
+    if (m_PendingDeltaX != 0 || m_PendingDeltaY != 0) {
+        LiSendMouseMoveEvent((short)SDL_clamp(m_PendingDeltaX, SHRT_MIN, SHRT_MAX),
+                             (short)SDL_clamp(m_PendingDeltaY, SHRT_MIN, SHRT_MAX));
+    }
+
+    uint64_t nowUs = getMonotonicTimeUs();
+    uint64_t delayUs = nowUs > m_PendingMotionTimeUs ? nowUs - m_PendingMotionTimeUs : 0;
+    m_MotionFlushes++;
+    m_MotionDelayTotalUs += delayUs;
+    m_MotionDelayMaxUs = SDL_max(m_MotionDelayMaxUs, delayUs);
+    m_LatencyTracker->submit(InputLatencyTracker::Mouse, delayUs);
+
+    m_PendingDeltaX = m_PendingDeltaY = 0;
+    m_PendingMotionTimeUs = 0;
+    m_LastFlushTimeUs = nowUs;
+}
+
+void EvdevMouseReader::releaseButtons()
+{
+    for (int button = BUTTON_LEFT; button <= BUTTON_X2; button++) {
+        if (m_ButtonsDown & (1 << button)) {
+            LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, button);
+        }
+    }
+    m_ButtonsDown = 0;
+}
+
+void EvdevMouseReader::logStats()
+{
+    if (m_MotionFlushes == 0) {
+        return;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Raw mouse motion: %u evdev events sent as %u updates, %.3f ms average / %.3f ms max motion-to-send latency",
+                m_MotionEvents,
+                m_MotionFlushes,
+                m_MotionDelayTotalUs / 1000.0 / m_MotionFlushes,
+                m_MotionDelayMaxUs / 1000.0);
+}
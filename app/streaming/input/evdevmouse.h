@@ -0,0 +1,84 @@
+#pragma once
+
+#include "SDL_compat.h"
+#include "streaming/inputlatency.h"
+
+#include <QVector>
+
+struct input_event;
+
+/**
+ * @brief The EvdevMouseReader class forwards relative mice straight from evdev.
+ *
+ * SDL only delivers mouse motion when the main loop wakes up, which quantizes
+ * 4-8 kHz gaming mice to the main loop's cadence. When enabled (EVDEV_MOUSE=1),
+ * this reads the mice on a dedicated thread instead, accumulating motion and
+ * flushing it to the host at a fixed rate (EVDEV_MOUSE_FLUSH_HZ, 1000 by default).
+ *
+ * The devices are grabbed with EVIOCGRAB while input is captured in relative mode,
+ * so the same motion doesn't also reach SDL. While not grabbed, evdev events are
+ * discarded and SDL handles the mouse as usual.
+ */
+class EvdevMouseReader
+{
+public:
+    /**
+     * @brief Returns nullptr if raw mouse input is disabled or no mice are accessible.
+     */
+    static EvdevMouseReader* create(InputLatencyTracker* latencyTracker,
+                                   bool swapMouseButtons, bool reverseScrollDirection);
+
+    ~EvdevMouseReader();
+
+    /**
+     * @brief Grabs or releases the mice. Must be called on the main thread.
+     *
+     * @return false if no mouse could be grabbed.
+     */
+    bool setGrabbed(bool grabbed);
+
+private:
+    struct Device {
+        int fd;
+        bool hasHighResWheel;
+        bool hasHighResHWheel;
+    };
+
+    EvdevMouseReader(InputLatencyTracker* latencyTracker,
+                     const QVector<Device>& devices, int wakePipe[2],
+                     bool swapMouseButtons, bool reverseScrollDirection);
+
+    static int readerThreadProc(void* context);
+
+    void readerThread();
+
+    void handleEvent(const Device& device, const struct input_event& event);
+
+    void flushMotion();
+
+    void releaseButtons();
+
+    void logStats();
+
+    InputLatencyTracker* m_LatencyTracker;
+    QVector<Device> m_Devices;
+    int m_WakePipe[2];
+    SDL_Thread* m_Thread;
+    SDL_atomic_t m_Grabbed;
+    SDL_atomic_t m_Stopping;
+    bool m_SwapMouseButtons;
+    bool m_ReverseScrollDirection;
+    uint64_t m_FlushIntervalUs;
+
+    // Only accessed on the reader thread
+    bool m_WasGrabbed;
+    int m_PendingDeltaX;
+    int m_PendingDeltaY;
+    uint64_t m_PendingMotionTimeUs;
+    uint64_t m_LastFlushTimeUs;
+    int m_ButtonsDown;
+    uint32_t m_MotionEvents;
+    uint32_t m_MotionFlushes;
+    uint64_t m_MotionDelayTotalUs;
+    uint64_t m_MotionDelayMaxUs;
+};
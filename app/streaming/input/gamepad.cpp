@@ -51,7 +51,7 @@ SdlInputHandler::findStateForGamepad(SDL_JoystickID id)
     return nullptr;
 }
 
-void SdlInputHandler::sendGamepadState(GamepadState* state)
+void SdlInputHandler::sendGamepadState(GamepadState* state, bool analogOnly)
 {
     SDL_assert(m_GamepadMask == 0x1 || m_MultiController);
 
@@ -101,6 +101,46 @@ void SdlInputHandler::sendGamepadState(GamepadState* state)
         }
     }
 
+    GamepadPacket& lastSent = m_LastSentGamepadPackets[state->index];
+    InputLatencyTracker& tracker = Session::get()->getInputLatencyTracker();
+    if (lastSent.valid && lastSent.buttons == buttons) {
+        bool analogChanged =
+                lastSent.lt != lt || lastSent.rt != rt ||
+                lastSent.lsX != lsX || lastSent.lsY != lsY ||
+                lastSent.rsX != rsX || lastSent.rsY != rsY;
+        if (!analogChanged) {
+            // The host already has this exact state
+            state->analogUpdatePending = false;
+            state->pendingEventTime = 0;
+            tracker.countGamepadUpdate(state->index, false);
+            return;
+        }
+        else if (analogOnly) {
+            if (lastSent.lt == lt && lastSent.rt == rt &&
+                    !isSignificantAxisChange(lastSent.lsX, lsX) && !isSignificantAxisChange(lastSent.lsY, lsY) &&
+                    !isSignificantAxisChange(lastSent.rsX, rsX) && !isSignificantAxisChange(lastSent.rsY, rsY)) {
+                // Drop stick noise. This is measured against what we last sent,
+                // so slow movements still get through once they add up.
+                state->pendingEventTime = 0;
+                tracker.countGamepadUpdate(state->index, false);
+                return;
+            }
+
+            if (SDL_GetTicks() - lastSent.sendTime < m_GamepadCoalesceWindowMs) {
+                // We just sent an update for this gamepad, so hold this one
+                // and merge it with anything else arriving in this window.
+                state->analogUpdatePending = true;
+                if (m_GamepadFlushTimer == 0) {
+                    m_GamepadFlushTimer = SDL_AddTimer(m_GamepadCoalesceWindowMs,
+                                                       SdlInputHandler::gamepadFlushTimerCallback,
+                                                       nullptr);
+                }
+                tracker.countGamepadUpdate(state->index, false);
+                return;
+            }
+        }
+    }
+
     LiSendMultiControllerEvent(state->index,
                                m_GamepadMask,
                                buttons,
@@ -110,6 +150,70 @@ void SdlInputHandler::sendGamepadState(GamepadState* state)
                                lsY,
                                rsX,
                                rsY);
+
+    lastSent.valid = true;
+    lastSent.buttons = buttons;
+    lastSent.lt = lt;
+    lastSent.rt = rt;
+    lastSent.lsX = lsX;
+    lastSent.lsY = lsY;
+    lastSent.rsX = rsX;
+    lastSent.rsY = rsY;
+    lastSent.sendTime = SDL_GetTicks();
+
+    // This packet carries the latest state of every gamepad merged into it,
+    // so its delay is measured from the oldest change that any of them had.
+    uint32_t oldestEventTime = 0;
+    for (int i = 0; i < MAX_GAMEPADS; i++) {
+        if (m_GamepadState[i].index == state->index) {
+            if (m_GamepadState[i].pendingEventTime != 0 &&
+                    (oldestEventTime == 0 || SDL_TICKS_PASSED(oldestEventTime, m_GamepadState[i].pendingEventTime))) {
+                oldestEventTime = m_GamepadState[i].pendingEventTime;
+            }
+            m_GamepadState[i].analogUpdatePending = false;
+            m_GamepadState[i].pendingEventTime = 0;
+        }
+    }
+
+    if (oldestEventTime != 0) {
+        submitInputLatency(InputLatencyTracker::Gamepad, oldestEventTime);
+    }
+    tracker.countGamepadUpdate(state->index, true);
+}
+
+bool SdlInputHandler::isSignificantAxisChange(short lastValue, short value)
+{
+    if (value == 0 || value >= 32767 || value <= -32767) {
+        // Always send a stick coming to rest or reaching full deflection,
+        // so noise filtering can never leave it short of either on the host.
+        return value != lastValue;
+    }
+
+    return abs(value - lastValue) >= m_GamepadAxisChangeThreshold;
+}
+
+void SdlInputHandler::flushPendingGamepadStates()
+{
+    // The timer is one-shot and has already fired
+    m_GamepadFlushTimer = 0;
+
+    for (int i = 0; i < MAX_GAMEPADS; i++) {
+        GamepadState* state = &m_GamepadState[i];
+        if (state->analogUpdatePending && state->mouseEmulationTimer == 0) {
+            sendGamepadState(state);
+        }
+    }
+}
+
+Uint32 SdlInputHandler::gamepadFlushTimerCallback(Uint32, void*)
+{
+    // Send the pending updates from the main thread, which owns the gamepad state
+    SDL_Event event = {};
+    event.type = SDL_USEREVENT;
+    event.user.code = SDL_CODE_GAMECONTROLLER_FLUSH_STATE;
+    SDL_PushEvent(&event);
+
+    return 0;
 }
 
 void SdlInputHandler::sendGamepadBatteryState(GamepadState* state, SDL_JoystickPowerLevel level)
@@ -190,65 +294,79 @@ Uint32 SdlInputHandler::mouseEmulationTimerCallback(Uint32 interval, void *param
 
 void SdlInputHandler::handleControllerAxisEvent(SDL_ControllerAxisEvent* event)
 {
-    SDL_JoystickID gameControllerId = event->which;
-    GamepadState* state = findStateForGamepad(gameControllerId);
-    if (state == NULL) {
-        return;
-    }
+    GamepadState* updatedStates[MAX_GAMEPADS];
+    int updatedStateCount = 0;
 
-    // Batch all pending axis motion events for this gamepad to save CPU time
+    // Batch all pending axis motion events to save CPU time. This includes
+    // events from other gamepads, so each one sends at most one update.
     SDL_Event nextEvent;
     for (;;) {
-        switch (event->axis)
-        {
-            case SDL_CONTROLLER_AXIS_LEFTX:
-                state->lsX = event->value;
-                break;
-            case SDL_CONTROLLER_AXIS_LEFTY:
-                // Signed values have one more negative value than
-                // positive value, so inverting the sign on -32768
-                // could actually cause the value to overflow and
-                // wrap around to be negative again. Avoid that by
-                // capping the value at 32767.
-                state->lsY = -qMax(event->value, (short)-32767);
-                break;
-            case SDL_CONTROLLER_AXIS_RIGHTX:
-                state->rsX = event->value;
-                break;
-            case SDL_CONTROLLER_AXIS_RIGHTY:
-                state->rsY = -qMax(event->value, (short)-32767);
-                break;
-            case SDL_CONTROLLER_AXIS_TRIGGERLEFT:
-                state->lt = (unsigned char)(event->value * 255UL / 32767);
-                break;
-            case SDL_CONTROLLER_AXIS_TRIGGERRIGHT:
-                state->rt = (unsigned char)(event->value * 255UL / 32767);
-                break;
-            default:
-                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
-                            "Unhandled controller axis: %d",
-                            event->axis);
-                return;
+        GamepadState* state = findStateForGamepad(event->which);
+        if (state != NULL) {
+            switch (event->axis)
+            {
+                case SDL_CONTROLLER_AXIS_LEFTX:
+                    state->lsX = event->value;
+                    break;
+                case SDL_CONTROLLER_AXIS_LEFTY:
+                    // Signed values have one more negative value than
+                    // positive value, so inverting the sign on -32768
+                    // could actually cause the value to overflow and
+                    // wrap around to be negative again. Avoid that by
+                    // capping the value at 32767.
+                    state->lsY = -qMax(event->value, (short)-32767);
+                    break;
+                case SDL_CONTROLLER_AXIS_RIGHTX:
+                    state->rsX = event->value;
+                    break;
+                case SDL_CONTROLLER_AXIS_RIGHTY:
+                    state->rsY = -qMax(event->value, (short)-32767);
+                    break;
+                case SDL_CONTROLLER_AXIS_TRIGGERLEFT:
+                    state->lt = (unsigned char)(event->value * 255UL / 32767);
+                    break;
+                case SDL_CONTROLLER_AXIS_TRIGGERRIGHT:
+                    state->rt = (unsigned char)(event->value * 255UL / 32767);
+                    break;
+                default:
+                    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                                "Unhandled controller axis: %d",
+                                event->axis);
+                    state = NULL;
+                    break;
+            }
+
+            if (state != NULL) {
+                // Changes made in mouse emulation mode are never sent to the host
+                if (state->pendingEventTime == 0 && state->mouseEmulationTimer == 0) {
+                    state->pendingEventTime = event->timestamp;
+                }
+
+                int i;
+                for (i = 0; i < updatedStateCount; i++) {
+                    if (updatedStates[i] == state) {
+                        break;
+                    }
+                }
+                if (i == updatedStateCount) {
+                    updatedStates[updatedStateCount++] = state;
+                }
+            }
         }
 
         // Check for another event to batch with
-        if (SDL_PeepEvents(&nextEvent, 1, SDL_PEEKEVENT, SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERAXISMOTION) <= 0) {
+        if (SDL_PeepEvents(&nextEvent, 1, SDL_GETEVENT, SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERAXISMOTION) <= 0) {
             break;
         }
 
         event = &nextEvent.caxis;
-        if (event->which != gameControllerId) {
-            // Stop batching if a different gamepad interrupts us
-            break;
-        }
-
-        // Remove the next event to batch
-        SDL_PeepEvents(&nextEvent, 1, SDL_GETEVENT, SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERAXISMOTION);
     }
 
-    // Only send the gamepad state to the host if it's not in mouse emulation mode
-    if (state->mouseEmulationTimer == 0) {
-        sendGamepadState(state);
+    for (int i = 0; i < updatedStateCount; i++) {
+        // Only send the gamepad state to the host if it's not in mouse emulation mode
+        if (updatedStates[i]->mouseEmulationTimer == 0) {
+            sendGamepadState(updatedStates[i], true);
+        }
     }
 }
 
@@ -334,6 +452,9 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
                 }
                 else if (m_GamepadMouse) {
                     // Send the start button up event to the host, since we won't do it below
+                    if (state->pendingEventTime == 0) {
+                        state->pendingEventTime = event->timestamp;
+                    }
                     sendGamepadState(state);
 
                     state->mouseEmulationTimer = SDL_AddTimer(MOUSE_EMULATION_POLLING_INTERVAL, SdlInputHandler::mouseEmulationTimerCallback, state);
@@ -377,6 +498,8 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         // Clear buttons down on this gamepad
         LiSendMultiControllerEvent(state->index, m_GamepadMask,
                                    0, 0, 0, 0, 0, 0, 0);
+        m_LastSentGamepadPackets[state->index].valid = false;
+        state->pendingEventTime = 0;
         return;
     }
 
@@ -392,17 +515,119 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         // Clear buttons down on this gamepad
         LiSendMultiControllerEvent(state->index, m_GamepadMask,
                                    0, 0, 0, 0, 0, 0, 0);
+        m_LastSentGamepadPackets[state->index].valid = false;
+        state->pendingEventTime = 0;
         return;
     }
 
     // Only send the gamepad state to the host if it's not in mouse emulation mode
     if (state->mouseEmulationTimer == 0) {
+        if (state->pendingEventTime == 0) {
+            state->pendingEventTime = event->timestamp;
+        }
         sendGamepadState(state);
     }
 }
 
 #if SDL_VERSION_ATLEAST(2, 0, 14)
 
+static uint64_t getSensorTimestampUs(SDL_ControllerSensorEvent* event)
+{
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+    // Use the sensor's own timestamp if it provides one
+    if (event->timestamp_us != 0) {
+        return event->timestamp_us;
+    }
+#endif
+
+    return (uint64_t)event->timestamp * 1000;
+}
+
+// Accumulates a sensor sample and returns true with the reduced value
+// for the host once a full report period has elapsed. The SDL timestamp
+// of the oldest sample in the reduced value is returned in oldestEventTime.
+static bool accumulateMotionSample(MotionSensorState& sensor, bool lowPass,
+                                   const float data[3], uint64_t timeUs, uint32_t eventTime,
+                                   float output[3], uint32_t& oldestEventTime)
+{
+    if (sensor.reportPeriodUs == 0) {
+        return false;
+    }
+
+    if (sensor.lastSampleUs == 0) {
+        // The first sample starts the first period
+        sensor.periodStartUs = timeUs;
+        sensor.lastSampleUs = timeUs;
+        sensor.pendingEventTime = eventTime;
+        if (lowPass) {
+            memcpy(sensor.accumulatedData, data, sizeof(sensor.accumulatedData));
+        }
+        return false;
+    }
+    else if (timeUs <= sensor.lastSampleUs) {
+        // Drop samples that we can't order in time
+        return false;
+    }
+    else {
+        float dt = (float)SDL_min(timeUs - sensor.lastSampleUs, (uint64_t)sensor.reportPeriodUs);
+
+        if (lowPass) {
+            // Single-pole filter with a cutoff at half of the report rate
+            float rc = sensor.reportPeriodUs / (float)M_PI;
+            float alpha = dt / (rc + dt);
+            for (int i = 0; i < 3; i++) {
+                sensor.accumulatedData[i] += alpha * (data[i] - sensor.accumulatedData[i]);
+            }
+        }
+        else {
+            // Weight each sample by the time it covers, so the average
+            // integrates the angular velocity over the report period
+            if (sensor.accumulatedWeight == 0.0f) {
+                SDL_zero(sensor.accumulatedData);
+            }
+            for (int i = 0; i < 3; i++) {
+                sensor.accumulatedData[i] += data[i] * dt;
+            }
+            sensor.accumulatedWeight += dt;
+        }
+    }
+    sensor.lastSampleUs = timeUs;
+    if (sensor.pendingEventTime == 0) {
+        sensor.pendingEventTime = eventTime;
+    }
+
+    if (timeUs - sensor.periodStartUs < sensor.reportPeriodUs) {
+        return false;
+    }
+
+    // The next report starts with the next sample
+    oldestEventTime = sensor.pendingEventTime;
+    sensor.pendingEventTime = 0;
+
+    if (lowPass) {
+        memcpy(output, sensor.accumulatedData, sizeof(sensor.accumulatedData));
+    }
+    else {
+        for (int i = 0; i < 3; i++) {
+            output[i] = sensor.accumulatedData[i] / sensor.accumulatedWeight;
+        }
+        sensor.accumulatedWeight = 0.0f;
+    }
+
+    // Stay aligned to the period grid unless we've fallen behind by more than a period
+    sensor.periodStartUs += sensor.reportPeriodUs;
+    if (timeUs - sensor.periodStartUs >= sensor.reportPeriodUs) {
+        sensor.periodStartUs = timeUs;
+    }
+
+    if (memcmp(output, sensor.lastSentData, sizeof(sensor.lastSentData)) == 0) {
+        return false;
+    }
+
+    memcpy(sensor.lastSentData, output, sizeof(sensor.lastSentData));
+    return true;
+}
+
 void SdlInputHandler::handleControllerSensorEvent(SDL_ControllerSensorEvent* event)
 {
     GamepadState* state = findStateForGamepad(event->which);
@@ -410,29 +635,25 @@ void SdlInputHandler::handleControllerSensorEvent(SDL_ControllerSensorEvent* eve
         return;
     }
 
+    uint64_t timeUs = getSensorTimestampUs(event);
+    uint32_t oldestEventTime;
+    float data[3];
+
     switch (event->sensor) {
     case SDL_SENSOR_ACCEL:
-        if (state->accelReportPeriodMs &&
-                SDL_TICKS_PASSED(event->timestamp, state->lastAccelEventTime + state->accelReportPeriodMs) &&
-                memcmp(event->data, state->lastAccelEventData, sizeof(event->data)) != 0) {
-            memcpy(state->lastAccelEventData, event->data, sizeof(event->data));
-            state->lastAccelEventTime = event->timestamp;
-
-            LiSendControllerMotionEvent((uint8_t)state->index, LI_MOTION_TYPE_ACCEL, event->data[0], event->data[1], event->data[2]);
+        if (accumulateMotionSample(state->accel, true, event->data, timeUs, event->timestamp, data, oldestEventTime)) {
+            LiSendControllerMotionEvent((uint8_t)state->index, LI_MOTION_TYPE_ACCEL, data[0], data[1], data[2]);
+            submitInputLatency(InputLatencyTracker::Motion, oldestEventTime);
         }
         break;
     case SDL_SENSOR_GYRO:
-        if (state->gyroReportPeriodMs &&
-                SDL_TICKS_PASSED(event->timestamp, state->lastGyroEventTime + state->gyroReportPeriodMs) &&
-                memcmp(event->data, state->lastGyroEventData, sizeof(event->data)) != 0) {
-            memcpy(state->lastGyroEventData, event->data, sizeof(event->data));
-            state->lastGyroEventTime = event->timestamp;
-
+        if (accumulateMotionSample(state->gyro, false, event->data, timeUs, event->timestamp, data, oldestEventTime)) {
             // Convert rad/s to deg/s
             LiSendControllerMotionEvent((uint8_t)state->index, LI_MOTION_TYPE_GYRO,
-                                        event->data[0] * 57.2957795f,
-                                        event->data[1] * 57.2957795f,
-                                        event->data[2] * 57.2957795f);
+                                        data[0] * 57.2957795f,
+                                        data[1] * 57.2957795f,
+                                        data[2] * 57.2957795f);
+            submitInputLatency(InputLatencyTracker::Motion, oldestEventTime);
         }
         break;
     }
@@ -461,6 +682,7 @@ void SdlInputHandler::handleControllerTouchpadEvent(SDL_ControllerTouchpadEvent*
     }
 
     LiSendControllerTouchEvent((uint8_t)state->index, eventType, event->finger, event->x, event->y, event->pressure);
+    submitInputLatency(InputLatencyTracker::Gamepad, event->timestamp);
 }
 
 #endif
@@ -752,6 +974,7 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
             // Send a final event to let the PC know this gamepad is gone
             LiSendMultiControllerEvent(state->index, m_GamepadMask,
                                        0, 0, 0, 0, 0, 0, 0);
+            m_LastSentGamepadPackets[state->index].valid = false;
 
             // Clear all remaining state from this slot
             SDL_memset(state, 0, sizeof(*state));
@@ -869,16 +1092,17 @@ void SdlInputHandler::setMotionEventState(uint16_t controllerNumber, uint8_t mot
 
 #if SDL_VERSION_ATLEAST(2, 0, 14)
     if (m_GamepadState[controllerNumber].controller != nullptr) {
-        uint8_t reportPeriodMs = reportRateHz ? (1000 / reportRateHz) : 0;
+        MotionSensorState newState = {};
+        newState.reportPeriodUs = reportRateHz ? (1000000 / reportRateHz) : 0;
 
         switch (motionType) {
         case LI_MOTION_TYPE_ACCEL:
-            m_GamepadState[controllerNumber].accelReportPeriodMs = reportPeriodMs;
+            m_GamepadState[controllerNumber].accel = newState;
             SDL_GameControllerSetSensorEnabled(m_GamepadState[controllerNumber].controller, SDL_SENSOR_ACCEL, reportRateHz ? SDL_TRUE : SDL_FALSE);
             break;
 
         case LI_MOTION_TYPE_GYRO:
-            m_GamepadState[controllerNumber].gyroReportPeriodMs = reportPeriodMs;
+            m_GamepadState[controllerNumber].gyro = newState;
             SDL_GameControllerSetSensorEnabled(m_GamepadState[controllerNumber].controller, SDL_SENSOR_GYRO, reportRateHz ? SDL_TRUE : SDL_FALSE);
             break;
         }
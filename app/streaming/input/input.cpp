@@ -5,6 +5,10 @@
 #include "path.h"
 #include "utils.h"
 
+#ifdef HAVE_EVDEV
+#include "evdevmouse.h"
+#endif
+
 #include <QtGlobal>
 #include <QDir>
 #include <QGuiApplication>
@@ -19,6 +23,8 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
       m_PendingMouseButtonsAllUpOnVideoRegionLeave(false),
       m_PointerRegionLockActive(false),
       m_PointerRegionLockToggledByUser(false),
+      m_GamepadFlushTimer(0),
+      m_KeysDown(256),
       m_FakeCaptureActive(false),
       m_CaptureSystemKeysMode(prefs.captureSysKeysMode),
       m_MouseCursorCapturedVisibilityState(SDL_DISABLE),
@@ -32,13 +38,31 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
       m_RightButtonReleaseTimer(0),
       m_DragTimer(0),
       m_DragButton(0),
-      m_NumFingersDown(0)
+      m_NumFingersDown(0),
+      m_PendingTouchDeltaX(0),
+      m_PendingTouchDeltaY(0),
+      m_PendingTouchDeltaTime(0),
+      m_LastTouchDeltaSendTime(0),
+      m_TouchFlushTimer(0)
 {
     // System keys are always captured when running without a DE
     if (!WMUtils::isRunningDesktopEnvironment()) {
         m_CaptureSystemKeysMode = StreamingPreferences::CSK_ALWAYS;
     }
 
+    if (!Utils::getEnvironmentVariableOverride("GAMEPAD_COALESCE_WINDOW_MS", &m_GamepadCoalesceWindowMs)) {
+        m_GamepadCoalesceWindowMs = DEFAULT_GAMEPAD_COALESCE_WINDOW_MS;
+    }
+    if (!Utils::getEnvironmentVariableOverride("GAMEPAD_AXIS_CHANGE_THRESHOLD", &m_GamepadAxisChangeThreshold)) {
+        m_GamepadAxisChangeThreshold = DEFAULT_GAMEPAD_AXIS_CHANGE_THRESHOLD;
+    }
+    if (!Utils::getEnvironmentVariableOverride("TOUCH_COALESCE_WINDOW_MS", &m_TouchCoalesceWindowMs)) {
+        m_TouchCoalesceWindowMs = DEFAULT_TOUCH_COALESCE_WINDOW_MS(prefs.fps);
+    }
+    if (!Utils::getEnvironmentVariableOverride("TOUCH_PREDICTION_MS", &m_TouchPredictionMs)) {
+        m_TouchPredictionMs = DEFAULT_TOUCH_PREDICTION_MS;
+    }
+
     // Allow gamepad input when the app doesn't have focus if requested
     SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, prefs.backgroundGamepad ? "1" : "0");
 
@@ -116,6 +140,11 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
     m_SpecialKeyCombos[KeyComboQuitAndExit].scanCode = SDL_SCANCODE_E;
     m_SpecialKeyCombos[KeyComboQuitAndExit].enabled = true;
 
+    m_SpecialKeyCombos[KeyComboToggleFrameGraph].keyCombo = KeyComboToggleFrameGraph;
+    m_SpecialKeyCombos[KeyComboToggleFrameGraph].keyCode = SDLK_g;
+    m_SpecialKeyCombos[KeyComboToggleFrameGraph].scanCode = SDL_SCANCODE_G;
+    m_SpecialKeyCombos[KeyComboToggleFrameGraph].enabled = true;
+
     m_OldIgnoreDevices = SDL_GetHint(SDL_HINT_GAMECONTROLLER_IGNORE_DEVICES);
     m_OldIgnoreDevicesExcept = SDL_GetHint(SDL_HINT_GAMECONTROLLER_IGNORE_DEVICES_EXCEPT);
 
@@ -192,13 +221,24 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
     m_GamepadMask = getAttachedGamepadMask();
 
     SDL_zero(m_GamepadState);
+    SDL_zero(m_LastSentGamepadPackets);
     SDL_zero(m_LastTouchDownEvent);
     SDL_zero(m_LastTouchUpEvent);
     SDL_zero(m_TouchDownEvent);
+    SDL_zero(m_TouchPointers);
+
+#ifdef HAVE_EVDEV
+    m_EvdevMouse = EvdevMouseReader::create(&Session::get()->getInputLatencyTracker(),
+                                           m_SwapMouseButtons, m_ReverseScrollDirection);
+#endif
 }
 
 SdlInputHandler::~SdlInputHandler()
 {
+#ifdef HAVE_EVDEV
+    delete m_EvdevMouse;
+#endif
+
     for (int i = 0; i < MAX_GAMEPADS; i++) {
         if (m_GamepadState[i].mouseEmulationTimer != 0) {
             Session::get()->notifyMouseEmulationMode(false);
@@ -218,6 +258,8 @@ SdlInputHandler::~SdlInputHandler()
     SDL_RemoveTimer(m_LeftButtonReleaseTimer);
     SDL_RemoveTimer(m_RightButtonReleaseTimer);
     SDL_RemoveTimer(m_DragTimer);
+    SDL_RemoveTimer(m_GamepadFlushTimer);
+    SDL_RemoveTimer(m_TouchFlushTimer);
 
 #if !SDL_VERSION_ATLEAST(2, 0, 9)
     SDL_QuitSubSystem(SDL_INIT_HAPTIC);
@@ -246,6 +288,13 @@ SdlInputHandler::~SdlInputHandler()
 #endif
 }
 
+void SdlInputHandler::submitInputLatency(InputLatencyTracker::InputClass inputClass, uint32_t eventTime)
+{
+    // Called as the input is handed to moonlight-common-c, so this covers the time
+    // the input spent in SDL's queue and any time we held it for coalescing.
+    Session::get()->getInputLatencyTracker().submit(inputClass, (uint64_t)(SDL_GetTicks() - eventTime) * 1000);
+}
+
 void SdlInputHandler::setWindow(SDL_Window *window)
 {
     m_Window = window;
@@ -253,19 +302,22 @@ void SdlInputHandler::setWindow(SDL_Window *window)
 
 void SdlInputHandler::raiseAllKeys()
 {
-    if (m_KeysDown.isEmpty()) {
+    int keysDown = m_KeysDown.count(true);
+    if (keysDown == 0) {
         return;
     }
 
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "Raising %d keys",
-                (int)m_KeysDown.count());
+                keysDown);
 
-    for (auto keyDown : std::as_const(m_KeysDown)) {
-        LiSendKeyboardEvent(keyDown, KEY_ACTION_UP, 0);
+    for (int keyCode = 0; keyCode < m_KeysDown.size(); keyCode++) {
+        if (m_KeysDown.testBit(keyCode)) {
+            LiSendKeyboardEvent(keyCode, KEY_ACTION_UP, 0);
+        }
     }
 
-    m_KeysDown.clear();
+    m_KeysDown.fill(false);
 }
 
 void SdlInputHandler::notifyMouseLeave()
@@ -302,6 +354,10 @@ void SdlInputHandler::notifyFocusLost()
     // used in shortcuts that cause focus loss (such as Alt+Tab) may get stuck down.
     raiseAllKeys();
 
+    // Release raw mice even if we're still captured in full-screen, since they
+    // would otherwise be unusable in the window that now has focus.
+    updateRawMouseGrabState();
+
 #ifdef Q_OS_WIN32
     // Re-enable text input when window loses focus as a workaround for an SDL bug.
     // See #1617 for details.
@@ -316,6 +372,8 @@ void SdlInputHandler::notifyFocusGained()
     // See #1617 for details.
     SDL_StopTextInput();
 #endif
+
+    updateRawMouseGrabState();
 }
 
 bool SdlInputHandler::isCaptureActive()
@@ -352,6 +410,23 @@ void SdlInputHandler::updateKeyboardGrabState()
 #endif
 }
 
+void SdlInputHandler::updateRawMouseGrabState()
+{
+#ifdef HAVE_EVDEV
+    if (m_EvdevMouse == nullptr) {
+        return;
+    }
+
+    // Raw mice only replace SDL's relative motion, so absolute mode stays on SDL
+    bool shouldGrab = isCaptureActive() && !m_AbsoluteMouseMode &&
+                      (SDL_GetWindowFlags(m_Window) & SDL_WINDOW_INPUT_FOCUS);
+    if (!m_EvdevMouse->setGrabbed(shouldGrab)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Unable to grab raw mice. Using SDL mouse input.");
+    }
+#endif
+}
+
 bool SdlInputHandler::isSystemKeyCaptureActive()
 {
     if (m_CaptureSystemKeysMode == StreamingPreferences::CSK_OFF) {
@@ -434,6 +509,9 @@ void SdlInputHandler::setCaptureActive(bool active)
 
     // Now update the keyboard grab
     updateKeyboardGrabState();
+
+    // Route relative mouse input through evdev if it's enabled
+    updateRawMouseGrabState();
 }
 
 void SdlInputHandler::handleTouchFingerEvent(SDL_TouchFingerEvent* event)
@@ -2,9 +2,35 @@
 
 #include "settings/streamingpreferences.h"
 #include "backend/computermanager.h"
+#include "streaming/inputlatency.h"
 
 #include "SDL_compat.h"
 
+#include <QBitArray>
+
+#ifdef HAVE_EVDEV
+class EvdevMouseReader;
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+// Sensor samples are accumulated at the full IMU rate and reduced
+// to a single motion event per report period requested by the host
+struct MotionSensorState {
+    uint32_t reportPeriodUs;
+    uint64_t periodStartUs;
+    uint64_t lastSampleUs;
+
+    // Time-weighted sum for the gyro, low-pass filtered value for the accelerometer
+    float accumulatedData[3];
+    float accumulatedWeight;
+
+    float lastSentData[3];
+
+    // SDL timestamp of the oldest sample in the current report period, or 0 if none
+    uint32_t pendingEventTime;
+};
+#endif
+
 struct GamepadState {
     SDL_GameController* controller;
     SDL_JoystickID jsId;
@@ -23,19 +49,20 @@ struct GamepadState {
     bool emulatedClickpadButtonDown;
 
 #if SDL_VERSION_ATLEAST(2, 0, 14)
-    uint8_t gyroReportPeriodMs;
-    float lastGyroEventData[SDL_arraysize(SDL_ControllerSensorEvent::data)];
-    uint32_t lastGyroEventTime;
-
-    uint8_t accelReportPeriodMs;
-    float lastAccelEventData[SDL_arraysize(SDL_ControllerSensorEvent::data)];
-    uint32_t lastAccelEventTime;
+    MotionSensorState gyro;
+    MotionSensorState accel;
 #endif
 
     int buttons;
     short lsX, lsY;
     short rsX, rsY;
     unsigned char lt, rt;
+
+    // Set while coalesced analog changes are waiting to be sent
+    bool analogUpdatePending;
+
+    // SDL timestamp of the oldest change not yet sent to the host, or 0 if none
+    uint32_t pendingEventTime;
 };
 
 
@@ -74,6 +101,15 @@ struct DualSenseOutputReport{
 
 #define MAX_FINGERS 2
 
+// Native touch and pen pointers tracked for motion coalescing
+#define MAX_TOUCH_POINTERS 10
+
+// Posted to the main loop when coalesced gamepad state is due to be sent
+#define SDL_CODE_GAMECONTROLLER_FLUSH_STATE 106
+
+// Posted to the main loop when coalesced touch motion is due to be sent
+#define SDL_CODE_TOUCH_FLUSH_STATE 107
+
 #define GAMEPAD_HAPTIC_METHOD_NONE 0
 #define GAMEPAD_HAPTIC_METHOD_LEFTRIGHT 1
 #define GAMEPAD_HAPTIC_METHOD_SIMPLERUMBLE 2
@@ -81,6 +117,43 @@ struct DualSenseOutputReport{
 #define GAMEPAD_HAPTIC_SIMPLE_HIFREQ_MOTOR_WEIGHT 0.33
 #define GAMEPAD_HAPTIC_SIMPLE_LOWFREQ_MOTOR_WEIGHT 0.8
 
+// Analog-only updates are sent at most once per window for each gamepad
+// (overridable with GAMEPAD_COALESCE_WINDOW_MS)
+#define DEFAULT_GAMEPAD_COALESCE_WINDOW_MS 1
+
+// Stick movements smaller than this are dropped as noise unless they reach
+// the center or an edge (overridable with GAMEPAD_AXIS_CHANGE_THRESHOLD)
+#define DEFAULT_GAMEPAD_AXIS_CHANGE_THRESHOLD 16
+
+// Touch motion is sent at most once per video frame interval for each pointer,
+// while touch down and up are always sent immediately (overridable with
+// TOUCH_COALESCE_WINDOW_MS, where 0 sends every motion event)
+#define DEFAULT_TOUCH_COALESCE_WINDOW_MS(fps) ((fps) > 0 ? 1000 / (fps) : 0)
+
+// How far ahead native touch motion is extrapolated to offset network latency
+// for drawing apps. Disabled by default (overridable with TOUCH_PREDICTION_MS)
+#define DEFAULT_TOUCH_PREDICTION_MS 0
+
+struct TouchPointerState {
+    bool active;
+    bool isPen;
+    uint32_t pointerId;
+
+    // Video-relative position from the latest event
+    float x, y;
+    float pressure;
+
+    // Smoothed velocity in video-relative units per millisecond
+    float velocityX, velocityY;
+    uint32_t lastEventTime;
+
+    uint32_t lastSendTime;
+    bool motionPending;
+
+    // SDL timestamp of the oldest motion held since the last send
+    uint32_t pendingEventTime;
+};
+
 class SdlInputHandler
 {
 public:
@@ -116,6 +189,10 @@ public:
 
     void handleJoystickArrivalEvent(SDL_JoyDeviceEvent* event);
 
+    void flushPendingGamepadStates();
+
+    void flushPendingTouchMotion();
+
     void sendText(QString& string);
 
     void rumble(uint16_t controllerNumber, uint16_t lowFreqMotor, uint16_t highFreqMotor);
@@ -150,6 +227,8 @@ public:
 
     void updateKeyboardGrabState();
 
+    void updateRawMouseGrabState();
+
     void updatePointerRegionLock();
 
     static
@@ -167,13 +246,27 @@ private:
         KeyComboPasteText,
         KeyComboTogglePointerRegionLock,
         KeyComboQuitAndExit,
+        KeyComboToggleFrameGraph,
         KeyComboMax
     };
 
     GamepadState*
     findStateForGamepad(SDL_JoystickID id);
 
-    void sendGamepadState(GamepadState* state);
+    struct GamepadPacket {
+        bool valid;
+        int buttons;
+        unsigned char lt, rt;
+        short lsX, lsY;
+        short rsX, rsY;
+        uint32_t sendTime;
+    };
+
+    void submitInputLatency(InputLatencyTracker::InputClass inputClass, uint32_t eventTime);
+
+    void sendGamepadState(GamepadState* state, bool analogOnly = false);
+
+    bool isSignificantAxisChange(short lastValue, short value);
 
     void sendGamepadBatteryState(GamepadState* state, SDL_JoystickPowerLevel level);
 
@@ -183,8 +276,17 @@ private:
 
     void disableTouchFeedback();
 
+    void sendNativeTouchEvent(uint8_t eventType, uint32_t pointerId, bool isPen,
+                              float x, float y, float pressure, uint32_t timestamp);
+
+    void sendTouchPointerMotion(TouchPointerState* pointer);
+
+    void scheduleTouchFlush();
+
     void handleRelativeFingerEvent(SDL_TouchFingerEvent* event);
 
+    void sendPendingTouchDelta();
+
     void performSpecialKeyCombo(KeyCombo combo);
 
     static
@@ -193,6 +295,12 @@ private:
     static
     Uint32 mouseEmulationTimerCallback(Uint32 interval, void* param);
 
+    static
+    Uint32 gamepadFlushTimerCallback(Uint32 interval, void* param);
+
+    static
+    Uint32 touchFlushTimerCallback(Uint32 interval, void* param);
+
     static
     Uint32 releaseLeftButtonTimerCallback(Uint32 interval, void* param);
 
@@ -216,7 +324,11 @@ private:
 
     int m_GamepadMask;
     GamepadState m_GamepadState[MAX_GAMEPADS];
-    QSet<short> m_KeysDown;
+    GamepadPacket m_LastSentGamepadPackets[MAX_GAMEPADS];
+    SDL_TimerID m_GamepadFlushTimer;
+    uint32_t m_GamepadCoalesceWindowMs;
+    int m_GamepadAxisChangeThreshold;
+    QBitArray m_KeysDown; // Indexed by VK code
     bool m_FakeCaptureActive;
     QString m_OldIgnoreDevices;
     QString m_OldIgnoreDevicesExcept;
@@ -246,6 +358,19 @@ private:
     SDL_TimerID m_DragTimer;
     char m_DragButton;
     int m_NumFingersDown;
+    float m_PendingTouchDeltaX;
+    float m_PendingTouchDeltaY;
+    uint32_t m_PendingTouchDeltaTime;
+    uint32_t m_LastTouchDeltaSendTime;
+
+    TouchPointerState m_TouchPointers[MAX_TOUCH_POINTERS];
+    SDL_TimerID m_TouchFlushTimer;
+    uint32_t m_TouchCoalesceWindowMs;
+    int m_TouchPredictionMs;
+
+#ifdef HAVE_EVDEV
+    EvdevMouseReader* m_EvdevMouse;
+#endif
 
     static const int k_ButtonMap[];
 };
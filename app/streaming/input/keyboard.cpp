@@ -13,6 +13,116 @@
 #define VK_NUMPAD0 0x60
 #endif
 
+// Flags for entries in the scancode translation table
+#define KEY_FLAG_SYSTEM_KEY 0x01        // Only sent while system keys are captured
+#define KEY_FLAG_NON_NORMALIZED 0x02    // Sent with SS_KBE_FLAG_NON_NORMALIZED
+
+struct KeyTranslation {
+    short keyCode; // 0 for unhandled scancodes
+    uint8_t flags;
+};
+
+struct KeyTranslationTable {
+    KeyTranslation entries[SDL_NUM_SCANCODES];
+};
+
+static constexpr void mapKey(KeyTranslationTable& table, SDL_Scancode scancode, short keyCode, uint8_t flags = 0)
+{
+    table.entries[scancode] = { keyCode, flags };
+}
+
+// We explicitly use scancodes here because GFE will try to correct for AZERTY
+// layouts on the host but it depends on receiving VK_ values matching a QWERTY
+// layout to work, so the table doesn't depend on the client's keyboard layout.
+static constexpr KeyTranslationTable buildKeyTranslationTable()
+{
+    KeyTranslationTable table = {};
+
+    // SDL defines SDL_SCANCODE_0 > SDL_SCANCODE_9 (and SDL_SCANCODE_KP_0 > SDL_SCANCODE_KP_9),
+    // so the zero keys are mapped individually below.
+    for (int i = 0; i < 9; i++) {
+        mapKey(table, (SDL_Scancode)(SDL_SCANCODE_1 + i), VK_0 + 1 + i);
+        mapKey(table, (SDL_Scancode)(SDL_SCANCODE_KP_1 + i), VK_NUMPAD0 + 1 + i);
+    }
+    for (int i = 0; i <= SDL_SCANCODE_Z - SDL_SCANCODE_A; i++) {
+        mapKey(table, (SDL_Scancode)(SDL_SCANCODE_A + i), VK_A + i);
+    }
+    for (int i = 0; i < 12; i++) {
+        mapKey(table, (SDL_Scancode)(SDL_SCANCODE_F1 + i), VK_F1 + i);
+        mapKey(table, (SDL_Scancode)(SDL_SCANCODE_F13 + i), VK_F13 + i);
+    }
+
+    mapKey(table, SDL_SCANCODE_BACKSPACE, 0x08);
+    mapKey(table, SDL_SCANCODE_TAB, 0x09);
+    mapKey(table, SDL_SCANCODE_CLEAR, 0x0C);
+    mapKey(table, SDL_SCANCODE_KP_ENTER, 0x0D); // FIXME: Is this correct?
+    mapKey(table, SDL_SCANCODE_RETURN, 0x0D);
+    mapKey(table, SDL_SCANCODE_PAUSE, 0x13);
+    mapKey(table, SDL_SCANCODE_CAPSLOCK, 0x14);
+    mapKey(table, SDL_SCANCODE_ESCAPE, 0x1B);
+    mapKey(table, SDL_SCANCODE_SPACE, 0x20);
+    mapKey(table, SDL_SCANCODE_PAGEUP, 0x21);
+    mapKey(table, SDL_SCANCODE_PAGEDOWN, 0x22);
+    mapKey(table, SDL_SCANCODE_END, 0x23);
+    mapKey(table, SDL_SCANCODE_HOME, 0x24);
+    mapKey(table, SDL_SCANCODE_LEFT, 0x25);
+    mapKey(table, SDL_SCANCODE_UP, 0x26);
+    mapKey(table, SDL_SCANCODE_RIGHT, 0x27);
+    mapKey(table, SDL_SCANCODE_DOWN, 0x28);
+    mapKey(table, SDL_SCANCODE_SELECT, 0x29);
+    mapKey(table, SDL_SCANCODE_EXECUTE, 0x2B);
+    mapKey(table, SDL_SCANCODE_PRINTSCREEN, 0x2C);
+    mapKey(table, SDL_SCANCODE_INSERT, 0x2D);
+    mapKey(table, SDL_SCANCODE_DELETE, 0x2E);
+    mapKey(table, SDL_SCANCODE_HELP, 0x2F);
+    mapKey(table, SDL_SCANCODE_KP_0, VK_NUMPAD0);
+    mapKey(table, SDL_SCANCODE_0, VK_0);
+    mapKey(table, SDL_SCANCODE_KP_MULTIPLY, 0x6A);
+    mapKey(table, SDL_SCANCODE_KP_PLUS, 0x6B);
+    mapKey(table, SDL_SCANCODE_KP_COMMA, 0x6C);
+    mapKey(table, SDL_SCANCODE_KP_MINUS, 0x6D);
+    mapKey(table, SDL_SCANCODE_KP_PERIOD, 0x6E);
+    mapKey(table, SDL_SCANCODE_KP_DIVIDE, 0x6F);
+    mapKey(table, SDL_SCANCODE_NUMLOCKCLEAR, 0x90);
+    mapKey(table, SDL_SCANCODE_SCROLLLOCK, 0x91);
+    mapKey(table, SDL_SCANCODE_LSHIFT, 0xA0);
+    mapKey(table, SDL_SCANCODE_RSHIFT, 0xA1);
+    mapKey(table, SDL_SCANCODE_LCTRL, 0xA2);
+    mapKey(table, SDL_SCANCODE_RCTRL, 0xA3);
+    mapKey(table, SDL_SCANCODE_LALT, 0xA4);
+    mapKey(table, SDL_SCANCODE_RALT, 0xA5);
+    mapKey(table, SDL_SCANCODE_LGUI, 0x5B, KEY_FLAG_SYSTEM_KEY);
+    mapKey(table, SDL_SCANCODE_RGUI, 0x5C, KEY_FLAG_SYSTEM_KEY);
+    mapKey(table, SDL_SCANCODE_APPLICATION, 0x5D);
+    mapKey(table, SDL_SCANCODE_AC_BACK, 0xA6);
+    mapKey(table, SDL_SCANCODE_AC_FORWARD, 0xA7);
+    mapKey(table, SDL_SCANCODE_AC_REFRESH, 0xA8);
+    mapKey(table, SDL_SCANCODE_AC_STOP, 0xA9);
+    mapKey(table, SDL_SCANCODE_AC_SEARCH, 0xAA);
+    mapKey(table, SDL_SCANCODE_AC_BOOKMARKS, 0xAB);
+    mapKey(table, SDL_SCANCODE_AC_HOME, 0xAC);
+    mapKey(table, SDL_SCANCODE_SEMICOLON, 0xBA);
+    mapKey(table, SDL_SCANCODE_EQUALS, 0xBB);
+    mapKey(table, SDL_SCANCODE_COMMA, 0xBC);
+    mapKey(table, SDL_SCANCODE_MINUS, 0xBD);
+    mapKey(table, SDL_SCANCODE_PERIOD, 0xBE);
+    mapKey(table, SDL_SCANCODE_SLASH, 0xBF);
+    mapKey(table, SDL_SCANCODE_GRAVE, 0xC0);
+    mapKey(table, SDL_SCANCODE_LEFTBRACKET, 0xDB);
+    mapKey(table, SDL_SCANCODE_INTERNATIONAL3, 0xDC, KEY_FLAG_NON_NORMALIZED);
+    mapKey(table, SDL_SCANCODE_BACKSLASH, 0xDC);
+    mapKey(table, SDL_SCANCODE_RIGHTBRACKET, 0xDD);
+    mapKey(table, SDL_SCANCODE_APOSTROPHE, 0xDE);
+    mapKey(table, SDL_SCANCODE_INTERNATIONAL1, 0xE2, KEY_FLAG_NON_NORMALIZED);
+    mapKey(table, SDL_SCANCODE_NONUSBACKSLASH, 0xE2);
+    mapKey(table, SDL_SCANCODE_LANG1, 0x1C);
+    mapKey(table, SDL_SCANCODE_LANG2, 0x1D);
+
+    return table;
+}
+
+static constexpr KeyTranslationTable k_KeyTranslationTable = buildKeyTranslationTable();
+
 void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
 {
     switch (combo) {
@@ -153,6 +263,15 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
         SDL_PushEvent(&quitExitEvent);
         break;
 
+    case KeyComboToggleFrameGraph:
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Detected frame graph toggle combo");
+
+        // Toggle the frame time graph overlay
+        Session::get()->getOverlayManager().setOverlayState(Overlay::OverlayFrameGraph,
+                                                            !Session::get()->getOverlayManager().isOverlayEnabled(Overlay::OverlayFrameGraph));
+        break;
+
     default:
         Q_UNREACHABLE();
     }
@@ -160,9 +279,7 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
 
 void SdlInputHandler::handleKeyEvent(SDL_KeyboardEvent* event)
 {
-    short keyCode;
     char modifiers;
-    bool shouldNotConvertToScanCodeOnServer = false;
 
     if (event->repeat) {
         // Ignore repeat key down events
@@ -218,248 +335,28 @@ void SdlInputHandler::handleKeyEvent(SDL_KeyboardEvent* event)
         }
     }
 
-    // Set keycode. We explicitly use scancode here because GFE will try to correct
-    // for AZERTY layouts on the host but it depends on receiving VK_ values matching
-    // a QWERTY layout to work.
-    if (event->keysym.scancode >= SDL_SCANCODE_1 && event->keysym.scancode <= SDL_SCANCODE_9) {
-        // SDL defines SDL_SCANCODE_0 > SDL_SCANCODE_9, so we need to handle that manually
-        keyCode = (event->keysym.scancode - SDL_SCANCODE_1) + VK_0 + 1;
-    }
-    else if (event->keysym.scancode >= SDL_SCANCODE_A && event->keysym.scancode <= SDL_SCANCODE_Z) {
-        keyCode = (event->keysym.scancode - SDL_SCANCODE_A) + VK_A;
-    }
-    else if (event->keysym.scancode >= SDL_SCANCODE_F1 && event->keysym.scancode <= SDL_SCANCODE_F12) {
-        keyCode = (event->keysym.scancode - SDL_SCANCODE_F1) + VK_F1;
-    }
-    else if (event->keysym.scancode >= SDL_SCANCODE_F13 && event->keysym.scancode <= SDL_SCANCODE_F24) {
-        keyCode = (event->keysym.scancode - SDL_SCANCODE_F13) + VK_F13;
-    }
-    else if (event->keysym.scancode >= SDL_SCANCODE_KP_1 && event->keysym.scancode <= SDL_SCANCODE_KP_9) {
-        // SDL defines SDL_SCANCODE_KP_0 > SDL_SCANCODE_KP_9, so we need to handle that manually
-        keyCode = (event->keysym.scancode - SDL_SCANCODE_KP_1) + VK_NUMPAD0 + 1;
+    // Translate the scancode with a single table lookup
+    static const KeyTranslation k_Unhandled = {};
+    const KeyTranslation& translation = (unsigned int)event->keysym.scancode < SDL_NUM_SCANCODES ?
+                                            k_KeyTranslationTable.entries[event->keysym.scancode] : k_Unhandled;
+    if (translation.keyCode == 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Unhandled button event: %d",
+                     event->keysym.scancode);
+        return;
     }
-    else {
-        switch (event->keysym.scancode) {
-            case SDL_SCANCODE_BACKSPACE:
-                keyCode = 0x08;
-                break;
-            case SDL_SCANCODE_TAB:
-                keyCode = 0x09;
-                break;
-            case SDL_SCANCODE_CLEAR:
-                keyCode = 0x0C;
-                break;
-            case SDL_SCANCODE_KP_ENTER: // FIXME: Is this correct?
-            case SDL_SCANCODE_RETURN:
-                keyCode = 0x0D;
-                break;
-            case SDL_SCANCODE_PAUSE:
-                keyCode = 0x13;
-                break;
-            case SDL_SCANCODE_CAPSLOCK:
-                keyCode = 0x14;
-                break;
-            case SDL_SCANCODE_ESCAPE:
-                keyCode = 0x1B;
-                break;
-            case SDL_SCANCODE_SPACE:
-                keyCode = 0x20;
-                break;
-            case SDL_SCANCODE_PAGEUP:
-                keyCode = 0x21;
-                break;
-            case SDL_SCANCODE_PAGEDOWN:
-                keyCode = 0x22;
-                break;
-            case SDL_SCANCODE_END:
-                keyCode = 0x23;
-                break;
-            case SDL_SCANCODE_HOME:
-                keyCode = 0x24;
-                break;
-            case SDL_SCANCODE_LEFT:
-                keyCode = 0x25;
-                break;
-            case SDL_SCANCODE_UP:
-                keyCode = 0x26;
-                break;
-            case SDL_SCANCODE_RIGHT:
-                keyCode = 0x27;
-                break;
-            case SDL_SCANCODE_DOWN:
-                keyCode = 0x28;
-                break;
-            case SDL_SCANCODE_SELECT:
-                keyCode = 0x29;
-                break;
-            case SDL_SCANCODE_EXECUTE:
-                keyCode = 0x2B;
-                break;
-            case SDL_SCANCODE_PRINTSCREEN:
-                keyCode = 0x2C;
-                break;
-            case SDL_SCANCODE_INSERT:
-                keyCode = 0x2D;
-                break;
-            case SDL_SCANCODE_DELETE:
-                keyCode = 0x2E;
-                break;
-            case SDL_SCANCODE_HELP:
-                keyCode = 0x2F;
-                break;
-            case SDL_SCANCODE_KP_0:
-                // See comment above about why we only handle SDL_SCANCODE_KP_0 here
-                keyCode = VK_NUMPAD0;
-                break;
-            case SDL_SCANCODE_0:
-                // See comment above about why we only handle SDL_SCANCODE_0 here
-                keyCode = VK_0;
-                break;
-            case SDL_SCANCODE_KP_MULTIPLY:
-                keyCode = 0x6A;
-                break;
-            case SDL_SCANCODE_KP_PLUS:
-                keyCode = 0x6B;
-                break;
-            case SDL_SCANCODE_KP_COMMA:
-                keyCode = 0x6C;
-                break;
-            case SDL_SCANCODE_KP_MINUS:
-                keyCode = 0x6D;
-                break;
-            case SDL_SCANCODE_KP_PERIOD:
-                keyCode = 0x6E;
-                break;
-            case SDL_SCANCODE_KP_DIVIDE:
-                keyCode = 0x6F;
-                break;
-            case SDL_SCANCODE_NUMLOCKCLEAR:
-                keyCode = 0x90;
-                break;
-            case SDL_SCANCODE_SCROLLLOCK:
-                keyCode = 0x91;
-                break;
-            case SDL_SCANCODE_LSHIFT:
-                keyCode = 0xA0;
-                break;
-            case SDL_SCANCODE_RSHIFT:
-                keyCode = 0xA1;
-                break;
-            case SDL_SCANCODE_LCTRL:
-                keyCode = 0xA2;
-                break;
-            case SDL_SCANCODE_RCTRL:
-                keyCode = 0xA3;
-                break;
-            case SDL_SCANCODE_LALT:
-                keyCode = 0xA4;
-                break;
-            case SDL_SCANCODE_RALT:
-                keyCode = 0xA5;
-                break;
-            case SDL_SCANCODE_LGUI:
-                if (!isSystemKeyCaptureActive()) {
-                    return;
-                }
-                keyCode = 0x5B;
-                break;
-            case SDL_SCANCODE_RGUI:
-                if (!isSystemKeyCaptureActive()) {
-                    return;
-                }
-                keyCode = 0x5C;
-                break;
-            case SDL_SCANCODE_APPLICATION:
-                keyCode = 0x5D;
-                break;
-            case SDL_SCANCODE_AC_BACK:
-                keyCode = 0xA6;
-                break;
-            case SDL_SCANCODE_AC_FORWARD:
-                keyCode = 0xA7;
-                break;
-            case SDL_SCANCODE_AC_REFRESH:
-                keyCode = 0xA8;
-                break;
-            case SDL_SCANCODE_AC_STOP:
-                keyCode = 0xA9;
-                break;
-            case SDL_SCANCODE_AC_SEARCH:
-                keyCode = 0xAA;
-                break;
-            case SDL_SCANCODE_AC_BOOKMARKS:
-                keyCode = 0xAB;
-                break;
-            case SDL_SCANCODE_AC_HOME:
-                keyCode = 0xAC;
-                break;
-            case SDL_SCANCODE_SEMICOLON:
-                keyCode = 0xBA;
-                break;
-            case SDL_SCANCODE_EQUALS:
-                keyCode = 0xBB;
-                break;
-            case SDL_SCANCODE_COMMA:
-                keyCode = 0xBC;
-                break;
-            case SDL_SCANCODE_MINUS:
-                keyCode = 0xBD;
-                break;
-            case SDL_SCANCODE_PERIOD:
-                keyCode = 0xBE;
-                break;
-            case SDL_SCANCODE_SLASH:
-                keyCode = 0xBF;
-                break;
-            case SDL_SCANCODE_GRAVE:
-                keyCode = 0xC0;
-                break;
-            case SDL_SCANCODE_LEFTBRACKET:
-                keyCode = 0xDB;
-                break;
-            case SDL_SCANCODE_INTERNATIONAL3:
-                shouldNotConvertToScanCodeOnServer = true;
-                Q_FALLTHROUGH();
-            case SDL_SCANCODE_BACKSLASH:
-                keyCode = 0xDC;
-                break;
-            case SDL_SCANCODE_RIGHTBRACKET:
-                keyCode = 0xDD;
-                break;
-            case SDL_SCANCODE_APOSTROPHE:
-                keyCode = 0xDE;
-                break;
-            case SDL_SCANCODE_INTERNATIONAL1:
-                shouldNotConvertToScanCodeOnServer = true;
-                Q_FALLTHROUGH();
-            case SDL_SCANCODE_NONUSBACKSLASH:
-                keyCode = 0xE2;
-                break;
-            case SDL_SCANCODE_LANG1:
-                keyCode = 0x1C;
-                break;
-            case SDL_SCANCODE_LANG2:
-                keyCode = 0x1D;
-                break;
-            default:
-                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
-                            "Unhandled button event: %d",
-                             event->keysym.scancode);
-                return;
-        }
+    else if ((translation.flags & KEY_FLAG_SYSTEM_KEY) && !isSystemKeyCaptureActive()) {
+        return;
     }
 
+    short keyCode = translation.keyCode;
+
     // Track the key state so we always know which keys are down
-    if (event->state == SDL_PRESSED) {
-        m_KeysDown.insert(keyCode);
-    }
-    else {
-        m_KeysDown.remove(keyCode);
-    }
+    m_KeysDown.setBit(keyCode, event->state == SDL_PRESSED);
 
     LiSendKeyboardEvent2(0x8000 | keyCode,
                         event->state == SDL_PRESSED ?
                             KEY_ACTION_DOWN : KEY_ACTION_UP,
                         modifiers,
-                        shouldNotConvertToScanCodeOnServer ? SS_KBE_FLAG_NON_NORMALIZED : 0);
+                        (translation.flags & KEY_FLAG_NON_NORMALIZED) ? SS_KBE_FLAG_NON_NORMALIZED : 0);
 }
@@ -44,6 +44,23 @@ Uint32 SdlInputHandler::dragTimerCallback(Uint32, void *param)
     return 0;
 }
 
+void SdlInputHandler::sendPendingTouchDelta()
+{
+    short deltaX = static_cast<short>(m_PendingTouchDeltaX);
+    short deltaY = static_cast<short>(m_PendingTouchDeltaY);
+    if (deltaX != 0 || deltaY != 0) {
+        LiSendMouseMoveEvent(deltaX, deltaY);
+        m_PendingTouchDeltaX -= deltaX;
+        m_PendingTouchDeltaY -= deltaY;
+        m_LastTouchDeltaSendTime = SDL_GetTicks();
+
+        if (m_PendingTouchDeltaTime != 0) {
+            submitInputLatency(InputLatencyTracker::Touch, m_PendingTouchDeltaTime);
+            m_PendingTouchDeltaTime = 0;
+        }
+    }
+}
+
 void SdlInputHandler::handleRelativeFingerEvent(SDL_TouchFingerEvent* event)
 {
     int fingerIndex = -1;
@@ -97,11 +114,29 @@ void SdlInputHandler::handleRelativeFingerEvent(SDL_TouchFingerEvent* event)
         // already have normalized values. We'll just multiply them
         // by the stream dimensions to get real X and Y values rather
         // than the client window dimensions.
-        short deltaX = static_cast<short>(event->dx * m_StreamWidth);
-        short deltaY = static_cast<short>(event->dy * m_StreamHeight);
-        if (deltaX != 0 || deltaY != 0) {
-            LiSendMouseMoveEvent(deltaX, deltaY);
+        //
+        // The fractional part is carried over so slow drags aren't lost to
+        // truncation, and motion is coalesced into one mouse move per window.
+        if (event->type == SDL_FINGERDOWN) {
+            m_PendingTouchDeltaX = m_PendingTouchDeltaY = 0;
+            m_PendingTouchDeltaTime = 0;
         }
+        m_PendingTouchDeltaX += event->dx * m_StreamWidth;
+        m_PendingTouchDeltaY += event->dy * m_StreamHeight;
+        if (m_PendingTouchDeltaTime == 0) {
+            m_PendingTouchDeltaTime = event->timestamp;
+        }
+        if (event->type != SDL_FINGERMOTION ||
+                SDL_GetTicks() - m_LastTouchDeltaSendTime >= m_TouchCoalesceWindowMs) {
+            sendPendingTouchDelta();
+        }
+        else {
+            scheduleTouchFlush();
+        }
+    }
+    else if (event->type == SDL_FINGERUP) {
+        // Deliver the primary finger's held motion before any tap or drag release
+        sendPendingTouchDelta();
     }
 
     // Start a drag timer when primary or secondary
@@ -0,0 +1,217 @@
+#include "inputlatency.h"
+
+#include <cstdio>
+
+static const uint32_t k_BucketBoundsMs[INPUT_LATENCY_BUCKETS - 1] = INPUT_LATENCY_BUCKET_BOUNDS_MS;
+
+InputLatencyTracker::InputLatencyTracker()
+    : m_Lock(0)
+{
+    SDL_zero(m_WindowStats);
+    SDL_zero(m_GlobalStats);
+    SDL_zero(m_WindowGamepadPackets);
+    SDL_zero(m_WindowGamepadCoalesced);
+    SDL_zero(m_GlobalGamepadPackets);
+    SDL_zero(m_GlobalGamepadCoalesced);
+    m_WindowStartTime = SDL_GetTicks();
+}
+
+const char* InputLatencyTracker::getClassName(InputClass inputClass)
+{
+    switch (inputClass) {
+    case Mouse:
+        return "Mouse";
+    case Keyboard:
+        return "Keyboard";
+    case Gamepad:
+        return "Gamepad";
+    case Touch:
+        return "Touch";
+    case Motion:
+        return "Motion";
+    default:
+        SDL_assert(false);
+        return "Unknown";
+    }
+}
+
+static void addSample(INPUT_LATENCY_STATS& stats, uint32_t queueTimeUs, int bucket)
+{
+    stats.events++;
+    stats.totalQueueTimeUs += queueTimeUs;
+    stats.maxQueueTimeUs = SDL_max(stats.maxQueueTimeUs, queueTimeUs);
+    stats.histogram[bucket]++;
+}
+
+void InputLatencyTracker::submit(InputClass inputClass, uint64_t queueTimeUs)
+{
+    uint32_t clampedTimeUs = (uint32_t)SDL_min(queueTimeUs, (uint64_t)UINT32_MAX);
+
+    int bucket = 0;
+    while (bucket < INPUT_LATENCY_BUCKETS - 1 && clampedTimeUs >= k_BucketBoundsMs[bucket] * 1000) {
+        bucket++;
+    }
+
+    SDL_AtomicLock(&m_Lock);
+    addSample(m_WindowStats[inputClass], clampedTimeUs, bucket);
+    addSample(m_GlobalStats[inputClass], clampedTimeUs, bucket);
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+void InputLatencyTracker::countGamepadUpdate(int controllerNumber, bool sent)
+{
+    if (controllerNumber < 0 || controllerNumber >= INPUT_LATENCY_MAX_GAMEPADS) {
+        SDL_assert(false);
+        return;
+    }
+
+    SDL_AtomicLock(&m_Lock);
+    if (sent) {
+        m_WindowGamepadPackets[controllerNumber]++;
+        m_GlobalGamepadPackets[controllerNumber]++;
+    }
+    else {
+        m_WindowGamepadCoalesced[controllerNumber]++;
+        m_GlobalGamepadCoalesced[controllerNumber]++;
+    }
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+// Returns the upper bound of the bucket containing the 99th percentile,
+// or 0 if it falls into the unbounded bucket.
+static uint32_t getP99BoundMs(const INPUT_LATENCY_STATS& stats)
+{
+    uint32_t threshold = stats.events - stats.events / 100;
+    uint32_t count = 0;
+
+    for (int i = 0; i < INPUT_LATENCY_BUCKETS - 1; i++) {
+        count += stats.histogram[i];
+        if (count >= threshold) {
+            return k_BucketBoundsMs[i];
+        }
+    }
+
+    return 0;
+}
+
+void InputLatencyTracker::stringifyAndResetWindow(char* output, int length)
+{
+    INPUT_LATENCY_STATS windowStats[InputClassMax];
+    uint32_t gamepadPackets[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t gamepadCoalesced[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t windowStartTime;
+    int offset = 0;
+    int ret;
+
+    SDL_AtomicLock(&m_Lock);
+    SDL_memcpy(windowStats, m_WindowStats, sizeof(windowStats));
+    SDL_memcpy(gamepadPackets, m_WindowGamepadPackets, sizeof(gamepadPackets));
+    SDL_memcpy(gamepadCoalesced, m_WindowGamepadCoalesced, sizeof(gamepadCoalesced));
+    windowStartTime = m_WindowStartTime;
+    SDL_zero(m_WindowStats);
+    SDL_zero(m_WindowGamepadPackets);
+    SDL_zero(m_WindowGamepadCoalesced);
+    m_WindowStartTime = SDL_GetTicks();
+    SDL_AtomicUnlock(&m_Lock);
+
+    float windowSecs = SDL_max(SDL_GetTicks() - windowStartTime, 1U) / 1000.0f;
+
+    // Start with an empty string
+    output[offset] = 0;
+
+    for (int i = 0; i < InputClassMax; i++) {
+        const INPUT_LATENCY_STATS& stats = windowStats[i];
+        if (stats.events == 0) {
+            continue;
+        }
+
+        uint32_t p99BoundMs = getP99BoundMs(stats);
+        if (p99BoundMs != 0) {
+            ret = snprintf(&output[offset],
+                           length - offset,
+                           "%s input delay average/max: %.1f/%.1f ms (99%% < %u ms)\n",
+                           getClassName((InputClass)i),
+                           (double)(stats.totalQueueTimeUs / 1000.0) / stats.events,
+                           stats.maxQueueTimeUs / 1000.0,
+                           p99BoundMs);
+        }
+        else {
+            ret = snprintf(&output[offset],
+                           length - offset,
+                           "%s input delay average/max: %.1f/%.1f ms\n",
+                           getClassName((InputClass)i),
+                           (double)(stats.totalQueueTimeUs / 1000.0) / stats.events,
+                           stats.maxQueueTimeUs / 1000.0);
+        }
+        if (ret < 0 || ret >= length - offset) {
+            // Drop the partial line and any that follow
+            output[offset] = 0;
+            return;
+        }
+
+        offset += ret;
+    }
+
+    for (int i = 0; i < INPUT_LATENCY_MAX_GAMEPADS; i++) {
+        if (gamepadPackets[i] == 0 && gamepadCoalesced[i] == 0) {
+            continue;
+        }
+
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "Gamepad %d packets: %.0f/s (%.0f/s coalesced)\n",
+                       i,
+                       gamepadPackets[i] / windowSecs,
+                       gamepadCoalesced[i] / windowSecs);
+        if (ret < 0 || ret >= length - offset) {
+            // Drop the partial line and any that follow
+            output[offset] = 0;
+            return;
+        }
+
+        offset += ret;
+    }
+}
+
+void InputLatencyTracker::logGlobalStats()
+{
+    INPUT_LATENCY_STATS globalStats[InputClassMax];
+    uint32_t gamepadPackets[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t gamepadCoalesced[INPUT_LATENCY_MAX_GAMEPADS];
+
+    SDL_AtomicLock(&m_Lock);
+    SDL_memcpy(globalStats, m_GlobalStats, sizeof(globalStats));
+    SDL_memcpy(gamepadPackets, m_GlobalGamepadPackets, sizeof(gamepadPackets));
+    SDL_memcpy(gamepadCoalesced, m_GlobalGamepadCoalesced, sizeof(gamepadCoalesced));
+    SDL_AtomicUnlock(&m_Lock);
+
+    for (int i = 0; i < InputClassMax; i++) {
+        const INPUT_LATENCY_STATS& stats = globalStats[i];
+        if (stats.events == 0) {
+            continue;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "%s input delay: %u events, average/max %.2f/%.2f ms, "
+                    "histogram <1/<2/<4/<8/<16/<32/32+ ms: %u/%u/%u/%u/%u/%u/%u",
+                    getClassName((InputClass)i),
+                    stats.events,
+                    (double)(stats.totalQueueTimeUs / 1000.0) / stats.events,
+                    stats.maxQueueTimeUs / 1000.0,
+                    stats.histogram[0], stats.histogram[1], stats.histogram[2],
+                    stats.histogram[3], stats.histogram[4], stats.histogram[5],
+                    stats.histogram[6]);
+    }
+
+    for (int i = 0; i < INPUT_LATENCY_MAX_GAMEPADS; i++) {
+        if (gamepadPackets[i] == 0 && gamepadCoalesced[i] == 0) {
+            continue;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Gamepad %d: %u state packets sent, %u updates coalesced",
+                    i,
+                    gamepadPackets[i],
+                    gamepadCoalesced[i]);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SDL_compat.h"
+
+#include <cstdint>
+
+// Upper bounds of the histogram buckets in milliseconds. The last
+// bucket holds everything at or above the final bound. The buckets
+// below 4 ms are only precise for sources with microsecond timestamps,
+// like evdev. Delays measured from SDL timestamps are whole milliseconds.
+#define INPUT_LATENCY_BUCKET_BOUNDS_MS { 1, 2, 4, 8, 16, 32 }
+#define INPUT_LATENCY_BUCKETS 7
+
+// Matches MAX_GAMEPADS in the input handler
+#define INPUT_LATENCY_MAX_GAMEPADS 16
+
+typedef struct _INPUT_LATENCY_STATS {
+    uint32_t events;
+    uint64_t totalQueueTimeUs;                 // high-res (1us)
+    uint32_t maxQueueTimeUs;                   // high-res (1us)
+    uint32_t histogram[INPUT_LATENCY_BUCKETS];
+} INPUT_LATENCY_STATS, *PINPUT_LATENCY_STATS;
+
+/**
+ * @brief The InputLatencyTracker class measures how long input waits on the client.
+ *
+ * Input is submitted as it's handed to moonlight-common-c for sending, with the time
+ * since the OS or SDL timestamp of the oldest input that the packet carries. Input
+ * held back for coalescing includes the time it was held. Statistics are kept
+ * separately for each class of input, both for the current overlay window and for
+ * the whole session. The tracker also counts the gamepad state packets sent for
+ * each controller, along with the updates that were coalesced instead of sent.
+ *
+ * Events may be submitted from any thread.
+ */
+class InputLatencyTracker
+{
+public:
+    enum InputClass {
+        Mouse,
+        Keyboard,
+        Gamepad,
+        Touch,
+        Motion,
+        InputClassMax
+    };
+
+    InputLatencyTracker();
+
+    void submit(InputClass inputClass, uint64_t queueTimeUs);
+
+    void countGamepadUpdate(int controllerNumber, bool sent);
+
+    /**
+     * @brief Appends the stats since the last call for the performance overlay.
+     */
+    void stringifyAndResetWindow(char* output, int length);
+
+    /**
+     * @brief Logs a summary of the whole session, including the histograms.
+     */
+    void logGlobalStats();
+
+private:
+    static const char* getClassName(InputClass inputClass);
+
+    INPUT_LATENCY_STATS m_WindowStats[InputClassMax];
+    INPUT_LATENCY_STATS m_GlobalStats[InputClassMax];
+    uint32_t m_WindowGamepadPackets[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t m_WindowGamepadCoalesced[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t m_GlobalGamepadPackets[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t m_GlobalGamepadCoalesced[INPUT_LATENCY_MAX_GAMEPADS];
+    uint32_t m_WindowStartTime;
+    SDL_SpinLock m_Lock;
+};
@@ -41,6 +41,7 @@
 #define SDL_CODE_GAMECONTROLLER_SET_MOTION_EVENT_STATE 103
 #define SDL_CODE_GAMECONTROLLER_SET_CONTROLLER_LED 104
 #define SDL_CODE_GAMECONTROLLER_SET_ADAPTIVE_TRIGGERS 105
+#define SDL_CODE_DEFERRED_FRAME_READY 108
 
 #include <openssl/rand.h>
 
@@ -574,14 +575,20 @@ Session::Session(NvComputer* computer, NvApp& app, StreamingPreferences *prefere
       m_InputHandler(nullptr),
       m_MouseEmulationRefCount(0),
       m_FlushingWindowEventsRef(0),
+      m_InputEventsSentBeforeRender(0),
       m_ShouldExit(false),
       m_AsyncConnectionSuccess(false),
       m_PortTestResults(0),
       m_OpusDecoder(nullptr),
       m_AudioRenderer(nullptr),
       m_AudioSampleCount(0),
-      m_DropAudioEndTime(0)
+      m_DropAudioEndTime(0),
+      m_AudioLossPending(false),
+      m_AudioStatsLock(0)
 {
+    SDL_zero(m_ActiveWndAudioStats);
+    SDL_zero(m_LastWndAudioStats);
+    SDL_zero(m_GlobalAudioStats);
 }
 
 Session::~Session()
@@ -1739,6 +1746,109 @@ void Session::flushWindowEvents()
     SDL_PushEvent(&flushEvent);
 }
 
+void Session::dispatchInputEvent(SDL_Event* event)
+{
+    InputLatencyTracker::InputClass inputClass;
+
+    switch (event->type) {
+    case SDL_KEYUP:
+    case SDL_KEYDOWN:
+        m_InputHandler->handleKeyEvent(&event->key);
+        inputClass = InputLatencyTracker::Keyboard;
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        m_InputHandler->handleMouseButtonEvent(&event->button);
+        inputClass = InputLatencyTracker::Mouse;
+        break;
+    case SDL_MOUSEMOTION:
+        m_InputHandler->handleMouseMotionEvent(&event->motion);
+        inputClass = InputLatencyTracker::Mouse;
+        break;
+    case SDL_MOUSEWHEEL:
+        m_InputHandler->handleMouseWheelEvent(&event->wheel);
+        inputClass = InputLatencyTracker::Mouse;
+        break;
+    case SDL_CONTROLLERAXISMOTION:
+        m_InputHandler->handleControllerAxisEvent(&event->caxis);
+        return;
+    case SDL_CONTROLLERBUTTONDOWN:
+    case SDL_CONTROLLERBUTTONUP:
+        m_InputHandler->handleControllerButtonEvent(&event->cbutton);
+        return;
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+    case SDL_CONTROLLERSENSORUPDATE:
+        m_InputHandler->handleControllerSensorEvent(&event->csensor);
+        return;
+    case SDL_CONTROLLERTOUCHPADDOWN:
+    case SDL_CONTROLLERTOUCHPADUP:
+    case SDL_CONTROLLERTOUCHPADMOTION:
+        m_InputHandler->handleControllerTouchpadEvent(&event->ctouchpad);
+        return;
+#endif
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+    case SDL_JOYBATTERYUPDATED:
+        m_InputHandler->handleJoystickBatteryEvent(&event->jbattery);
+        return;
+#endif
+    case SDL_CONTROLLERDEVICEADDED:
+    case SDL_CONTROLLERDEVICEREMOVED:
+        m_InputHandler->handleControllerDeviceEvent(&event->cdevice);
+        return;
+    case SDL_JOYDEVICEADDED:
+        m_InputHandler->handleJoystickArrivalEvent(&event->jdevice);
+        return;
+    case SDL_FINGERDOWN:
+    case SDL_FINGERMOTION:
+    case SDL_FINGERUP:
+        m_InputHandler->handleTouchFingerEvent(&event->tfinger);
+        return;
+    default:
+        // Not an input event
+        return;
+    }
+
+    // SDL timestamps events as they're pumped from the OS, so this is how
+    // long the event waited in the queue before we sent it to the host.
+    // Gamepad, motion, and touch input may be held for coalescing, so the
+    // input handler measures those when it actually sends them.
+    m_InputLatencyTracker.submit(inputClass, (uint64_t)(SDL_GetTicks() - event->common.timestamp) * 1000);
+}
+
+bool Session::deferFrameBehindPendingInput()
+{
+    SDL_PumpEvents();
+
+    // Keyboard, mouse, joystick, controller, and touch events are contiguous
+    // in the event type range, so this counts all pending input.
+    int pendingInputEvents = SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_KEYDOWN, SDL_FINGERMOTION);
+    if (pendingInputEvents <= 0) {
+        return false;
+    }
+
+    // Queue the render behind the pending input, so the main loop handles
+    // everything ahead of it in order. The deferred render isn't deferred
+    // again, so a steady stream of input can't starve the renderer.
+    SDL_Event event = {};
+    event.type = SDL_USEREVENT;
+    event.user.code = SDL_CODE_DEFERRED_FRAME_READY;
+    if (SDL_PushEvent(&event) != 1) {
+        return false;
+    }
+
+    m_InputEventsSentBeforeRender += pendingInputEvents;
+    return true;
+}
+
+void Session::logInputDispatchStats()
+{
+    m_InputLatencyTracker.logGlobalStats();
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Input events sent ahead of a frame render: %u",
+                m_InputEventsSentBeforeRender);
+}
+
 void Session::setShouldExit(bool quitHostApp)
 {
     // If the caller has explicitly asked us to quit the host app,
@@ -1995,6 +2105,9 @@ void Session::exec()
     // Toggle the stats overlay if requested by the user
     m_OverlayManager.setOverlayState(Overlay::OverlayDebug, m_Preferences->showPerformanceOverlay);
 
+    // Publish live stats for monitoring tools if requested
+    m_StatsExporter.start();
+
     // Switch to async logging mode when we enter the SDL loop
     StreamUtils::enterAsyncLoggingMode();
 
@@ -2042,6 +2155,13 @@ void Session::exec()
         case SDL_USEREVENT:
             switch (event.user.code) {
             case SDL_CODE_FRAME_READY:
+                // Rendering may block until the next vblank, so send any
+                // input that's waiting behind this frame to the host first.
+                if (m_VideoDecoder != nullptr && !deferFrameBehindPendingInput()) {
+                    m_VideoDecoder->renderFrameOnMainThread();
+                }
+                break;
+            case SDL_CODE_DEFERRED_FRAME_READY:
                 if (m_VideoDecoder != nullptr) {
                     m_VideoDecoder->renderFrameOnMainThread();
                 }
@@ -2074,6 +2194,12 @@ void Session::exec()
                 m_InputHandler->setAdaptiveTriggers((uint16_t)(uintptr_t)event.user.data1,
                                                     (DualSenseOutputReport *)event.user.data2);
                 break;
+            case SDL_CODE_GAMECONTROLLER_FLUSH_STATE:
+                m_InputHandler->flushPendingGamepadStates();
+                break;
+            case SDL_CODE_TOUCH_FLUSH_STATE:
+                m_InputHandler->flushPendingTouchMotion();
+                break;
             default:
                 SDL_assert(false);
             }
@@ -2286,54 +2412,12 @@ void Session::exec()
 
         case SDL_KEYUP:
         case SDL_KEYDOWN:
-            presence.runCallbacks();
-            m_InputHandler->handleKeyEvent(&event.key);
-            break;
         case SDL_MOUSEBUTTONDOWN:
         case SDL_MOUSEBUTTONUP:
-            presence.runCallbacks();
-            m_InputHandler->handleMouseButtonEvent(&event.button);
-            break;
-        case SDL_MOUSEMOTION:
-            m_InputHandler->handleMouseMotionEvent(&event.motion);
-            break;
-        case SDL_MOUSEWHEEL:
-            m_InputHandler->handleMouseWheelEvent(&event.wheel);
-            break;
-        case SDL_CONTROLLERAXISMOTION:
-            m_InputHandler->handleControllerAxisEvent(&event.caxis);
-            break;
         case SDL_CONTROLLERBUTTONDOWN:
         case SDL_CONTROLLERBUTTONUP:
             presence.runCallbacks();
-            m_InputHandler->handleControllerButtonEvent(&event.cbutton);
-            break;
-#if SDL_VERSION_ATLEAST(2, 0, 14)
-        case SDL_CONTROLLERSENSORUPDATE:
-            m_InputHandler->handleControllerSensorEvent(&event.csensor);
-            break;
-        case SDL_CONTROLLERTOUCHPADDOWN:
-        case SDL_CONTROLLERTOUCHPADUP:
-        case SDL_CONTROLLERTOUCHPADMOTION:
-            m_InputHandler->handleControllerTouchpadEvent(&event.ctouchpad);
-            break;
-#endif
-#if SDL_VERSION_ATLEAST(2, 24, 0)
-        case SDL_JOYBATTERYUPDATED:
-            m_InputHandler->handleJoystickBatteryEvent(&event.jbattery);
-            break;
-#endif
-        case SDL_CONTROLLERDEVICEADDED:
-        case SDL_CONTROLLERDEVICEREMOVED:
-            m_InputHandler->handleControllerDeviceEvent(&event.cdevice);
-            break;
-        case SDL_JOYDEVICEADDED:
-            m_InputHandler->handleJoystickArrivalEvent(&event.jdevice);
-            break;
-        case SDL_FINGERDOWN:
-        case SDL_FINGERMOTION:
-        case SDL_FINGERUP:
-            m_InputHandler->handleTouchFingerEvent(&event.tfinger);
+            dispatchInputEvent(&event);
             break;
         case SDL_DISPLAYEVENT:
             switch (event.display.event) {
@@ -2343,6 +2427,9 @@ void Session::exec()
                 break;
             }
             break;
+        default:
+            dispatchInputEvent(&event);
+            break;
         }
     }
 
@@ -2350,6 +2437,10 @@ DispatchDeferredCleanup:
     // Switch back to synchronous logging mode
     StreamUtils::exitAsyncLoggingMode();
 
+    logInputDispatchStats();
+
+    m_StatsExporter.stop();
+
     // Uncapture the mouse and hide the window immediately,
     // so we can return to the Qt GUI ASAP.
     m_InputHandler->setCaptureActive(false);
@@ -10,6 +10,9 @@
 #include "video/decoder.h"
 #include "audio/renderers/renderer.h"
 #include "video/overlaymanager.h"
+#include "avsync.h"
+#include "inputlatency.h"
+#include "statsexporter.h"
 
 class SupportedVideoFormatList : public QList<int>
 {
@@ -121,8 +124,26 @@ public:
         return m_OverlayManager;
     }
 
+    AVSyncTracker& getAVSyncTracker()
+    {
+        return m_AVSyncTracker;
+    }
+
+    InputLatencyTracker& getInputLatencyTracker()
+    {
+        return m_InputLatencyTracker;
+    }
+
+    StatsExporter& getStatsExporter()
+    {
+        return m_StatsExporter;
+    }
+
     void flushWindowEvents();
 
+    // Appends the recent audio statistics for the performance overlay
+    void stringifyLastAudioStats(char* output, int length);
+
     void setShouldExit(bool quitHostApp = false);
 
 signals:
@@ -158,10 +179,18 @@ private:
 
     bool initializeAudioRenderer();
 
+    bool decodeAndSubmitAudio(char* sampleData, int sampleLength, bool decodeFec);
+
     bool testAudio(int audioConfiguration);
 
     int getAudioRendererCapabilities(int audioConfiguration);
 
+    void addAudioStats(AUDIO_STATS& src, AUDIO_STATS& dst);
+
+    void stringifyAudioStats(AUDIO_STATS& stats, char* output, int length);
+
+    void logAudioStats(AUDIO_STATS& stats, const char* title);
+
     void getWindowDimensions(int& x, int& y,
                              int& width, int& height);
 
@@ -171,6 +200,12 @@ private:
 
     void updateOptimalWindowDisplayMode();
 
+    void dispatchInputEvent(SDL_Event* event);
+
+    bool deferFrameBehindPendingInput();
+
+    void logInputDispatchStats();
+
     enum class DecoderAvailability {
         None,
         Software,
@@ -261,6 +296,7 @@ private:
     SdlInputHandler* m_InputHandler;
     int m_MouseEmulationRefCount;
     int m_FlushingWindowEventsRef;
+    uint32_t m_InputEventsSentBeforeRender;
     QStringList m_LaunchWarnings;
     bool m_ShouldExit;
 
@@ -278,8 +314,16 @@ private:
     OPUS_MULTISTREAM_CONFIGURATION m_OriginalAudioConfig;
     int m_AudioSampleCount;
     Uint32 m_DropAudioEndTime;
+    bool m_AudioLossPending;
+    AUDIO_STATS m_ActiveWndAudioStats;
+    AUDIO_STATS m_LastWndAudioStats;
+    AUDIO_STATS m_GlobalAudioStats;
+    SDL_SpinLock m_AudioStatsLock;
 
     Overlay::OverlayManager m_OverlayManager;
+    AVSyncTracker m_AVSyncTracker;
+    InputLatencyTracker m_InputLatencyTracker;
+    StatsExporter m_StatsExporter;
 
     static CONNECTION_LISTENER_CALLBACKS k_ConnCallbacks;
     static Session* s_ActiveSession;
@@ -0,0 +1,372 @@
+#include "statsexporter.h"
+#include "utils.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QVector>
+
+#ifndef Q_OS_WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+struct Metric {
+    const char* name;
+    const char* help;
+    double value;
+};
+
+}
+
+static void collectMetrics(bool hasVideo, const VIDEO_STATS& video, double averageMbps, double peakMbps,
+                           bool hasAudio, const AUDIO_STATS& audio, QVector<Metric>& metrics)
+{
+    if (hasVideo) {
+        metrics.append({ "video_total_fps", "Frame rate sent by the host", video.totalFps });
+        metrics.append({ "video_received_fps", "Frame rate received from the network", video.receivedFps });
+        metrics.append({ "video_decoded_fps", "Frame rate decoded", video.decodedFps });
+        metrics.append({ "video_rendered_fps", "Frame rate rendered", video.renderedFps });
+        metrics.append({ "video_network_dropped_frames", "Frames lost by the network in the last window", (double)video.networkDroppedFrames });
+        metrics.append({ "video_pacer_dropped_frames", "Frames dropped due to network jitter in the last window", (double)video.pacerDroppedFrames });
+        metrics.append({ "video_bitrate_average_mbps", "Recent average video bitrate", averageMbps });
+        metrics.append({ "video_bitrate_peak_mbps", "Peak video bitrate over the bandwidth tracking window", peakMbps });
+
+        if (video.decodedFrames != 0) {
+            metrics.append({ "video_decode_time_ms", "Average decoding time", (double)(video.totalDecodeTimeUs / 1000.0) / video.decodedFrames });
+        }
+        if (video.renderedFrames != 0) {
+            metrics.append({ "video_queue_delay_ms", "Average frame queue delay", (double)(video.totalPacerTimeUs / 1000.0) / video.renderedFrames });
+            metrics.append({ "video_render_time_ms", "Average rendering time", (double)(video.totalRenderTimeUs / 1000.0) / video.renderedFrames });
+        }
+        if (video.framesWithHostProcessingLatency != 0) {
+            metrics.append({ "video_host_latency_ms", "Average host processing latency", (double)video.totalHostProcessingLatency / 10 / video.framesWithHostProcessingLatency });
+            metrics.append({ "video_host_latency_max_ms", "Maximum host processing latency", (double)video.maxHostProcessingLatency / 10 });
+        }
+        if (video.lastRtt != 0) {
+            metrics.append({ "rtt_ms", "Network round-trip time", (double)video.lastRtt });
+            metrics.append({ "rtt_variance_ms", "Network round-trip time variance", (double)video.lastRttVariance });
+        }
+        if (video.hasAvSyncSkew) {
+            metrics.append({ "av_sync_skew_ms", "Audio latency minus video latency", video.avSyncSkewUs / 1000.0 });
+        }
+    }
+
+    if (hasAudio) {
+        metrics.append({ "audio_received_packets", "Audio packets received in the last window", (double)audio.receivedPackets });
+        metrics.append({ "audio_dropped_packets", "Audio packets dropped in the last window", (double)(audio.droppedPackets + audio.dropWindowPackets) });
+        metrics.append({ "audio_concealed_packets", "Audio packets concealed in the last window", (double)audio.concealedPackets });
+        metrics.append({ "audio_underruns", "Audio renderer underruns in the last window", (double)audio.underruns });
+        metrics.append({ "audio_reinitializations", "Audio renderer reinitializations in the last window", (double)audio.reinitializations });
+
+        if (audio.decodedPackets != 0) {
+            metrics.append({ "audio_decode_time_ms", "Average audio decoding time", (double)(audio.totalDecodeTimeUs / 1000.0) / audio.decodedPackets });
+        }
+        if (audio.queuedTimeSamples != 0) {
+            metrics.append({ "audio_queue_delay_ms", "Average audio queue delay", (double)(audio.totalQueuedTimeUs / 1000.0) / audio.queuedTimeSamples });
+            metrics.append({ "audio_queue_delay_max_ms", "Maximum audio queue delay", audio.maxQueuedTimeUs / 1000.0 });
+        }
+    }
+}
+
+static QByteArray escapeLabelValue(const char* value)
+{
+    QByteArray escaped(value);
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    escaped.replace('\n', "\\n");
+    return escaped;
+}
+
+StatsExporter::StatsExporter()
+    : m_Thread(nullptr),
+      m_StopSemaphore(nullptr),
+      m_Format(JsonLines),
+      m_IntervalMs(STATS_EXPORT_DEFAULT_INTERVAL_MS),
+      m_Lock(0),
+      m_LastExportedSequence(0),
+      m_SocketFd(-1),
+      m_LoggedWriteFailure(false)
+{
+    SDL_AtomicSet(&m_Enabled, 0);
+    SDL_zero(m_Snapshot);
+}
+
+StatsExporter::~StatsExporter()
+{
+    stop();
+}
+
+void StatsExporter::start()
+{
+    SDL_assert(m_Thread == nullptr);
+
+    QByteArray path = qgetenv("STATS_EXPORT_PATH");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    m_Path = QString::fromLocal8Bit(path);
+    m_Format = qgetenv("STATS_EXPORT_FORMAT").toLower() == "prometheus" ? Prometheus : JsonLines;
+
+    if (!Utils::getEnvironmentVariableOverride("STATS_EXPORT_INTERVAL_MS", &m_IntervalMs)) {
+        m_IntervalMs = STATS_EXPORT_DEFAULT_INTERVAL_MS;
+    }
+    m_IntervalMs = SDL_max(m_IntervalMs, STATS_EXPORT_MIN_INTERVAL_MS);
+
+    if (m_Path.startsWith(STATS_EXPORT_SOCKET_PREFIX)) {
+#ifdef Q_OS_WIN32
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Stats export to UNIX sockets is not supported on this platform");
+        return;
+#else
+        QByteArray socketPath = m_Path.mid((int)strlen(STATS_EXPORT_SOCKET_PREFIX)).toLocal8Bit();
+        if (socketPath.isEmpty() || socketPath.size() >= (int)sizeof(sockaddr_un::sun_path)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                        "Invalid stats export socket path: %s",
+                        socketPath.constData());
+            return;
+        }
+#endif
+    }
+
+    m_StopSemaphore = SDL_CreateSemaphore(0);
+    if (m_StopSemaphore == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "SDL_CreateSemaphore() failed: %s",
+                     SDL_GetError());
+        return;
+    }
+
+    m_LastExportedSequence = 0;
+    m_LoggedWriteFailure = false;
+
+    // The export thread reads the configuration above, so it must be set first
+    m_Thread = SDL_CreateThread(StatsExporter::exportThreadProc, "StatsExport", this);
+    if (m_Thread == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to create stats export thread: %s",
+                     SDL_GetError());
+        SDL_DestroySemaphore(m_StopSemaphore);
+        m_StopSemaphore = nullptr;
+        return;
+    }
+
+    SDL_AtomicSet(&m_Enabled, 1);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Exporting stream statistics to %s every %d ms (%s)",
+                qPrintable(m_Path),
+                m_IntervalMs,
+                m_Format == Prometheus ? "Prometheus" : "JSON lines");
+}
+
+void StatsExporter::stop()
+{
+    SDL_AtomicSet(&m_Enabled, 0);
+
+    if (m_Thread != nullptr) {
+        SDL_SemPost(m_StopSemaphore);
+        SDL_WaitThread(m_Thread, nullptr);
+        m_Thread = nullptr;
+    }
+
+    if (m_StopSemaphore != nullptr) {
+        SDL_DestroySemaphore(m_StopSemaphore);
+        m_StopSemaphore = nullptr;
+    }
+
+#ifndef Q_OS_WIN32
+    if (m_SocketFd >= 0) {
+        close(m_SocketFd);
+        m_SocketFd = -1;
+    }
+#endif
+}
+
+bool StatsExporter::isEnabled()
+{
+    return SDL_AtomicGet(&m_Enabled) != 0;
+}
+
+void StatsExporter::setVideoPipeline(const char* decoderName, const char* rendererName, const char* backendRendererName)
+{
+    // The pipeline is recorded even while disabled, since the decoder
+    // may be created before the export starts.
+    SDL_AtomicLock(&m_Lock);
+    SDL_strlcpy(m_Snapshot.decoderName, decoderName ? decoderName : "", sizeof(m_Snapshot.decoderName));
+    SDL_strlcpy(m_Snapshot.rendererName, rendererName ? rendererName : "", sizeof(m_Snapshot.rendererName));
+    SDL_strlcpy(m_Snapshot.backendRendererName, backendRendererName ? backendRendererName : "", sizeof(m_Snapshot.backendRendererName));
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+void StatsExporter::submitVideoStats(const VIDEO_STATS& stats, double averageMbps, double peakMbps)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    SDL_AtomicLock(&m_Lock);
+    SDL_memcpy(&m_Snapshot.video, &stats, sizeof(stats));
+    m_Snapshot.averageMbps = averageMbps;
+    m_Snapshot.peakMbps = peakMbps;
+    m_Snapshot.hasVideo = true;
+    m_Snapshot.sequence++;
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+void StatsExporter::submitAudioStats(const AUDIO_STATS& stats)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    SDL_AtomicLock(&m_Lock);
+    SDL_memcpy(&m_Snapshot.audio, &stats, sizeof(stats));
+    m_Snapshot.hasAudio = true;
+    m_Snapshot.sequence++;
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+int StatsExporter::exportThreadProc(void* context)
+{
+    ((StatsExporter*)context)->exportThread();
+    return 0;
+}
+
+void StatsExporter::exportThread()
+{
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+    // The semaphore is only posted when we're stopping
+    while (SDL_SemWaitTimeout(m_StopSemaphore, m_IntervalMs) == SDL_MUTEX_TIMEDOUT) {
+        Snapshot snapshot;
+
+        SDL_AtomicLock(&m_Lock);
+        SDL_memcpy(&snapshot, &m_Snapshot, sizeof(snapshot));
+        SDL_AtomicUnlock(&m_Lock);
+
+        // Don't repeat a snapshot if no stats window completed since the last one
+        if (snapshot.sequence == m_LastExportedSequence) {
+            continue;
+        }
+        m_LastExportedSequence = snapshot.sequence;
+
+        QByteArray output;
+        serialize(snapshot, output);
+
+        if (!writeOutput(output)) {
+            // Only log the first failure, since the collector may come and go
+            if (!m_LoggedWriteFailure) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                            "Failed to export stream statistics to %s",
+                            qPrintable(m_Path));
+                m_LoggedWriteFailure = true;
+            }
+        }
+        else {
+            m_LoggedWriteFailure = false;
+        }
+    }
+}
+
+void StatsExporter::serialize(const Snapshot& snapshot, QByteArray& output)
+{
+    QVector<Metric> metrics;
+    collectMetrics(snapshot.hasVideo, snapshot.video, snapshot.averageMbps, snapshot.peakMbps,
+                   snapshot.hasAudio, snapshot.audio, metrics);
+
+    if (m_Format == Prometheus) {
+        output.append("# HELP moonlight_video_pipeline_info Video decoder and renderer in use\n"
+                      "# TYPE moonlight_video_pipeline_info gauge\n");
+        output.append("moonlight_video_pipeline_info{decoder=\"");
+        output.append(escapeLabelValue(snapshot.decoderName));
+        output.append("\",renderer=\"");
+        output.append(escapeLabelValue(snapshot.rendererName));
+        output.append("\",backend_renderer=\"");
+        output.append(escapeLabelValue(snapshot.backendRendererName));
+        output.append("\"} 1\n");
+
+        for (const Metric& metric : metrics) {
+            output.append("# HELP moonlight_").append(metric.name).append(' ').append(metric.help).append('\n');
+            output.append("# TYPE moonlight_").append(metric.name).append(" gauge\n");
+            output.append("moonlight_").append(metric.name).append(' ').append(QByteArray::number(metric.value, 'g', 10)).append('\n');
+        }
+    }
+    else {
+        QJsonObject object;
+
+        object.insert("timestamp_ms", (double)QDateTime::currentMSecsSinceEpoch());
+        object.insert("decoder", snapshot.decoderName);
+        object.insert("renderer", snapshot.rendererName);
+        object.insert("backend_renderer", snapshot.backendRendererName);
+        for (const Metric& metric : metrics) {
+            object.insert(metric.name, metric.value);
+        }
+
+        output = QJsonDocument(object).toJson(QJsonDocument::Compact);
+        output.append('\n');
+    }
+}
+
+bool StatsExporter::writeOutput(const QByteArray& output)
+{
+    if (m_Path.startsWith(STATS_EXPORT_SOCKET_PREFIX)) {
+        return sendToSocket(output);
+    }
+    else if (m_Format == Prometheus) {
+        // Replace the whole file atomically, so readers never see a partial update
+        QSaveFile file(m_Path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+
+        file.write(output);
+        return file.commit();
+    }
+    else {
+        // Reopen the file each time, so it can be rotated underneath us
+        QFile file(m_Path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            return false;
+        }
+
+        return file.write(output) == output.size();
+    }
+}
+
+bool StatsExporter::sendToSocket(const QByteArray& output)
+{
+#ifdef Q_OS_WIN32
+    Q_UNUSED(output);
+    return false;
+#else
+    if (m_SocketFd < 0) {
+        m_SocketFd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (m_SocketFd < 0) {
+            return false;
+        }
+    }
+
+    QByteArray socketPath = m_Path.mid((int)strlen(STATS_EXPORT_SOCKET_PREFIX)).toLocal8Bit();
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    SDL_strlcpy(addr.sun_path, socketPath.constData(), sizeof(addr.sun_path));
+
+    // Never block the export thread on a slow collector. The snapshot
+    // is simply dropped if it can't be delivered right now.
+    ssize_t ret;
+    do {
+        ret = sendto(m_SocketFd, output.constData(), output.size(), MSG_DONTWAIT,
+                     (struct sockaddr*)&addr, sizeof(addr));
+    } while (ret < 0 && errno == EINTR);
+
+    return ret == output.size();
+#endif
+}
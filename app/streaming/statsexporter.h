@@ -0,0 +1,105 @@
+#pragma once
+
+#include "SDL_compat.h"
+#include "video/decoder.h"
+#include "audio/renderers/renderer.h"
+
+#include <QByteArray>
+#include <QString>
+
+// Default time between exported snapshots. The stats windows
+// themselves are only completed roughly once a second.
+#define STATS_EXPORT_DEFAULT_INTERVAL_MS 1000
+#define STATS_EXPORT_MIN_INTERVAL_MS 100
+
+// Paths with this prefix name a UNIX datagram socket instead of a file
+#define STATS_EXPORT_SOCKET_PREFIX "unix:"
+
+/**
+ * @brief The StatsExporter class publishes live stream statistics for monitoring tools.
+ *
+ * When enabled (STATS_EXPORT_PATH), the decoder and audio threads submit each completed
+ * stats window, which is copied into a snapshot under a spinlock. A dedicated thread
+ * serializes the latest snapshot every STATS_EXPORT_INTERVAL_MS and writes it out, so
+ * formatting and I/O never happen on the streaming threads.
+ *
+ * STATS_EXPORT_FORMAT selects the output format:
+ *  - "json" (default) writes one JSON object per line, appended to the file.
+ *  - "prometheus" writes the Prometheus text format. Files are replaced atomically
+ *    on each update, as expected by the node_exporter textfile collector.
+ *
+ * A path of the form "unix:/path/to/socket" sends each snapshot as one datagram to a
+ * UNIX socket bound by the collector. Snapshots are dropped while nothing is listening.
+ */
+class StatsExporter
+{
+public:
+    StatsExporter();
+    ~StatsExporter();
+
+    /**
+     * @brief Starts exporting if STATS_EXPORT_PATH is set. Must be called on the main thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the export thread. Must be called on the main thread.
+     */
+    void stop();
+
+    bool isEnabled();
+
+    void setVideoPipeline(const char* decoderName, const char* rendererName, const char* backendRendererName);
+
+    /**
+     * @brief Publishes a completed video stats window. The FPS fields must already be computed.
+     */
+    void submitVideoStats(const VIDEO_STATS& stats, double averageMbps, double peakMbps);
+
+    void submitAudioStats(const AUDIO_STATS& stats);
+
+private:
+    enum Format {
+        JsonLines,
+        Prometheus
+    };
+
+    struct Snapshot {
+        uint32_t sequence;
+        bool hasVideo;
+        VIDEO_STATS video;
+        double averageMbps;
+        double peakMbps;
+        bool hasAudio;
+        AUDIO_STATS audio;
+        char decoderName[32];
+        char rendererName[32];
+        char backendRendererName[32];
+    };
+
+    static int exportThreadProc(void* context);
+
+    void exportThread();
+
+    void serialize(const Snapshot& snapshot, QByteArray& output);
+
+    bool writeOutput(const QByteArray& output);
+
+    bool sendToSocket(const QByteArray& output);
+
+    SDL_Thread* m_Thread;
+    SDL_sem* m_StopSemaphore;
+    SDL_atomic_t m_Enabled;
+    QString m_Path;
+    Format m_Format;
+    int m_IntervalMs;
+
+    // Protected by m_Lock
+    Snapshot m_Snapshot;
+    SDL_SpinLock m_Lock;
+
+    // Only accessed on the export thread
+    uint32_t m_LastExportedSequence;
+    int m_SocketFd;
+    bool m_LoggedWriteFailure;
+};
@@ -25,6 +25,9 @@ typedef struct _VIDEO_STATS {
     uint64_t totalRenderTimeUs;                // high-res (1us)
     uint32_t lastRtt;                          // low-res from enet (1ms)
     uint32_t lastRttVariance;                  // low-res from enet (1ms)
+    bool hasAvSyncSkew;                        // avSyncSkewUs is valid
+    int32_t avSyncSkewUs;                      // high-res (1us), audio latency minus video latency
+    uint32_t avSyncVideoDelayUs;               // high-res (1us), video delay for A/V sync correction
     double totalFps;                           // high-res
     double receivedFps;                        // high-res
     double decodedFps;                         // high-res
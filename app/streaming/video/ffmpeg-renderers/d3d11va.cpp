@@ -1157,6 +1157,11 @@ bool D3D11VARenderer::createOverlayVertexBuffer(Overlay::OverlayType type, int w
         renderRect.x = 0;
         renderRect.y = m_DisplayHeight - height;
     }
+    else if (type == Overlay::OverlayFrameGraph) {
+        // Top right
+        renderRect.x = m_DisplayWidth - width;
+        renderRect.y = m_DisplayHeight - height;
+    }
 
     renderRect.w = width;
     renderRect.h = height;
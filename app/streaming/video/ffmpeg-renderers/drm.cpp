@@ -75,6 +75,10 @@ extern "C" {
 
 #include <map>
 
+// The overlay composition plane is padded to a multiple of this many pixels,
+// so small changes in overlay size don't require a new buffer each time.
+#define OVERLAY_COMPOSITION_ALIGNMENT 64
+
 // This map is used to lookup characteristics of a given DRM format
 //
 // All DRM formats that we want to try when selecting a plane must
@@ -148,7 +152,10 @@ DrmRenderer::DrmRenderer(AVHWDeviceType hwDeviceType, IFFmpegRenderer *backendRe
       m_MustCloseDrmFd(false),
       m_SupportsDirectRendering(false),
       m_VideoFormat(0),
+      m_OverlayCompositionMode(false),
       m_OverlayCompositionSurface(nullptr),
+      m_OverlayCompositionRect{},
+      m_OverlaySources{},
       m_OverlayRects{},
       m_Version(nullptr),
       m_HdrOutputMetadataBlobId(0),
@@ -169,6 +176,11 @@ DrmRenderer::~DrmRenderer()
         munmap(m_OverlayCompositionSurface->pixels, (uintptr_t)m_OverlayCompositionSurface->userdata);
         SDL_FreeSurface(m_OverlayCompositionSurface);
     }
+    for (int i = 0; i < Overlay::OverlayMax; i++) {
+        if (m_OverlaySources[i]) {
+            SDL_FreeSurface(m_OverlaySources[i]);
+        }
+    }
 
     if (m_DrmStateModified) {
         // Ensure we're out of HDR mode
@@ -1323,9 +1335,9 @@ bool DrmRenderer::uploadSurfaceToFb(SDL_Surface *surface, uint32_t* handle, uint
         goto Fail;
     }
 
-    // Convert and copy the surface pixels into the dumb buffer with premultiplied alpha
-    SDL_PremultiplyAlpha(surface->w, surface->h, surface->format->format, surface->pixels, surface->pitch,
-                         SDL_PIXELFORMAT_ARGB8888, mapping, createBuf.pitch);
+    // Convert and copy the surface pixels into the dumb buffer. Overlay surfaces are already premultiplied.
+    SDL_ConvertPixels(surface->w, surface->h, surface->format->format, surface->pixels, surface->pitch,
+                      SDL_PIXELFORMAT_ARGB8888, mapping, createBuf.pitch);
 
     munmap(mapping, createBuf.size);
 
@@ -1345,7 +1357,7 @@ Fail:
 
 void DrmRenderer::enterOverlayCompositionMode()
 {
-    if (m_OverlayCompositionSurface) {
+    if (m_OverlayCompositionMode) {
         return;
     }
 
@@ -1356,54 +1368,99 @@ void DrmRenderer::enterOverlayCompositionMode()
         }
     }
 
+    // Nothing is displayed anymore, so each overlay will
+    // be composited again on its next update.
+    memset(m_OverlayRects, 0, sizeof(m_OverlayRects));
+
+    // The composition surface is allocated once we have an overlay to draw
+    m_OverlayCompositionMode = true;
+}
+
+void DrmRenderer::resizeOverlayCompositionSurface(const SDL_Rect& rect)
+{
     struct drm_mode_create_dumb createBuf = {};
     uint32_t fbId;
     void* mapping = nullptr;
+    SDL_Surface* newSurface = nullptr;
 
-    createBuf.width = m_OutputRect.w;
-    createBuf.height = m_OutputRect.h;
-    createBuf.bpp = 32;
-    int err = drmIoctl(m_DrmFd, DRM_IOCTL_MODE_CREATE_DUMB, &createBuf);
-    if (err < 0) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                     "DRM_IOCTL_MODE_CREATE_DUMB failed: %d",
-                     errno);
-        return;
-    }
+    if (!SDL_RectEmpty(&rect)) {
+        createBuf.width = rect.w;
+        createBuf.height = rect.h;
+        createBuf.bpp = 32;
+        int err = drmIoctl(m_DrmFd, DRM_IOCTL_MODE_CREATE_DUMB, &createBuf);
+        if (err < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "DRM_IOCTL_MODE_CREATE_DUMB failed: %d",
+                         errno);
+            goto Fail;
+        }
 
-    if (!mapDumbBuffer(createBuf.handle, createBuf.size, &mapping)) {
-        goto Fail;
+        if (!mapDumbBuffer(createBuf.handle, createBuf.size, &mapping)) {
+            goto Fail;
+        }
+
+        if (!createFbForDumbBuffer(&createBuf, &fbId)) {
+            goto Fail;
+        }
+
+        // Create an SDL surface that wraps our dumb buffer mapping
+        newSurface = SDL_CreateRGBSurfaceWithFormatFrom(mapping,
+                                                        rect.w,
+                                                        rect.h,
+                                                        32,
+                                                        createBuf.pitch,
+                                                        SDL_PIXELFORMAT_ARGB8888);
+        if (newSurface == nullptr) {
+            drmModeRmFB(m_DrmFd, fbId);
+            goto Fail;
+        }
+        newSurface->userdata = (void*)createBuf.size;
+
+        // Disable blending to avoid costly reads of possibly WC/UC data
+        SDL_SetSurfaceBlendMode(newSurface, SDL_BLENDMODE_NONE);
+
+        // Configure the overlay plane to cover only the area of the overlays
+        m_PropSetter.configurePlane(m_OverlayPlanes[0], m_Crtc.objectId(),
+                                    rect.x, rect.y, rect.w, rect.h,
+                                    0, 0,
+                                    rect.w << 16,
+                                    rect.h << 16);
+
+        // Flip the surface onto the overlay
+        //
+        // NB: This will take ownership of both the FB and the dumb buffer. They
+        // are freed when a later resize flips another buffer onto this plane,
+        // or when the plane is disabled.
+        m_PropSetter.flipPlane(m_OverlayPlanes[0], fbId, createBuf.handle);
+    }
+    else {
+        m_PropSetter.disablePlane(m_OverlayPlanes[0]);
     }
 
-    if (!createFbForDumbBuffer(&createBuf, &fbId)) {
-        goto Fail;
+    // Unmap the old buffer. The plane still owns it until the flip completes.
+    if (m_OverlayCompositionSurface) {
+        munmap(m_OverlayCompositionSurface->pixels, (uintptr_t)m_OverlayCompositionSurface->userdata);
+        SDL_FreeSurface(m_OverlayCompositionSurface);
     }
 
-    // Configure the overlay plane to cover the entire display
-    m_PropSetter.configurePlane(m_OverlayPlanes[0], m_Crtc.objectId(),
-                                0, 0, m_OutputRect.w, m_OutputRect.h,
-                                0, 0,
-                                m_OutputRect.w << 16,
-                                m_OutputRect.h << 16);
+    m_OverlayCompositionSurface = newSurface;
+    m_OverlayCompositionRect = rect;
 
-    // Flip the surface onto the overlay
-    //
-    // NB: This will take ownership of both the FB and the dumb buffer,
-    // but it won't free them until we stop streaming since we don't
-    // flip this plane anymore after this.
-    m_PropSetter.flipPlane(m_OverlayPlanes[0], fbId, createBuf.handle);
-
-    // Create an SDL surface that wraps our dumb buffer mapping
-    m_OverlayCompositionSurface = SDL_CreateRGBSurfaceWithFormatFrom(mapping,
-                                                                     m_OutputRect.w,
-                                                                     m_OutputRect.h,
-                                                                     32,
-                                                                     createBuf.pitch,
-                                                                     SDL_PIXELFORMAT_ARGB8888);
-    m_OverlayCompositionSurface->userdata = (void*)createBuf.size;
-
-    // Disable blending to avoid costly reads of possibly WC/UC data
-    SDL_SetSurfaceBlendMode(m_OverlayCompositionSurface, SDL_BLENDMODE_NONE);
+    if (newSurface) {
+        // Dumb buffers start zeroed, so we only need to draw the active overlays
+        for (int i = 0; i < Overlay::OverlayMax; i++) {
+            if (m_OverlaySources[i] && !SDL_RectEmpty(&m_OverlayRects[i])) {
+                SDL_Rect dstRect = m_OverlayRects[i];
+                dstRect.x -= rect.x;
+                dstRect.y -= rect.y;
+                SDL_BlitSurface(m_OverlaySources[i], nullptr, newSurface, &dstRect);
+            }
+        }
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Overlay composition plane resized to %dx%d at (%d, %d)",
+                rect.w, rect.h, rect.x, rect.y);
     return;
 
 Fail:
@@ -1411,33 +1468,115 @@ Fail:
         munmap(mapping, createBuf.size);
     }
 
-    struct drm_mode_destroy_dumb destroyBuf = {};
-    destroyBuf.handle = createBuf.handle;
-    drmIoctl(m_DrmFd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroyBuf);
+    if (createBuf.handle) {
+        struct drm_mode_destroy_dumb destroyBuf = {};
+        destroyBuf.handle = createBuf.handle;
+        drmIoctl(m_DrmFd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroyBuf);
+    }
+
+    // Don't leave stale overlays on screen. We'll try again on the next update.
+    m_PropSetter.disablePlane(m_OverlayPlanes[0]);
+    if (m_OverlayCompositionSurface) {
+        munmap(m_OverlayCompositionSurface->pixels, (uintptr_t)m_OverlayCompositionSurface->userdata);
+        SDL_FreeSurface(m_OverlayCompositionSurface);
+        m_OverlayCompositionSurface = nullptr;
+    }
+    m_OverlayCompositionRect = {};
 }
 
-void DrmRenderer::blitOverlayToCompositionSurface(Overlay::OverlayType type, SDL_Surface* newSurface, SDL_Rect* overlayRect)
+// Draws m_OverlaySources[type] at overlayRect, or removes the overlay if overlayRect is null.
+// updateRect is the part of the overlay that changed since it was last drawn.
+void DrmRenderer::blitOverlayToCompositionSurface(Overlay::OverlayType type, const SDL_Rect* overlayRect, const SDL_Rect* updateRect)
 {
-    SDL_assert(m_OverlayCompositionSurface);
+    SDL_assert(m_OverlayCompositionMode);
+    SDL_assert(!overlayRect == !updateRect);
 
-    if (newSurface && overlayRect) {
-        // Disable blending of the source surface when blitting
-        SDL_SetSurfaceBlendMode(newSurface, SDL_BLENDMODE_NONE);
+    SDL_Rect oldOverlayRect = m_OverlayRects[type];
+    SDL_Surface* newSurface = overlayRect ? m_OverlaySources[type] : nullptr;
 
-        // Premultiply alpha in place, so we can blit directly into the composition surface
-        // without having to read anything (which may be very costly due to UC/WC memory)
-        SDL_PremultiplyAlpha(newSurface->w, newSurface->h,
-                             newSurface->format->format, newSurface->pixels, newSurface->pitch,
-                             newSurface->format->format, newSurface->pixels, newSurface->pitch);
+    if (newSurface) {
+        m_OverlayRects[type] = *overlayRect;
+    }
+    else {
+        memset(&m_OverlayRects[type], 0, sizeof(m_OverlayRects[type]));
+    }
+
+    // Find the area covered by all active overlays
+    SDL_Rect activeRect = {};
+    for (int i = 0; i < Overlay::OverlayMax; i++) {
+        if (!SDL_RectEmpty(&m_OverlayRects[i])) {
+            SDL_Rect unionRect;
+            SDL_UnionRect(&activeRect, &m_OverlayRects[i], &unionRect);
+            activeRect = unionRect;
+        }
+    }
+
+    // Reallocate the composition surface if the overlays no longer fit in it,
+    // or if they only use a small part of it. Otherwise, update it in place.
+    bool needsResize;
+    if (SDL_RectEmpty(&activeRect)) {
+        needsResize = !SDL_RectEmpty(&m_OverlayCompositionRect);
+    }
+    else if (!m_OverlayCompositionSurface) {
+        needsResize = true;
+    }
+    else {
+        // Compare against the padded size we'd allocate for the active area, otherwise
+        // small overlays would always look undersized and reallocate on every update.
+        int paddedW = SDL_min(FFALIGN(activeRect.w, OVERLAY_COMPOSITION_ALIGNMENT), m_OutputRect.w);
+        int paddedH = SDL_min(FFALIGN(activeRect.h, OVERLAY_COMPOSITION_ALIGNMENT), m_OutputRect.h);
+
+        SDL_Rect intersection;
+        needsResize = !SDL_IntersectRect(&activeRect, &m_OverlayCompositionRect, &intersection) ||
+                      !SDL_RectEquals(&intersection, &activeRect) ||
+                      paddedW * paddedH * 4 < m_OverlayCompositionRect.w * m_OverlayCompositionRect.h;
+    }
+
+    if (needsResize) {
+        if (!SDL_RectEmpty(&activeRect)) {
+            // Pad the plane, keeping it on screen
+            activeRect.w = SDL_min(FFALIGN(activeRect.w, OVERLAY_COMPOSITION_ALIGNMENT), m_OutputRect.w);
+            activeRect.h = SDL_min(FFALIGN(activeRect.h, OVERLAY_COMPOSITION_ALIGNMENT), m_OutputRect.h);
+            activeRect.x = SDL_min(activeRect.x, m_OutputRect.w - activeRect.w);
+            activeRect.y = SDL_min(activeRect.y, m_OutputRect.h - activeRect.h);
+        }
+        else {
+            memset(&activeRect, 0, sizeof(activeRect));
+        }
+
+        // This draws all active overlays into the new surface
+        resizeOverlayCompositionSurface(activeRect);
+        return;
+    }
+    else if (!m_OverlayCompositionSurface) {
+        return;
+    }
+
+    // The composition surface and plane damage use FB-relative coordinates
+    oldOverlayRect.x -= m_OverlayCompositionRect.x;
+    oldOverlayRect.y -= m_OverlayCompositionRect.y;
+
+    if (newSurface) {
+        SDL_Rect dstRect = *overlayRect;
+        dstRect.x -= m_OverlayCompositionRect.x;
+        dstRect.y -= m_OverlayCompositionRect.y;
 
         // Compute the union of the current and previous overlay rects. Our draw operation
         // will need to cover this entire area to ensure the old dirty area is covered.
         SDL_Rect overlayUnionRect;
-        SDL_UnionRect(overlayRect, &m_OverlayRects[type], &overlayUnionRect);
+        SDL_UnionRect(&dstRect, &oldOverlayRect, &overlayUnionRect);
 
-        // If the new overlay completely covers the old overlay, blit it all at once
-        if (SDL_RectEquals(&overlayUnionRect, overlayRect)) {
-            SDL_BlitSurface(newSurface, nullptr, m_OverlayCompositionSurface, overlayRect);
+        if (SDL_RectEquals(&dstRect, &oldOverlayRect)) {
+            // If the overlay didn't move, only the part that changed needs to be drawn
+            SDL_Rect srcRect = *updateRect;
+            SDL_Rect updateDstRect = { dstRect.x + updateRect->x, dstRect.y + updateRect->y,
+                                       updateRect->w, updateRect->h };
+            overlayUnionRect = updateDstRect;
+            SDL_BlitSurface(newSurface, &srcRect, m_OverlayCompositionSurface, &updateDstRect);
+        }
+        else if (SDL_RectEquals(&overlayUnionRect, &dstRect)) {
+            // If the new overlay completely covers the old overlay, blit it all at once
+            SDL_BlitSurface(newSurface, nullptr, m_OverlayCompositionSurface, &dstRect);
         }
         else {
             SDL_assert(newSurface->format->format == m_OverlayCompositionSurface->format->format);
@@ -1450,31 +1589,31 @@ void DrmRenderer::blitOverlayToCompositionSurface(Overlay::OverlayType type, SDL
                     (y * m_OverlayCompositionSurface->pitch);
                 auto bpp = m_OverlayCompositionSurface->format->BytesPerPixel;
 
-                if (y < overlayRect->y || y > overlayRect->y + overlayRect->h) {
+                if (y < dstRect.y || y >= dstRect.y + dstRect.h) {
                     // Clear the whole row if the overlay doesn't intersect this row
                     memset(dstPixelRow + (overlayUnionRect.x * bpp),
                            0,
                            overlayUnionRect.w * bpp);
                 }
                 else {
-                    auto srcPixelRow = (uint8_t*)newSurface->pixels + ((y - overlayRect->y) * newSurface->pitch);
+                    auto srcPixelRow = (uint8_t*)newSurface->pixels + ((y - dstRect.y) * newSurface->pitch);
 
                     // Clear columns prior to the intersection
-                    SDL_assert(overlayRect->x >= overlayUnionRect.x);
+                    SDL_assert(dstRect.x >= overlayUnionRect.x);
                     memset(dstPixelRow + (overlayUnionRect.x * bpp),
                            0,
-                           (overlayRect->x - overlayUnionRect.x) * bpp);
+                           (dstRect.x - overlayUnionRect.x) * bpp);
 
                     // Copy the overlay into the intersection
-                    memcpy(dstPixelRow + (overlayRect->x * bpp),
+                    memcpy(dstPixelRow + (dstRect.x * bpp),
                            srcPixelRow,
-                           overlayRect->w * bpp);
+                           dstRect.w * bpp);
 
                     // Clear columns after the intersection
-                    SDL_assert(overlayUnionRect.w >= overlayRect->w);
-                    memset(dstPixelRow + ((overlayRect->x + overlayRect->w) * bpp),
+                    SDL_assert(overlayUnionRect.w >= dstRect.w);
+                    memset(dstPixelRow + ((dstRect.x + dstRect.w) * bpp),
                            0,
-                           (overlayUnionRect.w - overlayRect->w) * bpp);
+                           (overlayUnionRect.w - dstRect.w) * bpp);
                 }
             }
         }
@@ -1484,13 +1623,20 @@ void DrmRenderer::blitOverlayToCompositionSurface(Overlay::OverlayType type, SDL
     }
     else {
         // Clear the pixels where this overlay was drawn before
-        SDL_FillRect(m_OverlayCompositionSurface, &m_OverlayRects[type], 0);
+        SDL_FillRect(m_OverlayCompositionSurface, &oldOverlayRect, 0);
 
         // Dirty the modified portion of the plane
-        m_PropSetter.damagePlane(m_OverlayPlanes[0], m_OverlayRects[type]);
+        m_PropSetter.damagePlane(m_OverlayPlanes[0], oldOverlayRect);
     }
 }
 
+bool DrmRenderer::supportsPartialOverlayUpdates()
+{
+    // We keep a copy of each overlay to draw again in the composition surface
+    // or upload into a new plane FB, so we can patch it with partial updates.
+    return true;
+}
+
 void DrmRenderer::notifyOverlayUpdated(Overlay::OverlayType type)
 {
     std::lock_guard lg { m_OverlayLock };
@@ -1509,7 +1655,7 @@ void DrmRenderer::notifyOverlayUpdated(Overlay::OverlayType type)
     if (!Session::get()->getOverlayManager().isOverlayEnabled(type)) {
         // Turn the overlay plane off when transitioning from enabled to disabled
         if (m_OverlayRects[type].w || m_OverlayRects[type].h) {
-            if (m_OverlayCompositionSurface) {
+            if (m_OverlayCompositionMode) {
                 blitOverlayToCompositionSurface(type, nullptr, nullptr);
             }
             else if (m_OverlayPlanes[type].isValid()) {
@@ -1518,15 +1664,55 @@ void DrmRenderer::notifyOverlayUpdated(Overlay::OverlayType type)
             memset(&m_OverlayRects[type], 0, sizeof(m_OverlayRects[type]));
         }
 
+        // We'll be sent the whole overlay again when it's enabled
+        if (m_OverlaySources[type]) {
+            SDL_FreeSurface(m_OverlaySources[type]);
+            m_OverlaySources[type] = nullptr;
+        }
+
         return;
     }
 
     // Upload a new overlay surface if needed
-    SDL_Surface* newSurface = Session::get()->getOverlayManager().getUpdatedOverlaySurface(type);
+    SDL_Rect updateRect;
+    bool partialUpdate;
+    SDL_Surface* newSurface = Session::get()->getOverlayManager().getUpdatedOverlaySurface(type, &updateRect, &partialUpdate);
     if (newSurface != nullptr) {
         uint32_t dumbBuffer, fbId;
         SDL_Rect overlayRect;
 
+        // Disable blending of the source surface when blitting
+        SDL_SetSurfaceBlendMode(newSurface, SDL_BLENDMODE_NONE);
+
+        // Premultiply alpha in place, so we can copy directly into dumb buffers
+        // without having to read anything (which may be very costly due to UC/WC memory)
+        SDL_PremultiplyAlpha(newSurface->w, newSurface->h,
+                             newSurface->format->format, newSurface->pixels, newSurface->pitch,
+                             newSurface->format->format, newSurface->pixels, newSurface->pitch);
+
+        if (partialUpdate) {
+            // Patch the part that changed into the overlay we kept. We're always
+            // sent the whole overlay first, since we drop it when it's disabled.
+            SDL_assert(m_OverlaySources[type]);
+            if (!m_OverlaySources[type]) {
+                SDL_FreeSurface(newSurface);
+                return;
+            }
+
+            SDL_Rect dstRect = updateRect;
+            SDL_BlitSurface(newSurface, nullptr, m_OverlaySources[type], &dstRect);
+            SDL_FreeSurface(newSurface);
+        }
+        else {
+            // Keep the overlay around to apply partial updates, and so we can draw it again
+            // if the composition surface needs to be reallocated for another overlay.
+            if (m_OverlaySources[type]) {
+                SDL_FreeSurface(m_OverlaySources[type]);
+            }
+            m_OverlaySources[type] = newSurface;
+        }
+        newSurface = m_OverlaySources[type];
+
         if (type == Overlay::OverlayStatusUpdate) {
             // Bottom Left
             overlayRect.x = 0;
@@ -1537,14 +1723,18 @@ void DrmRenderer::notifyOverlayUpdated(Overlay::OverlayType type)
             overlayRect.x = 0;
             overlayRect.y = 0;
         }
+        else if (type == Overlay::OverlayFrameGraph) {
+            // Top right
+            overlayRect.x = m_OutputRect.w - newSurface->w;
+            overlayRect.y = 0;
+        }
 
         overlayRect.w = newSurface->w;
         overlayRect.h = newSurface->h;
 
         // Try to let the display controller composite for us
-        if (!m_OverlayCompositionSurface) {
+        if (!m_OverlayCompositionMode) {
             if (!uploadSurfaceToFb(newSurface, &dumbBuffer, &fbId)) {
-                SDL_FreeSurface(newSurface);
                 return;
             }
 
@@ -1576,20 +1766,17 @@ void DrmRenderer::notifyOverlayUpdated(Overlay::OverlayType type)
         }
 
         // If we're in overlay composition mode, blit this overlay into the composition surface
-        if (m_OverlayCompositionSurface) {
-            blitOverlayToCompositionSurface(type, newSurface, &overlayRect);
+        if (m_OverlayCompositionMode) {
+            blitOverlayToCompositionSurface(type, &overlayRect, &updateRect);
         }
         else {
             // Otherwise queue the plane flip with the new FB
             //
             // NB: This takes ownership of the FB and dumb buffer, even on failure
-            m_PropSetter.flipPlane(m_OverlayCompositionSurface ? m_OverlayPlanes[0] : m_OverlayPlanes[type],
-                                   fbId, dumbBuffer);
-        }
-
-        memcpy(&m_OverlayRects[type], &overlayRect, sizeof(overlayRect));
+            m_PropSetter.flipPlane(m_OverlayPlanes[type], fbId, dumbBuffer);
 
-        SDL_FreeSurface(newSurface);
+            memcpy(&m_OverlayRects[type], &overlayRect, sizeof(overlayRect));
+        }
     }
 }
 
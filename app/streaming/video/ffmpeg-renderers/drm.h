@@ -713,6 +713,7 @@ public:
     virtual int getDecoderColorspace() override;
     virtual void setHdrMode(bool enabled) override;
     virtual void notifyOverlayUpdated(Overlay::OverlayType type) override;
+    virtual bool supportsPartialOverlayUpdates() override;
 #ifdef HAVE_EGL
     virtual bool canExportEGL() override;
     virtual AVPixelFormat getEGLImagePixelFormat() override;
@@ -729,7 +730,8 @@ private:
     bool mapDumbBuffer(uint32_t handle, size_t size, void** mapping);
     bool createFbForDumbBuffer(struct drm_mode_create_dumb* createBuf, uint32_t* fbId);
     void enterOverlayCompositionMode();
-    void blitOverlayToCompositionSurface(Overlay::OverlayType type, SDL_Surface* newSurface, SDL_Rect* overlayRect);
+    void resizeOverlayCompositionSurface(const SDL_Rect& rect);
+    void blitOverlayToCompositionSurface(Overlay::OverlayType type, const SDL_Rect* overlayRect, const SDL_Rect* updateRect);
     static bool drmFormatMatchesVideoFormat(uint32_t drmFormat, int videoFormat);
 
     IFFmpegRenderer* m_BackendRenderer;
@@ -753,7 +755,10 @@ private:
     uint64_t m_VideoPlaneZpos;
     DrmPropertyMap m_OverlayPlanes[Overlay::OverlayMax];
     DrmPropertySetter m_PropSetter;
+    bool m_OverlayCompositionMode;
     SDL_Surface* m_OverlayCompositionSurface;
+    SDL_Rect m_OverlayCompositionRect;
+    SDL_Surface* m_OverlaySources[Overlay::OverlayMax];
     std::mutex m_OverlayLock;
     SDL_Rect m_OverlayRects[Overlay::OverlayMax];
     drmVersionPtr m_Version;
@@ -136,6 +136,12 @@ void EGLRenderer::notifyOverlayUpdated(Overlay::OverlayType type)
     }
 }
 
+bool EGLRenderer::supportsPartialOverlayUpdates()
+{
+    // The overlay textures keep their contents between updates
+    return true;
+}
+
 bool EGLRenderer::notifyWindowChanged(PWINDOW_STATE_CHANGE_INFO info)
 {
     // We can transparently handle size and display changes
@@ -160,6 +166,7 @@ void EGLRenderer::renderOverlay(Overlay::OverlayType type, int viewportWidth, in
     typedef void (*PFNGLBINDTEXTUREPROC)(GLenum target, GLuint texture);
     typedef void (*PFNGLPIXELSTOREIPROC)(GLenum pname, GLint param);
     typedef void (*PFNGLTEXIMAGE2DPROC)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels);
+    typedef void (*PFNGLTEXSUBIMAGE2DPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
     typedef void (*PFNGLBINDBUFFERPROC)(GLenum target, GLuint buffer);
     typedef void (*PFNGLBUFFERDATAPROC)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
     typedef void (*PFNGLUSEPROGRAMPROC)(GLuint program);
@@ -169,6 +176,7 @@ void EGLRenderer::renderOverlay(Overlay::OverlayType type, int viewportWidth, in
     PFNGLBINDTEXTUREPROC glBindTextureFn = (PFNGLBINDTEXTUREPROC)SDL_GL_GetProcAddress("glBindTexture");
     PFNGLPIXELSTOREIPROC glPixelStoreiFn = (PFNGLPIXELSTOREIPROC)SDL_GL_GetProcAddress("glPixelStorei");
     PFNGLTEXIMAGE2DPROC glTexImage2DFn = (PFNGLTEXIMAGE2DPROC)SDL_GL_GetProcAddress("glTexImage2D");
+    PFNGLTEXSUBIMAGE2DPROC glTexSubImage2DFn = (PFNGLTEXSUBIMAGE2DPROC)SDL_GL_GetProcAddress("glTexSubImage2D");
     PFNGLBINDBUFFERPROC glBindBufferFn = (PFNGLBINDBUFFERPROC)SDL_GL_GetProcAddress("glBindBuffer");
     PFNGLBUFFERDATAPROC glBufferDataFn = (PFNGLBUFFERDATAPROC)SDL_GL_GetProcAddress("glBufferData");
     PFNGLUSEPROGRAMPROC glUseProgramFn = (PFNGLUSEPROGRAMPROC)SDL_GL_GetProcAddress("glUseProgram");
@@ -181,7 +189,9 @@ void EGLRenderer::renderOverlay(Overlay::OverlayType type, int viewportWidth, in
     }
 
     // Upload a new overlay texture if needed
-    SDL_Surface* newSurface = Session::get()->getOverlayManager().getUpdatedOverlaySurface(type);
+    SDL_Rect updateRect;
+    bool partialUpdate;
+    SDL_Surface* newSurface = Session::get()->getOverlayManager().getUpdatedOverlaySurface(type, &updateRect, &partialUpdate);
     if (newSurface != nullptr) {
         SDL_assert(!SDL_MUSTLOCK(newSurface));
         SDL_assert(newSurface->format->format == SDL_PIXELFORMAT_ARGB8888);
@@ -211,8 +221,16 @@ void EGLRenderer::renderOverlay(Overlay::OverlayType type, int viewportWidth, in
             }
         }
 
-        if (glTexImage2DFn) glTexImage2DFn(GL_TEXTURE_2D, 0, GL_RGBA, newSurface->w, newSurface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                     packedPixelData ? packedPixelData : newSurface->pixels);
+        if (partialUpdate) {
+            // Only replace the part of the texture that changed
+            if (glTexSubImage2DFn) glTexSubImage2DFn(GL_TEXTURE_2D, 0, updateRect.x, updateRect.y, newSurface->w, newSurface->h,
+                                                     GL_RGBA, GL_UNSIGNED_BYTE,
+                                                     packedPixelData ? packedPixelData : newSurface->pixels);
+        }
+        else {
+            if (glTexImage2DFn) glTexImage2DFn(GL_TEXTURE_2D, 0, GL_RGBA, newSurface->w, newSurface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                         packedPixelData ? packedPixelData : newSurface->pixels);
+        }
 
         if (packedPixelData) {
             free(packedPixelData);
@@ -221,46 +239,57 @@ void EGLRenderer::renderOverlay(Overlay::OverlayType type, int viewportWidth, in
             if (glPixelStoreiFn) glPixelStoreiFn(GL_UNPACK_ROW_LENGTH_EXT, 0);
         }
 
-        SDL_FRect overlayRect;
-
-        // These overlay positions differ from the other renderers because OpenGL
-        // places the origin in the lower-left corner instead of the upper-left.
-        if (type == Overlay::OverlayStatusUpdate) {
-            // Bottom Left
-            overlayRect.x = 0;
-            overlayRect.y = 0;
-        }
-        else if (type == Overlay::OverlayDebug) {
-            // Top left
-            overlayRect.x = 0;
-            overlayRect.y = viewportHeight - newSurface->h;
-        } else {
-            SDL_assert(false);
+        if (partialUpdate) {
+            // The overlay keeps its size and position
+            SDL_FreeSurface(newSurface);
         }
+        else {
+            SDL_FRect overlayRect;
+
+            // These overlay positions differ from the other renderers because OpenGL
+            // places the origin in the lower-left corner instead of the upper-left.
+            if (type == Overlay::OverlayStatusUpdate) {
+                // Bottom Left
+                overlayRect.x = 0;
+                overlayRect.y = 0;
+            }
+            else if (type == Overlay::OverlayDebug) {
+                // Top left
+                overlayRect.x = 0;
+                overlayRect.y = viewportHeight - newSurface->h;
+            }
+            else if (type == Overlay::OverlayFrameGraph) {
+                // Top right
+                overlayRect.x = viewportWidth - newSurface->w;
+                overlayRect.y = viewportHeight - newSurface->h;
+            } else {
+                SDL_assert(false);
+            }
 
-        overlayRect.w = newSurface->w;
-        overlayRect.h = newSurface->h;
+            overlayRect.w = newSurface->w;
+            overlayRect.h = newSurface->h;
 
-        SDL_FreeSurface(newSurface);
+            SDL_FreeSurface(newSurface);
 
-        // Convert screen space to normalized device coordinates
-        StreamUtils::screenSpaceToNormalizedDeviceCoords(&overlayRect, viewportWidth, viewportHeight);
+            // Convert screen space to normalized device coordinates
+            StreamUtils::screenSpaceToNormalizedDeviceCoords(&overlayRect, viewportWidth, viewportHeight);
 
-        VERTEX verts[] =
-        {
-            {overlayRect.x + overlayRect.w, overlayRect.y + overlayRect.h, 1.0f, 0.0f},
-            {overlayRect.x, overlayRect.y + overlayRect.h, 0.0f, 0.0f},
-            {overlayRect.x, overlayRect.y, 0.0f, 1.0f},
-            {overlayRect.x, overlayRect.y, 0.0f, 1.0f},
-            {overlayRect.x + overlayRect.w, overlayRect.y, 1.0f, 1.0f},
-            {overlayRect.x + overlayRect.w, overlayRect.y + overlayRect.h, 1.0f, 0.0f}
-        };
-
-        // Update the VBO for this overlay (already bound to a VAO)
-        if (glBindBufferFn) glBindBufferFn(GL_ARRAY_BUFFER, m_OverlayVBOs[type]);
-        if (glBufferDataFn) glBufferDataFn(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-        SDL_AtomicSet(&m_OverlayHasValidData[type], 1);
+            VERTEX verts[] =
+            {
+                {overlayRect.x + overlayRect.w, overlayRect.y + overlayRect.h, 1.0f, 0.0f},
+                {overlayRect.x, overlayRect.y + overlayRect.h, 0.0f, 0.0f},
+                {overlayRect.x, overlayRect.y, 0.0f, 1.0f},
+                {overlayRect.x, overlayRect.y, 0.0f, 1.0f},
+                {overlayRect.x + overlayRect.w, overlayRect.y, 1.0f, 1.0f},
+                {overlayRect.x + overlayRect.w, overlayRect.y + overlayRect.h, 1.0f, 0.0f}
+            };
+
+            // Update the VBO for this overlay (already bound to a VAO)
+            if (glBindBufferFn) glBindBufferFn(GL_ARRAY_BUFFER, m_OverlayVBOs[type]);
+            if (glBufferDataFn) glBufferDataFn(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+
+            SDL_AtomicSet(&m_OverlayHasValidData[type], 1);
+        }
     }
 
     if (!SDL_AtomicGet(&m_OverlayHasValidData[type])) {
@@ -1,5 +1,6 @@
 #include "pacer.h"
 #include "streaming/streamutils.h"
+#include "streaming/session.h"
 
 #include <chrono>
 
@@ -31,10 +32,16 @@ static_assert(PACER_MAX_OUTSTANDING_FRAMES == MAX_QUEUED_FRAMES + 2,
 // V-sync happens.
 #define TIMER_SLACK_MS 3
 
+static inline uint64_t getMicroseconds() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 Pacer::Pacer(IFFmpegRenderer* renderer, PVIDEO_STATS videoStats) :
     m_RenderThread(nullptr),
     m_VsyncThread(nullptr),
     m_DeferredFreeFrame(nullptr),
+    m_HoldTimer(0),
     m_Stopping(false),
     m_VsyncSource(nullptr),
     m_VsyncRenderer(renderer),
@@ -49,6 +56,8 @@ Pacer::~Pacer()
 {
     m_Stopping = true;
 
+    SDL_RemoveTimer(m_HoldTimer);
+
     // Stop the V-sync thread
     if (m_VsyncThread != nullptr) {
         m_PacingQueueNotEmpty.wakeAll();
@@ -92,15 +101,38 @@ void Pacer::renderOnMainThread()
 
     m_FrameQueueLock.lock();
 
-    if (!m_RenderQueue.isEmpty()) {
+    if (countDueFrames(m_RenderQueue, getMicroseconds()) > 0) {
         AVFrame* frame = m_RenderQueue.dequeue();
         m_FrameQueueLock.unlock();
 
         renderFrame(frame);
+
+        m_FrameQueueLock.lock();
     }
-    else {
-        m_FrameQueueLock.unlock();
+
+    // Frames held back for A/V sync may have had their frame ready events
+    // consumed already, so schedule another one for when the next is due.
+    if (!m_RenderQueue.isEmpty() && Session::get()->getAVSyncTracker().getVideoDelayUs() != 0) {
+        uint64_t nowUs = getMicroseconds();
+        uint64_t presentationTimeUs = getPresentationTimeUs(m_RenderQueue.head());
+        Uint32 holdMs = presentationTimeUs > nowUs ? (Uint32)((presentationTimeUs - nowUs + 999) / 1000) : 1;
+
+        SDL_RemoveTimer(m_HoldTimer);
+        m_HoldTimer = SDL_AddTimer(holdMs, Pacer::holdTimerCallback, nullptr);
     }
+
+    m_FrameQueueLock.unlock();
+}
+
+Uint32 Pacer::holdTimerCallback(Uint32, void*)
+{
+    // Render the held frame from the main thread
+    SDL_Event event = {};
+    event.type = SDL_USEREVENT;
+    event.user.code = SDL_CODE_FRAME_READY;
+    SDL_PushEvent(&event);
+
+    return 0;
 }
 
 int Pacer::vsyncThread(void *context)
@@ -155,8 +187,22 @@ int Pacer::renderThread(void* context)
         me->m_FrameQueueLock.lock();
 
         // Wait for a frame to be ready to render
-        while (!me->m_Stopping && me->m_RenderQueue.isEmpty()) {
-            me->m_RenderQueueNotEmpty.wait(&me->m_FrameQueueLock);
+        while (!me->m_Stopping) {
+            if (me->m_RenderQueue.isEmpty()) {
+                me->m_RenderQueueNotEmpty.wait(&me->m_FrameQueueLock);
+                continue;
+            }
+
+            uint64_t nowUs = getMicroseconds();
+            if (me->countDueFrames(me->m_RenderQueue, nowUs) > 0) {
+                break;
+            }
+
+            // Hold the frame back for A/V sync. A new frame arriving wakes us
+            // early, in case it fills the queue and forces this one out.
+            uint64_t presentationTimeUs = me->getPresentationTimeUs(me->m_RenderQueue.head());
+            me->m_RenderQueueNotEmpty.wait(&me->m_FrameQueueLock,
+                                           (unsigned long)((presentationTimeUs - nowUs + 999) / 1000));
         }
 
         if (me->m_Stopping) {
@@ -207,6 +253,9 @@ void Pacer::handleVsync(int timeUntilNextVsyncMillis)
 
     m_FrameQueueLock.lock();
 
+    // Frames held back for A/V sync aren't counted as excess
+    int dueFrames = countDueFrames(m_PacingQueue, getMicroseconds());
+
     // If the queue length history entries are large, be strict
     // about dropping excess frames.
     int frameDropTarget = 1;
@@ -229,12 +278,13 @@ void Pacer::handleVsync(int timeUntilNextVsyncMillis)
             m_PacingQueueHistory.dequeue();
         }
 
-        m_PacingQueueHistory.enqueue(m_PacingQueue.count());
+        m_PacingQueueHistory.enqueue(dueFrames);
     }
 
     // Catch up if we're several frames ahead
-    while (m_PacingQueue.count() > frameDropTarget) {
+    while (dueFrames > frameDropTarget) {
         AVFrame* frame = m_PacingQueue.dequeue();
+        dueFrames--;
 
         // Drop the lock while we call av_frame_free()
         m_FrameQueueLock.unlock();
@@ -255,6 +305,14 @@ void Pacer::handleVsync(int timeUntilNextVsyncMillis)
             m_FrameQueueLock.unlock();
             return;
         }
+
+        dueFrames = countDueFrames(m_PacingQueue, getMicroseconds());
+    }
+
+    if (dueFrames == 0) {
+        // The next frame is held back for A/V sync, so check again next V-sync
+        m_FrameQueueLock.unlock();
+        return;
     }
 
     // Place the first frame on the render queue
@@ -333,12 +391,6 @@ void Pacer::signalVsync()
 
 void Pacer::renderFrame(AVFrame* frame)
 {
-    // Helper function to get current time in microseconds
-    using namespace std::chrono;
-    auto getMicroseconds = []() {
-        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
-    };
-    
     // Count time spent in Pacer's queues
     uint64_t beforeRender = getMicroseconds();
     m_VideoStats->totalPacerTimeUs += (beforeRender - (uint64_t)frame->pkt_dts);
@@ -350,6 +402,15 @@ void Pacer::renderFrame(AVFrame* frame)
     m_VideoStats->totalRenderTimeUs += (afterRender - beforeRender);
     m_VideoStats->renderedFrames++;
 
+    FrameTimeGraph& frameTimeGraph = Session::get()->getOverlayManager().getFrameTimeGraph();
+    frameTimeGraph.submit(FrameTimeGraph::PacerTime, beforeRender - (uint64_t)frame->pkt_dts);
+    frameTimeGraph.submit(FrameTimeGraph::RenderTime, afterRender - beforeRender);
+
+    // The decoder stores the frame's arrival time in the PTS field
+    if (frame->pts != AV_NOPTS_VALUE) {
+        Session::get()->getAVSyncTracker().submitVideoLatency(afterRender - (uint64_t)frame->pts);
+    }
+
     // Wait until after next frame to free this one to ensure the GPU
     // doesn't stall or read garbage if the backing buffer gets returned
     // to the pool and the decoder tries to write a new frame into it
@@ -359,6 +420,9 @@ void Pacer::renderFrame(AVFrame* frame)
     // Drop frames if we have too many queued up for a while
     m_FrameQueueLock.lock();
 
+    // Frames held back for A/V sync aren't counted as excess
+    int dueFrames = countDueFrames(m_RenderQueue, getMicroseconds());
+
     int frameDropTarget;
 
     if (m_RendererAttributes & RENDERER_ATTRIBUTE_NO_BUFFERING) {
@@ -382,12 +446,13 @@ void Pacer::renderFrame(AVFrame* frame)
             m_RenderQueueHistory.dequeue();
         }
 
-        m_RenderQueueHistory.enqueue(m_RenderQueue.count());
+        m_RenderQueueHistory.enqueue(dueFrames);
     }
 
     // Catch up if we're several frames ahead
-    while (m_RenderQueue.count() > frameDropTarget) {
+    while (dueFrames > frameDropTarget) {
         AVFrame* frame = m_RenderQueue.dequeue();
+        dueFrames--;
 
         // Drop the lock while we call av_frame_free()
         m_FrameQueueLock.unlock();
@@ -408,6 +473,34 @@ void Pacer::dropFrameForEnqueue(QQueue<AVFrame*>& queue)
     }
 }
 
+uint64_t Pacer::getPresentationTimeUs(AVFrame* frame)
+{
+    // The decoder stores the frame's arrival time in the PTS field
+    if (frame->pts == AV_NOPTS_VALUE) {
+        return 0;
+    }
+
+    // A/V sync correction delays video to match a slower audio path
+    return (uint64_t)frame->pts + Session::get()->getAVSyncTracker().getVideoDelayUs();
+}
+
+int Pacer::countDueFrames(const QQueue<AVFrame*>& queue, uint64_t nowUs)
+{
+    // Frames are queued in arrival order, so the due frames are at the head
+    int dueFrames = 0;
+    while (dueFrames < queue.count() && getPresentationTimeUs(queue.at(dueFrames)) <= nowUs) {
+        dueFrames++;
+    }
+
+    // Release the oldest frame early rather than drop it once the queue is full.
+    // We can't hold more frames than this without starving the decoder of surfaces.
+    if (dueFrames == 0 && queue.count() == MAX_QUEUED_FRAMES) {
+        dueFrames = 1;
+    }
+
+    return dueFrames;
+}
+
 void Pacer::submitFrame(AVFrame* frame)
 {
     // Make sure initialize() has been called
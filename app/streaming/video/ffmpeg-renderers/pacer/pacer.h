@@ -56,6 +56,12 @@ private:
 
     void dropFrameForEnqueue(QQueue<AVFrame*>& queue);
 
+    uint64_t getPresentationTimeUs(AVFrame* frame);
+
+    int countDueFrames(const QQueue<AVFrame*>& queue, uint64_t nowUs);
+
+    static Uint32 holdTimerCallback(Uint32 interval, void* param);
+
     QQueue<AVFrame*> m_RenderQueue;
     QQueue<AVFrame*> m_PacingQueue;
     QQueue<int> m_PacingQueueHistory;
@@ -67,6 +73,7 @@ private:
     SDL_Thread* m_RenderThread;
     SDL_Thread* m_VsyncThread;
     AVFrame* m_DeferredFreeFrame;
+    SDL_TimerID m_HoldTimer;
     bool m_Stopping;
 
     IVsyncSource* m_VsyncSource;
@@ -436,6 +436,11 @@ public:
 
     virtual void notifyOverlayUpdated(Overlay::OverlayType type) override
     {
+        // The graph can't be drawn with a text field
+        if (type == Overlay::OverlayFrameGraph) {
+            return;
+        }
+
         // We must do the actual UI updates on the main thread, so queue an
         // async callback on the main thread via GCD to do the UI update.
         dispatch_async(dispatch_get_main_queue(), m_OverlayUpdateBlocks[type]);
@@ -500,6 +500,11 @@ public:
                     renderRect.x = 0;
                     renderRect.y = m_LastDrawableHeight - overlayTexture.height;
                 }
+                else if (i == Overlay::OverlayFrameGraph) {
+                    // Top right
+                    renderRect.x = m_LastDrawableWidth - overlayTexture.width;
+                    renderRect.y = m_LastDrawableHeight - overlayTexture.height;
+                }
 
                 renderRect.w = overlayTexture.width;
                 renderRect.h = overlayTexture.height;
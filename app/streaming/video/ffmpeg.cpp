@@ -77,6 +77,13 @@ static inline uint64_t getReceiveTimeUs(const DECODE_UNIT& du) {
 
 #define FAILED_DECODES_RESET_THRESHOLD 20
 
+// Space for each section of the performance overlay text. The video and audio
+// sections have a fixed set of lines that always fit. The input section has a
+// line per active gamepad, so it drops the lines that don't fit.
+#define OVERLAY_VIDEO_STATS_BUDGET 1024
+#define OVERLAY_AUDIO_STATS_BUDGET 384
+#define OVERLAY_INPUT_STATS_BUDGET 640
+
 bool FFmpegVideoDecoder::isHardwareAccelerated()
 {
     return m_HwDecodeCfg != nullptr ||
@@ -249,6 +256,10 @@ FFmpegVideoDecoder::FFmpegVideoDecoder(bool testOnly)
       m_FramesIn(0),
       m_FramesOut(0),
       m_LastFrameNumber(0),
+      m_LastFrameReceiveTimeUs(0),
+      m_ReceiveClockOffsetUs(0),
+      m_HasReceiveClockOffset(false),
+      m_LastFrameGraphUpdateUs(0),
       m_StreamFps(0),
       m_VideoFormat(0),
       m_NeedsSpsFixup(false),
@@ -780,6 +791,10 @@ bool FFmpegVideoDecoder::completeInitialization(const AVCodec* decoder, enum AVP
             return false;
         }
 
+        Session::get()->getStatsExporter().setVideoPipeline(m_VideoDecoderCtx->codec->name,
+                                                            m_FrontendRenderer->getRendererName(),
+                                                            m_BackendRenderer->getRendererName());
+
         if (m_FrontendRenderer->getRendererType() != m_BackendRenderer->getRendererType()) {
             SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                         "Renderer '%s' with '%s' backend chosen",
@@ -829,6 +844,9 @@ void FFmpegVideoDecoder::addVideoStats(VIDEO_STATS& src, VIDEO_STATS& dst)
         SDL_assert(dst.lastRtt > 0);
     }
 
+    dst.hasAvSyncSkew = Session::get()->getAVSyncTracker().getSkewUs(&dst.avSyncSkewUs);
+    dst.avSyncVideoDelayUs = Session::get()->getAVSyncTracker().getVideoDelayUs();
+
     // Initialize the measurement start point if this is the first video stat window
     if (!dst.measurementStartUs) {
         dst.measurementStartUs = src.measurementStartUs;
@@ -1016,12 +1034,26 @@ void FFmpegVideoDecoder::stringifyVideoStats(VIDEO_STATS& stats, char* output, i
 
         offset += ret;
     }
+
+    if (stats.hasAvSyncSkew) {
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "A/V sync: audio %+.1f ms relative to video (correction: %.1f ms)\n",
+                       stats.avSyncSkewUs / 1000.0,
+                       stats.avSyncVideoDelayUs / 1000.0);
+        if (ret < 0 || ret >= length - offset) {
+            SDL_assert(false);
+            return;
+        }
+
+        offset += ret;
+    }
 }
 
 void FFmpegVideoDecoder::logVideoStats(VIDEO_STATS& stats, const char* title)
 {
     if (stats.renderedFps > 0 || stats.renderedFrames != 0) {
-        char videoStatsStr[512];
+        char videoStatsStr[1024];
         stringifyVideoStats(stats, videoStatsStr, sizeof(videoStatsStr));
 
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
@@ -1984,11 +2016,12 @@ void FFmpegVideoDecoder::decoderThreadProc()
                         }
                         
                         m_ActiveWndVideoStats.totalDecodeTimeUs += actualDecodeTimeUs;
+                        Session::get()->getOverlayManager().getFrameTimeGraph().submit(FrameTimeGraph::DecodeTime,
+                                                                                       actualDecodeTimeUs);
 
-                        // Store the presentation time (90 kHz timebase)
-                        // rtpTimestamp field was removed, use frame number as fallback
-                        // The actual PTS will be set by the decoder based on frame timing
-                        frame->pts = AV_NOPTS_VALUE;
+                        // Carry the frame's arrival time (in our clock) through to
+                        // the Pacer, so it can measure latency for A/V sync.
+                        frame->pts = du.receiveTimeUs;
                     }
 
                     m_ActiveWndVideoStats.decodedFrames++;
@@ -2060,6 +2093,33 @@ int FFmpegVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
         return DR_NEED_IDR;
     }
 
+    // moonlight-common-c's clock may differ from ours, so track the offset between
+    // them. A frame dequeued right after it was enqueued gives the smallest offset,
+    // so the minimum excludes time spent waiting in the decode unit queue.
+    int64_t clockOffsetUs = (int64_t)(getMicroseconds() - getEnqueueTimeUs(*du));
+    if (!m_HasReceiveClockOffset || clockOffsetUs < m_ReceiveClockOffsetUs) {
+        m_ReceiveClockOffsetUs = clockOffsetUs;
+        m_HasReceiveClockOffset = true;
+    }
+
+    // Translate the arrival time into our clock. The Pacer holds the decoded frame
+    // until this time plus any A/V sync delay, so the decoder never waits on it.
+    uint64_t receiveTimeUs = (uint64_t)(getReceiveTimeUs(*du) + m_ReceiveClockOffsetUs);
+
+    // Graph the spacing between frame arrivals to show network jitter
+    if (m_LastFrameReceiveTimeUs != 0) {
+        Session::get()->getOverlayManager().getFrameTimeGraph().submit(FrameTimeGraph::NetworkInterval,
+                                                                       receiveTimeUs - SDL_min(receiveTimeUs, m_LastFrameReceiveTimeUs));
+    }
+    m_LastFrameReceiveTimeUs = receiveTimeUs;
+
+    // Redraw the frame time graph at a fixed rate while it's visible
+    if (Session::get()->getOverlayManager().isOverlayEnabled(Overlay::OverlayFrameGraph) &&
+            getMicroseconds() >= m_LastFrameGraphUpdateUs + FRAME_GRAPH_UPDATE_INTERVAL_MS * 1000) {
+        Session::get()->getOverlayManager().setOverlayTextUpdated(Overlay::OverlayFrameGraph);
+        m_LastFrameGraphUpdateUs = getMicroseconds();
+    }
+
     if (!m_LastFrameNumber) {
         m_ActiveWndVideoStats.measurementStartUs = getMicroseconds();
         m_LastFrameNumber = du->frameNumber;
@@ -2081,12 +2141,29 @@ int FFmpegVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
             addVideoStats(m_LastWndVideoStats, lastTwoWndStats);
             addVideoStats(m_ActiveWndVideoStats, lastTwoWndStats);
 
-            stringifyVideoStats(lastTwoWndStats,
-                                Session::get()->getOverlayManager().getOverlayText(Overlay::OverlayDebug),
-                                Session::get()->getOverlayManager().getOverlayMaxTextLength());
+            char* overlayText = Session::get()->getOverlayManager().getOverlayText(Overlay::OverlayDebug);
+            SDL_assert(OVERLAY_VIDEO_STATS_BUDGET + OVERLAY_AUDIO_STATS_BUDGET + OVERLAY_INPUT_STATS_BUDGET <=
+                       Session::get()->getOverlayManager().getOverlayMaxTextLength());
+
+            // Each section is written within its own budget, so none of them can crowd out the rest
+            int offset = 0;
+            stringifyVideoStats(lastTwoWndStats, &overlayText[offset], OVERLAY_VIDEO_STATS_BUDGET);
+            offset += (int)strlen(&overlayText[offset]);
+            Session::get()->stringifyLastAudioStats(&overlayText[offset], OVERLAY_AUDIO_STATS_BUDGET);
+            offset += (int)strlen(&overlayText[offset]);
+            Session::get()->getInputLatencyTracker().stringifyAndResetWindow(&overlayText[offset], OVERLAY_INPUT_STATS_BUDGET);
             Session::get()->getOverlayManager().setOverlayTextUpdated(Overlay::OverlayDebug);
         }
 
+        // Publish the completed window for monitoring tools
+        if (Session::get()->getStatsExporter().isEnabled()) {
+            VIDEO_STATS windowStats = {};
+            addVideoStats(m_ActiveWndVideoStats, windowStats);
+            Session::get()->getStatsExporter().submitVideoStats(windowStats,
+                                                                m_BwTracker.GetAverageMbps(),
+                                                                m_BwTracker.GetPeakMbps());
+        }
+
         // Accumulate these values into the global stats
         addVideoStats(m_ActiveWndVideoStats, m_GlobalVideoStats);
 
@@ -2173,6 +2250,7 @@ int FFmpegVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
     // We'll use this to calculate actual decode time, not queue wait time
     DECODE_UNIT duWithDecodeTime = *du;
     duWithDecodeTime.enqueueTimeUs = decodeStartTimeUs;
+    duWithDecodeTime.receiveTimeUs = receiveTimeUs;
     m_FrameInfoQueue.enqueue(duWithDecodeTime);
 
     m_FramesIn++;
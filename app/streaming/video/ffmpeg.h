@@ -123,6 +123,10 @@ private:
     int m_FramesOut;
 
     int m_LastFrameNumber;
+    uint64_t m_LastFrameReceiveTimeUs;
+    int64_t m_ReceiveClockOffsetUs;
+    bool m_HasReceiveClockOffset;
+    uint64_t m_LastFrameGraphUpdateUs;
     int m_StreamFps;
     int m_OriginalVideoWidth;
     int m_OriginalVideoHeight;
@@ -0,0 +1,168 @@
+#include "frametimegraph.h"
+
+// Horizontal guide lines are drawn at multiples of this interval
+#define FRAME_GRAPH_GUIDE_MS 10
+
+// Space between the series names in the legend
+#define FRAME_GRAPH_LEGEND_SPACING 8
+
+static const struct {
+    const char* name;
+    SDL_Color color;
+} k_SeriesInfo[FrameTimeGraph::SeriesMax] = {
+    { "Network", { 0x00, 0xC0, 0xFF, 0xFF } },
+    { "Decode", { 0x40, 0xE0, 0x40, 0xFF } },
+    { "Pacer", { 0xE0, 0xE0, 0x00, 0xFF } },
+    { "Render", { 0xFF, 0x50, 0xFF, 0xFF } },
+};
+
+FrameTimeGraph::FrameTimeGraph()
+    : m_Legend(nullptr)
+{
+    SDL_zero(m_Rings);
+}
+
+FrameTimeGraph::~FrameTimeGraph()
+{
+    if (m_Legend != nullptr) {
+        SDL_FreeSurface(m_Legend);
+    }
+}
+
+void FrameTimeGraph::submit(Series series, uint64_t valueUs)
+{
+    auto& ring = m_Rings[series];
+    int total = SDL_AtomicGet(&ring.total);
+
+    ring.samplesUs[total % FRAME_GRAPH_SAMPLES] = (uint32_t)SDL_min(valueUs, (uint64_t)UINT32_MAX);
+
+    // Publish the sample only after it has been written
+    total++;
+    if (total >= 2 * FRAME_GRAPH_SAMPLES) {
+        total -= FRAME_GRAPH_SAMPLES;
+    }
+    SDL_AtomicSet(&ring.total, total);
+}
+
+static int valueToY(uint32_t valueUs)
+{
+    uint32_t clampedUs = SDL_min(valueUs, (uint32_t)FRAME_GRAPH_SCALE_MS * 1000);
+    return (FRAME_GRAPH_HEIGHT - 1) - (int)(clampedUs * (uint64_t)(FRAME_GRAPH_HEIGHT - 1) / (FRAME_GRAPH_SCALE_MS * 1000));
+}
+
+void FrameTimeGraph::buildLegend(TTF_Font* font)
+{
+    if (m_Legend != nullptr) {
+        SDL_FreeSurface(m_Legend);
+        m_Legend = nullptr;
+    }
+
+    SDL_Surface* labels[SeriesMax] = {};
+    int width = 0;
+    int height = 0;
+
+    for (int i = 0; i < SeriesMax; i++) {
+        labels[i] = TTF_RenderText_Blended(font, k_SeriesInfo[i].name, k_SeriesInfo[i].color);
+        if (labels[i] != nullptr) {
+            width += labels[i]->w + (i != 0 ? FRAME_GRAPH_LEGEND_SPACING : 0);
+            height = SDL_max(height, labels[i]->h);
+        }
+    }
+
+    // The legend is clipped to the width of the graph
+    SDL_Surface* legend = nullptr;
+    if (width > 0 && height > 0) {
+        legend = SDL_CreateRGBSurfaceWithFormat(0,
+                                                SDL_min(width, FRAME_GRAPH_SAMPLES),
+                                                height,
+                                                32,
+                                                SDL_PIXELFORMAT_ARGB8888);
+    }
+
+    int x = 0;
+    for (int i = 0; i < SeriesMax; i++) {
+        if (labels[i] == nullptr) {
+            continue;
+        }
+
+        if (legend != nullptr) {
+            SDL_Rect dst = { x, 0, labels[i]->w, labels[i]->h };
+            SDL_SetSurfaceBlendMode(labels[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(labels[i], nullptr, legend, &dst);
+            x += labels[i]->w + FRAME_GRAPH_LEGEND_SPACING;
+        }
+
+        SDL_FreeSurface(labels[i]);
+    }
+
+    if (legend != nullptr) {
+        // The legend replaces the transparent area above the plot
+        SDL_SetSurfaceBlendMode(legend, SDL_BLENDMODE_NONE);
+    }
+
+    m_Legend = legend;
+}
+
+void FrameTimeGraph::drawSeries(SDL_Surface* surface, int plotY, Series series)
+{
+    auto& ring = m_Rings[series];
+    // Read the counter once, so the sample count and positions always agree
+    int total = SDL_AtomicGet(&ring.total);
+    int count = SDL_min(total, FRAME_GRAPH_SAMPLES);
+    Uint32 color = SDL_MapRGBA(surface->format,
+                               k_SeriesInfo[series].color.r,
+                               k_SeriesInfo[series].color.g,
+                               k_SeriesInfo[series].color.b,
+                               k_SeriesInfo[series].color.a);
+
+    // The newest sample is drawn at the right edge
+    int lastY = -1;
+    for (int i = 0; i < count; i++) {
+        uint32_t valueUs = ring.samplesUs[(total - count + i) % FRAME_GRAPH_SAMPLES];
+        int y = valueToY(valueUs);
+
+        // Connect each sample to the previous one with a vertical run,
+        // so single-frame spikes show up as a full-height line.
+        int top = lastY < 0 ? y : SDL_min(y, lastY);
+        int bottom = lastY < 0 ? y : SDL_max(y, lastY);
+
+        SDL_Rect rect = { FRAME_GRAPH_SAMPLES - count + i, plotY + top, 1, bottom - top + 1 };
+        SDL_FillRect(surface, &rect, color);
+
+        lastY = y;
+    }
+}
+
+SDL_Surface* FrameTimeGraph::render()
+{
+    int plotY = m_Legend != nullptr ? m_Legend->h : 0;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0,
+                                                          FRAME_GRAPH_SAMPLES,
+                                                          plotY + FRAME_GRAPH_HEIGHT,
+                                                          32,
+                                                          SDL_PIXELFORMAT_ARGB8888);
+    if (surface == nullptr) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "SDL_CreateRGBSurfaceWithFormat() failed: %s",
+                    SDL_GetError());
+        return nullptr;
+    }
+
+    if (m_Legend != nullptr) {
+        SDL_BlitSurface(m_Legend, nullptr, surface, nullptr);
+    }
+
+    // Draw a translucent background with guide lines to read the values against
+    SDL_Rect plotRect = { 0, plotY, FRAME_GRAPH_SAMPLES, FRAME_GRAPH_HEIGHT };
+    SDL_FillRect(surface, &plotRect, SDL_MapRGBA(surface->format, 0x00, 0x00, 0x00, 0x80));
+    for (int ms = FRAME_GRAPH_GUIDE_MS; ms < FRAME_GRAPH_SCALE_MS; ms += FRAME_GRAPH_GUIDE_MS) {
+        SDL_Rect guideRect = { 0, plotY + valueToY(ms * 1000), FRAME_GRAPH_SAMPLES, 1 };
+        SDL_FillRect(surface, &guideRect, SDL_MapRGBA(surface->format, 0x60, 0x60, 0x60, 0xC0));
+    }
+
+    for (int i = 0; i < SeriesMax; i++) {
+        drawSeries(surface, plotY, (Series)i);
+    }
+
+    return surface;
+}
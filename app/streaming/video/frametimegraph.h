@@ -0,0 +1,69 @@
+#pragma once
+
+#include "SDL_compat.h"
+#include <SDL_ttf.h>
+
+#include <cstdint>
+
+// Number of frames shown in the graph (one pixel column per frame)
+#define FRAME_GRAPH_SAMPLES 240
+
+// Height of the plot area and the time it represents. Values above it are clipped.
+#define FRAME_GRAPH_HEIGHT 100
+#define FRAME_GRAPH_SCALE_MS 40
+
+// How often the graph overlay is redrawn while it's visible
+#define FRAME_GRAPH_UPDATE_INTERVAL_MS 100
+
+/**
+ * @brief The FrameTimeGraph class draws rolling per-frame timing graphs for the overlay.
+ *
+ * Each series keeps the last FRAME_GRAPH_SAMPLES values in its own ring buffer. A series
+ * must only be submitted from one thread (the decoder thread for network and decode
+ * times, the render thread for pacer and render times), so the rings need no locking.
+ * Each ring publishes its samples through a single atomic counter, so the reader always
+ * sees a consistent set of samples. It may still see a sample being replaced at the
+ * oldest end of a ring, which only affects the leftmost column of the graph.
+ */
+class FrameTimeGraph
+{
+public:
+    enum Series {
+        NetworkInterval,
+        DecodeTime,
+        PacerTime,
+        RenderTime,
+        SeriesMax
+    };
+
+    FrameTimeGraph();
+    ~FrameTimeGraph();
+
+    void submit(Series series, uint64_t valueUs);
+
+    /**
+     * @brief Renders the legend shown above the plot with the given font.
+     *
+     * This must be called before the first render(), from the same context
+     * that serializes render() calls.
+     */
+    void buildLegend(TTF_Font* font);
+
+    /**
+     * @brief Draws the graph into a new surface. The caller must free it.
+     */
+    SDL_Surface* render();
+
+private:
+    void drawSeries(SDL_Surface* surface, int plotY, Series series);
+
+    struct {
+        uint32_t samplesUs[FRAME_GRAPH_SAMPLES];
+
+        // Samples written so far. This wraps back by FRAME_GRAPH_SAMPLES once the
+        // ring is full, so it stays small and still gives the next write index.
+        SDL_atomic_t total;
+    } m_Rings[SeriesMax];
+
+    SDL_Surface* m_Legend;
+};
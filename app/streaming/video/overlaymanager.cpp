@@ -3,8 +3,19 @@
 
 using namespace Overlay;
 
+// Characters cached in the glyph atlas. Text containing anything
+// else is rendered by SDL_ttf directly.
+#define GLYPH_ATLAS_FIRST_CHAR ' '
+#define GLYPH_ATLAS_LAST_CHAR '~'
+#define GLYPH_ATLAS_CHAR_COUNT (GLYPH_ATLAS_LAST_CHAR - GLYPH_ATLAS_FIRST_CHAR + 1)
+
+// Maximum width of the rendered text in pixels before it wraps
+#define OVERLAY_WRAP_LENGTH 1024
+
 OverlayManager::OverlayManager() :
     m_Renderer(nullptr),
+    m_RenderLock(SDL_CreateMutex()),
+    m_SurfaceLock(0),
     m_FontData(Path::readDataFile("ModeSeven.ttf"))
 {
     memset(m_Overlays, 0, sizeof(m_Overlays));
@@ -15,6 +26,10 @@ OverlayManager::OverlayManager() :
     m_Overlays[OverlayType::OverlayStatusUpdate].color = {0xCC, 0x00, 0x00, 0xFF};
     m_Overlays[OverlayType::OverlayStatusUpdate].fontSize = 36;
 
+    // The frame graph only uses its font for the legend, which has its own colors
+    m_Overlays[OverlayType::OverlayFrameGraph].color = {0xFF, 0xFF, 0xFF, 0xFF};
+    m_Overlays[OverlayType::OverlayFrameGraph].fontSize = 12;
+
     // While TTF will usually not be initialized here, it is valid for that not to
     // be the case, since Session destruction is deferred and could overlap with
     // the lifetime of a new Session object.
@@ -37,8 +52,16 @@ OverlayManager::~OverlayManager()
         if (m_Overlays[i].font != nullptr) {
             TTF_CloseFont(m_Overlays[i].font);
         }
+        if (m_Overlays[i].glyphAtlas != nullptr) {
+            SDL_FreeSurface(m_Overlays[i].glyphAtlas);
+        }
+        if (m_Overlays[i].composedSurface != nullptr) {
+            SDL_FreeSurface(m_Overlays[i].composedSurface);
+        }
     }
 
+    SDL_DestroyMutex(m_RenderLock);
+
     TTF_Quit();
 
     // For similar reasons to the comment in the constructor, this will usually,
@@ -77,10 +100,36 @@ int OverlayManager::getOverlayFontSize(OverlayType type)
 }
 
 SDL_Surface* OverlayManager::getUpdatedOverlaySurface(OverlayType type)
+{
+    SDL_Rect updateRect;
+    bool partialUpdate;
+
+    // Renderers that don't support partial updates are always handed the whole overlay
+    SDL_Surface* surface = getUpdatedOverlaySurface(type, &updateRect, &partialUpdate);
+    SDL_assert(!partialUpdate);
+    return surface;
+}
+
+SDL_Surface* OverlayManager::getUpdatedOverlaySurface(OverlayType type, SDL_Rect* updateRect, bool* partialUpdate)
 {
     // If a new surface is available, return it. If not, return nullptr.
     // Caller must free the surface on success.
-    return (SDL_Surface*)SDL_AtomicSetPtr((void**)&m_Overlays[type].surface, nullptr);
+    //
+    // For a partial update, the surface holds only the part of the overlay within
+    // updateRect and the rest is unchanged. Otherwise, it holds the whole overlay.
+    SDL_AtomicLock(&m_SurfaceLock);
+    SDL_Surface* surface = m_Overlays[type].surface;
+    *updateRect = m_Overlays[type].surfaceRect;
+    *partialUpdate = surface != nullptr && m_Overlays[type].surfaceIsPartial;
+    m_Overlays[type].surface = nullptr;
+    SDL_AtomicUnlock(&m_SurfaceLock);
+
+    return surface;
+}
+
+FrameTimeGraph& OverlayManager::getFrameTimeGraph()
+{
+    return m_FrameTimeGraph;
 }
 
 void OverlayManager::setOverlayTextUpdated(OverlayType type)
@@ -115,7 +164,41 @@ SDL_Color OverlayManager::getOverlayColor(OverlayType type)
 
 void OverlayManager::setOverlayRenderer(IOverlayRenderer* renderer)
 {
+    SDL_LockMutex(m_RenderLock);
+
     m_Renderer = renderer;
+
+    // The new renderer doesn't have any of our overlays yet, so a pending
+    // partial update must become a full one and the next updates too.
+    for (int i = 0; i < OverlayType::OverlayMax; i++) {
+        m_Overlays[i].composedSurfaceSent = false;
+
+        SDL_AtomicLock(&m_SurfaceLock);
+        SDL_Surface* pendingSurface = m_Overlays[i].surface;
+        if (pendingSurface != nullptr && m_Overlays[i].surfaceIsPartial) {
+            m_Overlays[i].surface = nullptr;
+        }
+        else {
+            pendingSurface = nullptr;
+        }
+        SDL_AtomicUnlock(&m_SurfaceLock);
+
+        if (pendingSurface != nullptr) {
+            SDL_FreeSurface(pendingSurface);
+
+            // Partial updates are only sent while the composed surface exists
+            SDL_Rect fullRect = { 0, 0, m_Overlays[i].composedSurface->w, m_Overlays[i].composedSurface->h };
+            SDL_Surface* fullSurface = copyComposedSurface((OverlayType)i, fullRect);
+
+            SDL_AtomicLock(&m_SurfaceLock);
+            m_Overlays[i].surface = fullSurface;
+            m_Overlays[i].surfaceRect = fullRect;
+            m_Overlays[i].surfaceIsPartial = false;
+            SDL_AtomicUnlock(&m_SurfaceLock);
+        }
+    }
+
+    SDL_UnlockMutex(m_RenderLock);
 }
 
 void OverlayManager::notifyOverlayUpdated(OverlayType type)
@@ -124,11 +207,14 @@ void OverlayManager::notifyOverlayUpdated(OverlayType type)
         return;
     }
 
+    SDL_LockMutex(m_RenderLock);
+
     // Construct the required font to render the overlay
     if (m_Overlays[type].font == nullptr) {
         if (m_FontData.isEmpty()) {
             SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                          "SDL overlay font failed to load");
+            SDL_UnlockMutex(m_RenderLock);
             return;
         }
 
@@ -142,20 +228,55 @@ void OverlayManager::notifyOverlayUpdated(OverlayType type)
                         TTF_GetError());
 
             // Can't proceed without a font
+            SDL_UnlockMutex(m_RenderLock);
             return;
         }
+
+        if (type == OverlayType::OverlayFrameGraph) {
+            // The legend never changes, so render it once along with the font
+            m_FrameTimeGraph.buildLegend(m_Overlays[type].font);
+        }
+    }
+
+    SDL_Surface* newSurface = nullptr;
+    SDL_Rect newSurfaceRect = {};
+    bool partialUpdate = false;
+    if (!m_Overlays[type].enabled) {
+        // A null surface hides the overlay
+        m_Overlays[type].composedSurfaceSent = false;
+    }
+    else if (type == OverlayType::OverlayFrameGraph) {
+        newSurface = m_FrameTimeGraph.render();
+    }
+    else if (!renderTextFromGlyphAtlas(type, &newSurface, &newSurfaceRect, &partialUpdate)) {
+        // The renderer won't have the composed surface after this
+        m_Overlays[type].composedSurfaceSent = false;
+
+        // The _Wrapped variant is required for line breaks to work
+        newSurface = TTF_RenderText_Blended_Wrapped(m_Overlays[type].font,
+                                                    m_Overlays[type].text,
+                                                    m_Overlays[type].color,
+                                                    OVERLAY_WRAP_LENGTH);
+    }
+    else if (newSurface == nullptr && partialUpdate) {
+        // The text didn't change, so there's nothing new to hand over
+        SDL_UnlockMutex(m_RenderLock);
+        return;
+    }
+
+    if (newSurface != nullptr && !partialUpdate) {
+        newSurfaceRect = { 0, 0, newSurface->w, newSurface->h };
     }
 
     // Exchange the old surface with the new one
-    SDL_Surface* oldSurface = (SDL_Surface*)SDL_AtomicSetPtr(
-        (void**)&m_Overlays[type].surface,
-        m_Overlays[type].enabled ?
-            // The _Wrapped variant is required for line breaks to work
-            TTF_RenderText_Blended_Wrapped(m_Overlays[type].font,
-                                           m_Overlays[type].text,
-                                           m_Overlays[type].color,
-                                           1024)
-            : nullptr);
+    SDL_AtomicLock(&m_SurfaceLock);
+    SDL_Surface* oldSurface = m_Overlays[type].surface;
+    m_Overlays[type].surface = newSurface;
+    m_Overlays[type].surfaceRect = newSurfaceRect;
+    m_Overlays[type].surfaceIsPartial = partialUpdate;
+    SDL_AtomicUnlock(&m_SurfaceLock);
+
+    SDL_UnlockMutex(m_RenderLock);
 
     // Notify the renderer
     m_Renderer->notifyOverlayUpdated(type);
@@ -165,3 +286,230 @@ void OverlayManager::notifyOverlayUpdated(OverlayType type)
         SDL_FreeSurface(oldSurface);
     }
 }
+
+bool OverlayManager::buildGlyphAtlas(OverlayType type)
+{
+    TTF_Font* font = m_Overlays[type].font;
+    int advance;
+
+    // Text can only be laid out in cells with a fixed-width font
+    if (!TTF_FontFaceIsFixedWidth(font) ||
+            TTF_GlyphMetrics(font, 'M', nullptr, nullptr, nullptr, nullptr, &advance) != 0 ||
+            advance <= 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Overlay font is not fixed-width; glyph atlas disabled");
+        return false;
+    }
+
+    int height = TTF_FontHeight(font);
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0,
+                                                        advance * GLYPH_ATLAS_CHAR_COUNT,
+                                                        height,
+                                                        32,
+                                                        SDL_PIXELFORMAT_ARGB8888);
+    if (atlas == nullptr) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "SDL_CreateRGBSurfaceWithFormat() failed: %s",
+                    SDL_GetError());
+        return false;
+    }
+
+    for (int ch = GLYPH_ATLAS_FIRST_CHAR; ch <= GLYPH_ATLAS_LAST_CHAR; ch++) {
+        SDL_Surface* glyph = TTF_RenderGlyph_Blended(font, (Uint16)ch, m_Overlays[type].color);
+        if (glyph == nullptr) {
+            // Leave the cell transparent
+            continue;
+        }
+
+        // Copy the glyph without blending, so the atlas keeps the
+        // same straight alpha that TTF_RenderText_Blended() produces.
+        SDL_SetSurfaceBlendMode(glyph, SDL_BLENDMODE_NONE);
+
+        SDL_Rect src = { 0, 0, SDL_min(glyph->w, advance), SDL_min(glyph->h, height) };
+        SDL_Rect dst = { (ch - GLYPH_ATLAS_FIRST_CHAR) * advance, 0, src.w, src.h };
+        SDL_BlitSurface(glyph, &src, atlas, &dst);
+        SDL_FreeSurface(glyph);
+    }
+
+    SDL_SetSurfaceBlendMode(atlas, SDL_BLENDMODE_NONE);
+
+    m_Overlays[type].glyphAtlas = atlas;
+    m_Overlays[type].glyphWidth = advance;
+    m_Overlays[type].glyphHeight = height;
+    m_Overlays[type].lineSkip = TTF_FontLineSkip(font);
+    return true;
+}
+
+// Returns false if the text must be rendered by SDL_ttf instead. If the renderer supports
+// it and already has the rest of the overlay, only the part that changed is returned as a
+// partial update. A partial update without a surface means nothing changed. Must hold
+// m_RenderLock.
+bool OverlayManager::renderTextFromGlyphAtlas(OverlayType type, SDL_Surface** surface, SDL_Rect* surfaceRect, bool* partialUpdate)
+{
+    auto& overlay = m_Overlays[type];
+
+    if (overlay.glyphAtlas == nullptr) {
+        if (overlay.glyphAtlasFailed || !buildGlyphAtlas(type)) {
+            overlay.glyphAtlasFailed = true;
+            return false;
+        }
+    }
+
+    // Measure the text and check that every character is in the atlas.
+    // Like SDL_ttf, a trailing newline doesn't start another line.
+    int lines = 1;
+    int columns = 0;
+    int maxColumns = 0;
+    for (const char* c = overlay.text; *c != 0; c++) {
+        if (*c == '\n') {
+            if (*(c + 1) != 0) {
+                lines++;
+            }
+            columns = 0;
+        }
+        else if (*c < GLYPH_ATLAS_FIRST_CHAR || *c > GLYPH_ATLAS_LAST_CHAR) {
+            return false;
+        }
+        else {
+            columns++;
+            maxColumns = SDL_max(maxColumns, columns);
+        }
+    }
+
+    if (maxColumns == 0) {
+        // SDL_ttf can't render an empty string either
+        overlay.composedSurfaceSent = false;
+        *surface = nullptr;
+        *partialUpdate = false;
+        return true;
+    }
+    else if (maxColumns * overlay.glyphWidth > OVERLAY_WRAP_LENGTH) {
+        // Let SDL_ttf handle wrapping long lines
+        return false;
+    }
+
+    int width = maxColumns * overlay.glyphWidth;
+    int height = (lines - 1) * overlay.lineSkip + overlay.glyphHeight;
+
+    if (overlay.composedSurface == nullptr ||
+            overlay.composedSurface->w != width ||
+            overlay.composedSurface->h != height ||
+            overlay.lineSkip < overlay.glyphHeight) {
+        // The layout changed (or glyph cells overlap), so start over on a cleared surface
+        if (overlay.composedSurface != nullptr) {
+            SDL_FreeSurface(overlay.composedSurface);
+        }
+        overlay.composedSurface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+        overlay.composedText[0] = 0;
+        overlay.composedSurfaceSent = false;
+        if (overlay.composedSurface == nullptr) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                        "SDL_CreateRGBSurfaceWithFormat() failed: %s",
+                        SDL_GetError());
+            return false;
+        }
+    }
+
+    // Walk the old and new text line by line, blitting only the cells that changed
+    SDL_Rect dirtyRect = {};
+    const char* oldText = overlay.composedText;
+    const char* newText = overlay.text;
+    for (int line = 0; line < lines; line++) {
+        for (int column = 0; ; column++) {
+            bool oldLineEnded = *oldText == 0 || *oldText == '\n';
+            bool newLineEnded = *newText == 0 || *newText == '\n';
+            if (oldLineEnded && newLineEnded) {
+                break;
+            }
+
+            char oldCh = oldLineEnded ? ' ' : *oldText++;
+            char newCh = newLineEnded ? ' ' : *newText++;
+            if (oldCh == newCh) {
+                continue;
+            }
+
+            SDL_Rect src = { (newCh - GLYPH_ATLAS_FIRST_CHAR) * overlay.glyphWidth, 0,
+                             overlay.glyphWidth, overlay.glyphHeight };
+            SDL_Rect dst = { column * overlay.glyphWidth, line * overlay.lineSkip,
+                             overlay.glyphWidth, overlay.glyphHeight };
+            SDL_BlitSurface(overlay.glyphAtlas, &src, overlay.composedSurface, &dst);
+
+            SDL_Rect unionRect;
+            SDL_UnionRect(&dirtyRect, &dst, &unionRect);
+            dirtyRect = unionRect;
+        }
+
+        if (*oldText == '\n') {
+            oldText++;
+        }
+        if (*newText == '\n') {
+            newText++;
+        }
+    }
+
+    SDL_strlcpy(overlay.composedText, overlay.text, sizeof(overlay.composedText));
+
+    // If the renderer already has the rest of the overlay, only copy what changed
+    *partialUpdate = overlay.composedSurfaceSent && m_Renderer != nullptr && m_Renderer->supportsPartialOverlayUpdates();
+    if (*partialUpdate) {
+        // The renderer may not have picked up the last update yet,
+        // so this one must also cover what that one changed.
+        SDL_AtomicLock(&m_SurfaceLock);
+        bool hasPendingSurface = overlay.surface != nullptr;
+        bool pendingPartialUpdate = overlay.surfaceIsPartial;
+        SDL_Rect pendingRect = overlay.surfaceRect;
+        SDL_AtomicUnlock(&m_SurfaceLock);
+
+        if (hasPendingSurface) {
+            if (pendingPartialUpdate) {
+                SDL_Rect unionRect;
+                SDL_UnionRect(&dirtyRect, &pendingRect, &unionRect);
+                dirtyRect = unionRect;
+            }
+            else {
+                *partialUpdate = false;
+            }
+        }
+    }
+
+    if (*partialUpdate) {
+        if (SDL_RectEmpty(&dirtyRect)) {
+            *surface = nullptr;
+            return true;
+        }
+
+        *surfaceRect = dirtyRect;
+    }
+    else {
+        *surfaceRect = { 0, 0, width, height };
+    }
+
+    // The renderer takes ownership of the surface we return
+    *surface = copyComposedSurface(type, *surfaceRect);
+    if (*surface == nullptr) {
+        return false;
+    }
+
+    overlay.composedSurfaceSent = true;
+    return true;
+}
+
+// Copies part of the composed surface into a new surface. Must hold m_RenderLock.
+SDL_Surface* OverlayManager::copyComposedSurface(OverlayType type, const SDL_Rect& rect)
+{
+    SDL_Surface* composedSurface = m_Overlays[type].composedSurface;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, rect.w, rect.h, 32, composedSurface->format->format);
+    if (surface == nullptr) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "SDL_CreateRGBSurfaceWithFormat() failed: %s",
+                    SDL_GetError());
+        return nullptr;
+    }
+
+    SDL_ConvertPixels(rect.w, rect.h,
+                      composedSurface->format->format,
+                      (Uint8*)composedSurface->pixels + (rect.y * composedSurface->pitch) + (rect.x * composedSurface->format->BytesPerPixel),
+                      composedSurface->pitch,
+                      surface->format->format, surface->pixels, surface->pitch);
+    return surface;
+}
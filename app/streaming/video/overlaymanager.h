@@ -5,11 +5,17 @@
 #include "SDL_compat.h"
 #include <SDL_ttf.h>
 
+#include "frametimegraph.h"
+
+// The debug overlay holds the video, audio and input stats sections
+#define OVERLAY_MAX_TEXT_LENGTH 2048
+
 namespace Overlay {
 
 enum OverlayType {
     OverlayDebug,
     OverlayStatusUpdate,
+    OverlayFrameGraph,
     OverlayMax
 };
 
@@ -19,6 +25,11 @@ public:
     virtual ~IOverlayRenderer() = default;
 
     virtual void notifyOverlayUpdated(OverlayType type) = 0;
+
+    // Renderers that keep the last overlay surface they were given can return true
+    // to be handed just the part of the overlay that changed. They must fetch updates
+    // with the getUpdatedOverlaySurface() overload that reports the update rect.
+    virtual bool supportsPartialOverlayUpdates() { return false; }
 };
 
 class OverlayManager
@@ -36,22 +47,55 @@ public:
     SDL_Color getOverlayColor(OverlayType type);
     int getOverlayFontSize(OverlayType type);
     SDL_Surface* getUpdatedOverlaySurface(OverlayType type);
+    SDL_Surface* getUpdatedOverlaySurface(OverlayType type, SDL_Rect* updateRect, bool* partialUpdate);
+    FrameTimeGraph& getFrameTimeGraph();
 
     void setOverlayRenderer(IOverlayRenderer* renderer);
 
 private:
     void notifyOverlayUpdated(OverlayType type);
+    bool buildGlyphAtlas(OverlayType type);
+    bool renderTextFromGlyphAtlas(OverlayType type, SDL_Surface** surface, SDL_Rect* surfaceRect, bool* partialUpdate);
+    SDL_Surface* copyComposedSurface(OverlayType type, const SDL_Rect& rect);
 
     struct {
         bool enabled;
         int fontSize;
         SDL_Color color;
-        char text[1024];
+        char text[OVERLAY_MAX_TEXT_LENGTH];
 
         TTF_Font* font;
+
+        // The next surface for the renderer, where it goes within the
+        // overlay, and whether it only holds the part that changed
         SDL_Surface* surface;
+        SDL_Rect surfaceRect;
+        bool surfaceIsPartial;
+
+        // Fixed-width glyph cells rendered once per font
+        SDL_Surface* glyphAtlas;
+        bool glyphAtlasFailed;
+        int glyphWidth;
+        int glyphHeight;
+        int lineSkip;
+
+        // The last text composed from the atlas, kept to redraw only changed cells
+        SDL_Surface* composedSurface;
+        char composedText[OVERLAY_MAX_TEXT_LENGTH];
+
+        // Set once the renderer has been handed all of composedSurface,
+        // so later changes can be sent as partial updates
+        bool composedSurfaceSent;
     } m_Overlays[OverlayMax];
     IOverlayRenderer* m_Renderer;
+
+    // Overlays are rendered from both the main thread and the decoder thread. This
+    // serializes access to the fonts, glyph atlases, composed text and frame graph.
+    SDL_mutex* m_RenderLock;
+
+    // Guards the surface handed to the renderer along with its update rect
+    SDL_SpinLock m_SurfaceLock;
+    FrameTimeGraph m_FrameTimeGraph;
     QByteArray m_FontData;
 };
 
@@ -12,6 +12,19 @@ win32:!winrt {
     app.depends += AntiHooking
 }
 
+# Mock GameStream host for testing the client without a real host
+enable-mockhost {
+    SUBDIRS += mockhost
+    mockhost.subdir = tools/mockhost
+}
+
+# Micro-benchmarks for client hot paths
+enable-benchmarks {
+    SUBDIRS += serverinfobench keyboardbench
+    serverinfobench.subdir = tools/serverinfobench
+    keyboardbench.subdir = tools/keyboardbench
+}
+
 # Support debug and release builds from command line for CI
 CONFIG += debug_and_release
 
@@ -0,0 +1,15 @@
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = keyboardbench
+TEMPLATE = app
+
+# Include global qmake defs
+include(../../globaldefs.pri)
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    main.cpp
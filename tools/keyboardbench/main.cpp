@@ -0,0 +1,207 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QBitArray>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Counts every heap allocation made by the process, including those made
+// inside Qt, so we can see what the key tracking allocates per event.
+static std::atomic<quint64> s_Allocations;
+
+void* operator new(std::size_t size)
+{
+    s_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
+
+struct KeyEvent {
+    short keyCode;
+    bool pressed;
+};
+
+// Reproduces the held key tracking that SdlInputHandler::handleKeyEvent() did before
+// the QBitArray, which inserted and removed a QSet entry for each key press
+class SetKeyTracker
+{
+public:
+    void handleKeyEvent(const KeyEvent& event)
+    {
+        if (event.pressed) {
+            m_KeysDown.insert(event.keyCode);
+        }
+        else {
+            m_KeysDown.remove(event.keyCode);
+        }
+    }
+
+    int keysDown() const
+    {
+        return (int)m_KeysDown.count();
+    }
+
+private:
+    QSet<short> m_KeysDown;
+};
+
+// Matches the current held key tracking in SdlInputHandler
+class BitArrayKeyTracker
+{
+public:
+    BitArrayKeyTracker()
+        : m_KeysDown(256) {}
+
+    void handleKeyEvent(const KeyEvent& event)
+    {
+        m_KeysDown.setBit(event.keyCode, event.pressed);
+    }
+
+    int keysDown() const
+    {
+        return m_KeysDown.count(true);
+    }
+
+private:
+    QBitArray m_KeysDown;
+};
+
+// Generates typing with some rollover, where up to 3 keys can be held at once
+static QVector<KeyEvent> generateKeyEvents(int count)
+{
+    static const short k_KeyCodes[] = {
+        0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D,
+        0x4E, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A,
+        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+        0x20, // VK_SPACE
+        0x0D, // VK_RETURN
+        0x08, // VK_BACK
+        0xA0, // VK_LSHIFT
+        0xA2, // VK_LCONTROL
+    };
+
+    QRandomGenerator rng(1234);
+    QVector<KeyEvent> events;
+    QVector<short> held;
+
+    events.reserve(count);
+    while (events.size() < count) {
+        if (held.size() < 3 && (held.isEmpty() || rng.bounded(2) == 0)) {
+            short keyCode = k_KeyCodes[rng.bounded((int)(sizeof(k_KeyCodes) / sizeof(k_KeyCodes[0])))];
+            if (!held.contains(keyCode)) {
+                held.append(keyCode);
+                events.append(KeyEvent { keyCode, true });
+            }
+        }
+        else {
+            events.append(KeyEvent { held.takeFirst(), false });
+        }
+    }
+
+    return events;
+}
+
+struct BenchResult {
+    double allocationsPerRun;
+    double nsPerEvent;
+};
+
+// Each run replays the events into a new tracker, like a new streaming session
+template <typename Tracker>
+static BenchResult measure(const QVector<KeyEvent>& events, int runs)
+{
+    QElapsedTimer timer;
+    int checksum = 0;
+
+    quint64 allocationsBefore = s_Allocations.load(std::memory_order_relaxed);
+    timer.start();
+    for (int i = 0; i < runs; i++) {
+        Tracker tracker;
+        for (const KeyEvent& event : events) {
+            tracker.handleKeyEvent(event);
+        }
+        checksum += tracker.keysDown();
+    }
+    qint64 elapsedNs = timer.nsecsElapsed();
+    quint64 allocations = s_Allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    // Keep the results alive so the tracking can't be optimized out
+    if (checksum < 0) {
+        fprintf(stderr, "Negative key count\n");
+    }
+
+    return { (double)allocations / runs, (double)elapsedNs / runs / events.size() };
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the heap allocations and time spent tracking held keys.");
+    parser.addHelpOption();
+
+    QCommandLineOption eventsOption("events", "Number of key events in each run.", "count", "10000");
+    parser.addOption(eventsOption);
+    QCommandLineOption runsOption("runs", "Number of runs to average for each tracker.", "count", "100");
+    parser.addOption(runsOption);
+    parser.process(app);
+
+    int eventCount = parser.value(eventsOption).toInt();
+    int runs = parser.value(runsOption).toInt();
+    if (eventCount <= 0 || runs <= 0) {
+        fprintf(stderr, "Invalid event or run count\n");
+        return -1;
+    }
+
+    QVector<KeyEvent> events = generateKeyEvents(eventCount);
+
+    // Warm up both paths before measuring them
+    measure<SetKeyTracker>(events, 1);
+    measure<BitArrayKeyTracker>(events, 1);
+
+    BenchResult setResult = measure<SetKeyTracker>(events, runs);
+    BenchResult bitArrayResult = measure<BitArrayKeyTracker>(events, runs);
+
+    printf("key tracking: %d events per run, %d runs\n", eventCount, runs);
+    printf("  QSet:      %10.1f allocations per run, %6.2f ns per event\n",
+           setResult.allocationsPerRun, setResult.nsPerEvent);
+    printf("  QBitArray: %10.1f allocations per run, %6.2f ns per event\n",
+           bitArrayResult.allocationsPerRun, bitArrayResult.nsPerEvent);
+
+    return 0;
+}
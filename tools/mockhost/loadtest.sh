@@ -0,0 +1,98 @@
+#!/bin/bash
+#
+# Measures the client's polling load against a number of simulated hosts.
+#
+# Usage: loadtest.sh <mockhost binary> <moonlight binary> [hosts] [duration in secs] [mockhost options...]
+#
+# The hosts are started by a single mockhost process and paired with the client
+# using the CLI. The client is then started with POLL_STATS_INTERVAL set, and its
+# CPU usage, thread count and resident memory are sampled once a second. The
+# client's own poll statistics are printed from its log at the end.
+#
+# Extra options are passed through to mockhost, for example:
+#   loadtest.sh ./mockhost ./moonlight 50 120 --latency 200 --jitter 100 --failure-rate 0.05
+
+MOCKHOST=$1
+MOONLIGHT=$2
+HOSTS=${3:-20}
+DURATION=${4:-60}
+shift 4 2>/dev/null || shift $#
+
+BASE_PORT=47989
+PORT_STRIDE=10
+PIN=1234
+POLL_STATS_INTERVAL=10
+
+fail()
+{
+    echo "$1" 1>&2
+    exit 1
+}
+
+[ -x "$MOCKHOST" ] || fail "Usage: $0 <mockhost binary> <moonlight binary> [hosts] [duration in secs] [mockhost options...]"
+[ -x "$MOONLIGHT" ] || fail "Moonlight binary not found: $MOONLIGHT"
+
+WORK_DIR=$(mktemp -d) || fail "Unable to create a working directory"
+MOCKHOST_PID=
+MOONLIGHT_PID=
+
+cleanup()
+{
+    [ -n "$MOONLIGHT_PID" ] && kill $MOONLIGHT_PID 2>/dev/null
+    [ -n "$MOCKHOST_PID" ] && kill $MOCKHOST_PID 2>/dev/null
+    wait 2>/dev/null
+}
+trap cleanup EXIT
+
+echo "Starting $HOSTS mock hosts"
+"$MOCKHOST" --count $HOSTS --port $BASE_PORT --pin $PIN "$@" > "$WORK_DIR/mockhost.log" 2>&1 &
+MOCKHOST_PID=$!
+
+# Wait for the last host to start listening
+LAST_PORT=$((BASE_PORT + (HOSTS - 1) * PORT_STRIDE))
+for i in $(seq 1 100); do
+    if (exec 3<>/dev/tcp/127.0.0.1/$LAST_PORT) 2>/dev/null; then
+        break
+    fi
+    kill -0 $MOCKHOST_PID 2>/dev/null || fail "mockhost exited: $(cat "$WORK_DIR/mockhost.log")"
+    sleep 0.1
+done
+
+echo "Pairing with each host"
+for i in $(seq 0 $((HOSTS - 1))); do
+    PORT=$((BASE_PORT + i * PORT_STRIDE))
+    "$MOONLIGHT" pair 127.0.0.1:$PORT --pin $PIN > "$WORK_DIR/pair.log" 2>&1 ||
+        echo "Failed to pair with 127.0.0.1:$PORT (see $WORK_DIR/pair.log)" 1>&2
+done
+
+echo "Sampling the client for $DURATION seconds"
+POLL_STATS_INTERVAL=$POLL_STATS_INTERVAL "$MOONLIGHT" > "$WORK_DIR/moonlight.log" 2>&1 &
+MOONLIGHT_PID=$!
+
+echo "time_s cpu_percent threads rss_kb" > "$WORK_DIR/samples.txt"
+for t in $(seq 1 $DURATION); do
+    sleep 1
+    SAMPLE=$(ps -o pcpu=,nlwp=,rss= -p $MOONLIGHT_PID) || fail "Moonlight exited early (see $WORK_DIR/moonlight.log)"
+    echo "$t $SAMPLE" >> "$WORK_DIR/samples.txt"
+done
+
+echo
+echo "Client resource usage with $HOSTS hosts:"
+awk 'NR > 1 {
+        cpu += $2; if ($2 > maxCpu) maxCpu = $2
+        if ($3 > maxThreads) maxThreads = $3
+        if ($4 > maxRss) maxRss = $4
+        n++
+     }
+     END {
+        printf "  CPU: %.1f%% average, %.1f%% peak\n", cpu / n, maxCpu
+        printf "  Threads: %d peak\n", maxThreads
+        printf "  Resident memory: %.1f MB peak\n", maxRss / 1024
+     }' "$WORK_DIR/samples.txt"
+
+echo
+echo "Client poll statistics:"
+grep "Polling stats" "$WORK_DIR/moonlight.log" | sed 's/^/  /'
+
+echo
+echo "Logs and samples were saved in $WORK_DIR"
@@ -0,0 +1,72 @@
+#include "mockhost.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <cstdio>
+
+// Each additional host listens on ports this far above the previous one
+#define HOST_PORT_STRIDE 10
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Keep our state away from the client's settings
+    QCoreApplication::setOrganizationName("Moonlight Game Streaming Project");
+    QCoreApplication::setOrganizationDomain("moonlight-stream.com");
+    QCoreApplication::setApplicationName("Moonlight Mock Host");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Emulates GameStream hosts for testing Moonlight without a real host.");
+    parser.addHelpOption();
+
+    QCommandLineOption countOption("count", "Number of hosts to run.", "count", "1");
+    QCommandLineOption portOption("port", "HTTP port of the first host.", "port", "47989");
+    QCommandLineOption httpsPortOption("https-port", "HTTPS port of the first host.", "port", "47984");
+    QCommandLineOption appsOption("apps", "Number of apps each host reports.", "count", "10");
+    QCommandLineOption latencyOption("latency", "Delay before each response, in milliseconds.", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Random extra delay of up to this many milliseconds.", "ms", "0");
+    QCommandLineOption failureRateOption("failure-rate", "Fraction of requests that are dropped without a response (0.0-1.0).", "rate", "0");
+    QCommandLineOption pinOption("pin", "Pairing PIN clients must enter.", "pin", "1234");
+    QCommandLineOption nameOption("name", "Host name prefix.", "name", "MockHost");
+    QCommandLineOption resetOption("reset", "Forget the host identities and paired clients.");
+    parser.addOptions({ countOption, portOption, httpsPortOption, appsOption, latencyOption,
+                        jitterOption, failureRateOption, pinOption, nameOption, resetOption });
+    parser.process(app);
+
+    int count = parser.value(countOption).toInt();
+    int port = parser.value(portOption).toInt();
+    int httpsPort = parser.value(httpsPortOption).toInt();
+    if (count <= 0 || port <= 0 || httpsPort <= 0 ||
+            port + (count - 1) * HOST_PORT_STRIDE > 65535 ||
+            httpsPort + (count - 1) * HOST_PORT_STRIDE > 65535) {
+        fprintf(stderr, "Invalid host count or ports\n");
+        return -1;
+    }
+
+    MockHostConfig config;
+    config.appCount = qMax(0, parser.value(appsOption).toInt());
+    config.latencyMs = qMax(0, parser.value(latencyOption).toInt());
+    config.latencyJitterMs = qMax(0, parser.value(jitterOption).toInt());
+    config.failureRate = qBound(0.0, parser.value(failureRateOption).toDouble(), 1.0);
+    config.pin = parser.value(pinOption);
+
+    for (int i = 0; i < count; i++) {
+        config.httpPort = (quint16)(port + i * HOST_PORT_STRIDE);
+        config.httpsPort = (quint16)(httpsPort + i * HOST_PORT_STRIDE);
+        config.name = count > 1 ?
+                    QString("%1-%2").arg(parser.value(nameOption)).arg(i + 1) :
+                    parser.value(nameOption);
+
+        MockHost* host = new MockHost(config, &app);
+        if (parser.isSet(resetOption)) {
+            host->resetState();
+        }
+        if (!host->start()) {
+            return -1;
+        }
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,679 @@
+#include "mockhost.h"
+
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QSslSocket>
+#include <QTimer>
+#include <QUuid>
+#include <QUrl>
+#include <QBuffer>
+#include <QImage>
+#include <QColor>
+
+#include <stdexcept>
+
+#include <openssl/bio.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+
+#define SER_UNIQUEID "uniqueid"
+#define SER_CERT "certificate"
+#define SER_KEY "key"
+#define SER_CLIENTS "clients"
+
+// We report the same version as Sunshine, so clients use Gen 7 pairing (SHA-256)
+#define APP_VERSION "7.1.431.-1"
+#define GFE_VERSION "3.23.0.74"
+
+// H.264, HEVC and HEVC Main10 (SCM_H264 | SCM_HEVC | SCM_HEVC_MAIN10)
+#define SERVER_CODEC_MODE_SUPPORT 0x301
+
+// Apps are numbered from here, so their IDs don't look like array indices
+#define FIRST_APP_ID 1000
+
+#define BOX_ART_WIDTH 300
+#define BOX_ART_HEIGHT 400
+
+// Requests are GETs without a body, so anything larger is garbage
+#define MAX_REQUEST_HEADER_SIZE 65536
+
+#define THROW_BAD_ALLOC_IF_NULL(x) \
+    if ((x) == nullptr) throw std::bad_alloc()
+
+static QByteArray generateRandomBytes(int length)
+{
+    QByteArray data(length, 0);
+    RAND_bytes(reinterpret_cast<unsigned char*>(data.data()), length);
+    return data;
+}
+
+static QByteArray aes128Ecb(const QByteArray& input, const QByteArray& key, bool encrypt)
+{
+    QByteArray output(input.size(), 0);
+    int outputLen;
+
+    EVP_CIPHER_CTX* cipher = EVP_CIPHER_CTX_new();
+    THROW_BAD_ALLOC_IF_NULL(cipher);
+
+    EVP_CipherInit(cipher, EVP_aes_128_ecb(), reinterpret_cast<const unsigned char*>(key.constData()), nullptr, encrypt ? 1 : 0);
+    EVP_CIPHER_CTX_set_padding(cipher, 0);
+
+    EVP_CipherUpdate(cipher,
+                     reinterpret_cast<unsigned char*>(output.data()),
+                     &outputLen,
+                     reinterpret_cast<const unsigned char*>(input.constData()),
+                     input.size());
+    Q_ASSERT(outputLen == output.size());
+
+    EVP_CIPHER_CTX_free(cipher);
+
+    return output;
+}
+
+static X509* readPemCert(const QByteArray& pem)
+{
+    BIO* bio = BIO_new_mem_buf(pem.constData(), pem.size());
+    THROW_BAD_ALLOC_IF_NULL(bio);
+
+    X509* cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr);
+    BIO_free_all(bio);
+
+    return cert;
+}
+
+static QByteArray getSignatureFromPemCert(const QByteArray& pem)
+{
+    X509* cert = readPemCert(pem);
+    if (cert == nullptr) {
+        return QByteArray();
+    }
+
+    const ASN1_BIT_STRING* asnSignature;
+    X509_get0_signature(&asnSignature, nullptr, cert);
+
+    QByteArray signature(reinterpret_cast<const char*>(asnSignature->data), asnSignature->length);
+
+    X509_free(cert);
+
+    return signature;
+}
+
+static bool verifySignature(const QByteArray& data, const QByteArray& signature, const QByteArray& pem)
+{
+    X509* cert = readPemCert(pem);
+    if (cert == nullptr) {
+        return false;
+    }
+
+    EVP_PKEY* pubKey = X509_get_pubkey(cert);
+    THROW_BAD_ALLOC_IF_NULL(pubKey);
+
+    EVP_MD_CTX* mdctx = EVP_MD_CTX_create();
+    THROW_BAD_ALLOC_IF_NULL(mdctx);
+
+    EVP_DigestVerifyInit(mdctx, nullptr, EVP_sha256(), nullptr, pubKey);
+    EVP_DigestVerifyUpdate(mdctx, data.constData(), data.size());
+    int result = EVP_DigestVerifyFinal(mdctx, reinterpret_cast<const unsigned char*>(signature.constData()), signature.size());
+
+    EVP_PKEY_free(pubKey);
+    EVP_MD_CTX_destroy(mdctx);
+    X509_free(cert);
+
+    return result > 0;
+}
+
+static QByteArray signMessage(const QByteArray& message, EVP_PKEY* privateKey)
+{
+    EVP_MD_CTX* ctx = EVP_MD_CTX_create();
+    THROW_BAD_ALLOC_IF_NULL(ctx);
+
+    EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, privateKey);
+    EVP_DigestSignUpdate(ctx, message.constData(), message.size());
+
+    size_t signatureLength = 0;
+    EVP_DigestSignFinal(ctx, nullptr, &signatureLength);
+
+    QByteArray signature((int)signatureLength, 0);
+    EVP_DigestSignFinal(ctx, reinterpret_cast<unsigned char*>(signature.data()), &signatureLength);
+
+    EVP_MD_CTX_destroy(ctx);
+
+    return signature;
+}
+
+MockHttpServer::MockHttpServer(MockHost* host, bool https)
+    : m_Host(host),
+      m_Https(https)
+{
+
+}
+
+void MockHttpServer::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket* socket;
+
+    if (m_Https) {
+        QSslSocket* sslSocket = new QSslSocket(this);
+        if (!sslSocket->setSocketDescriptor(socketDescriptor)) {
+            delete sslSocket;
+            return;
+        }
+
+        // QueryPeer asks for the client certificate without validating it
+        sslSocket->setLocalCertificate(m_Host->m_SslCert);
+        sslSocket->setPrivateKey(m_Host->m_SslKey);
+        sslSocket->setPeerVerifyMode(QSslSocket::QueryPeer);
+        sslSocket->startServerEncryption();
+        socket = sslSocket;
+    }
+    else {
+        socket = new QTcpSocket(this);
+        if (!socket->setSocketDescriptor(socketDescriptor)) {
+            delete socket;
+            return;
+        }
+    }
+
+    m_Host->handleConnection(socket, m_Https);
+}
+
+MockHost::MockHost(const MockHostConfig& config, QObject* parent)
+    : QObject(parent),
+      m_Config(config),
+      m_HttpServer(this, false),
+      m_HttpsServer(this, true),
+      m_PrivateKey(nullptr),
+      m_CurrentGameId(0)
+{
+    loadState();
+}
+
+MockHost::~MockHost()
+{
+    EVP_PKEY_free(m_PrivateKey);
+}
+
+bool MockHost::start()
+{
+    if (!m_HttpServer.listen(QHostAddress::Any, m_Config.httpPort)) {
+        qWarning() << m_Config.name << "failed to listen on HTTP port" << m_Config.httpPort << ":" << m_HttpServer.errorString();
+        return false;
+    }
+
+    if (!m_HttpsServer.listen(QHostAddress::Any, m_Config.httpsPort)) {
+        qWarning() << m_Config.name << "failed to listen on HTTPS port" << m_Config.httpsPort << ":" << m_HttpsServer.errorString();
+        m_HttpServer.close();
+        return false;
+    }
+
+    qInfo().nospace() << m_Config.name << " listening on ports " << m_Config.httpPort << "/" << m_Config.httpsPort
+                      << " with " << m_Config.appCount << " apps (" << m_PairedClients.count() << " paired clients)";
+    return true;
+}
+
+void MockHost::loadState()
+{
+    QSettings settings;
+    settings.beginGroup(QString("host%1").arg(m_Config.httpPort));
+
+    m_UniqueId = settings.value(SER_UNIQUEID).toString();
+    m_PemCert = settings.value(SER_CERT).toByteArray();
+    m_PemKey = settings.value(SER_KEY).toByteArray();
+
+    m_PairedClients.clear();
+    const QStringList clients = settings.value(SER_CLIENTS).toStringList();
+    for (const QString& client : clients) {
+        QSslCertificate clientCert(client.toLatin1());
+        if (!clientCert.isNull()) {
+            m_PairedClients.append(clientCert);
+        }
+    }
+
+    settings.endGroup();
+
+    m_SslCert = QSslCertificate(m_PemCert);
+    m_SslKey = QSslKey(m_PemKey, QSsl::Rsa);
+    if (m_UniqueId.isEmpty() || m_SslCert.isNull() || m_SslKey.isNull()) {
+        createCredentials();
+        saveState();
+    }
+
+    EVP_PKEY_free(m_PrivateKey);
+    BIO* bio = BIO_new_mem_buf(m_PemKey.constData(), m_PemKey.size());
+    THROW_BAD_ALLOC_IF_NULL(bio);
+    m_PrivateKey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+    BIO_free_all(bio);
+    if (m_PrivateKey == nullptr) {
+        throw std::runtime_error("Unable to load private key");
+    }
+}
+
+void MockHost::saveState()
+{
+    QStringList clients;
+    for (const QSslCertificate& clientCert : std::as_const(m_PairedClients)) {
+        clients.append(QString::fromLatin1(clientCert.toPem()));
+    }
+
+    QSettings settings;
+    settings.beginGroup(QString("host%1").arg(m_Config.httpPort));
+    settings.setValue(SER_UNIQUEID, m_UniqueId);
+    settings.setValue(SER_CERT, m_PemCert);
+    settings.setValue(SER_KEY, m_PemKey);
+    settings.setValue(SER_CLIENTS, clients);
+    settings.endGroup();
+}
+
+void MockHost::resetState()
+{
+    {
+        QSettings settings;
+        settings.remove(QString("host%1").arg(m_Config.httpPort));
+    }
+
+    resetPairing();
+    loadState();
+}
+
+void MockHost::createCredentials()
+{
+    X509* cert = X509_new();
+    THROW_BAD_ALLOC_IF_NULL(cert);
+
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+    THROW_BAD_ALLOC_IF_NULL(ctx);
+
+    EVP_PKEY_keygen_init(ctx);
+    EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048);
+
+    // pk must be initialized on input
+    EVP_PKEY* pk = nullptr;
+    EVP_PKEY_keygen(ctx, &pk);
+
+    EVP_PKEY_CTX_free(ctx);
+    THROW_BAD_ALLOC_IF_NULL(pk);
+
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 0);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 60 * 60 * 24 * 365 * 20); // 20 yrs
+
+    X509_set_pubkey(cert, pk);
+
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("Sunshine Gamestream Host"),
+                               -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    X509_sign(cert, pk, EVP_sha256());
+
+    BIO* biokey = BIO_new(BIO_s_mem());
+    THROW_BAD_ALLOC_IF_NULL(biokey);
+
+    // SecureTransport on macOS can only read the old PKCS1 format
+#ifdef Q_OS_DARWIN
+    PEM_write_bio_PrivateKey_traditional(biokey, pk, nullptr, nullptr, 0, nullptr, nullptr);
+#else
+    PEM_write_bio_PrivateKey(biokey, pk, nullptr, nullptr, 0, nullptr, nullptr);
+#endif
+
+    BIO* biocert = BIO_new(BIO_s_mem());
+    THROW_BAD_ALLOC_IF_NULL(biocert);
+    PEM_write_bio_X509(biocert, cert);
+
+    BUF_MEM* mem;
+    BIO_get_mem_ptr(biokey, &mem);
+    m_PemKey = QByteArray(mem->data, (int)mem->length);
+
+    BIO_get_mem_ptr(biocert, &mem);
+    m_PemCert = QByteArray(mem->data, (int)mem->length);
+
+    X509_free(cert);
+    EVP_PKEY_free(pk);
+    BIO_free(biokey);
+    BIO_free(biocert);
+
+    m_SslCert = QSslCertificate(m_PemCert);
+    m_SslKey = QSslKey(m_PemKey, QSsl::Rsa);
+    if (m_SslCert.isNull() || m_SslKey.isNull()) {
+        qFatal("Newly generated host credentials are unreadable");
+    }
+
+    m_UniqueId = QUuid::createUuid().toString(QUuid::WithoutBraces).toUpper();
+    m_PairedClients.clear();
+
+    qInfo() << m_Config.name << "generated a new identity:" << m_UniqueId;
+}
+
+bool MockHost::isPaired(const QSslCertificate& clientCert)
+{
+    return !clientCert.isNull() && m_PairedClients.contains(clientCert);
+}
+
+void MockHost::handleConnection(QTcpSocket* socket, bool https)
+{
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket, https]() {
+        processRequests(socket, https);
+    });
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+}
+
+void MockHost::processRequests(QTcpSocket* socket, bool https)
+{
+    // Requests on a kept-alive connection are answered in order, one at a time
+    if (socket->property("requestPending").toBool()) {
+        return;
+    }
+
+    QByteArray buffered = socket->peek(socket->bytesAvailable());
+    int headerEnd = buffered.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buffered.size() > MAX_REQUEST_HEADER_SIZE) {
+            socket->abort();
+            socket->deleteLater();
+        }
+        return;
+    }
+
+    QList<QByteArray> lines = socket->read(headerEnd + 4).split('\n');
+    QList<QByteArray> requestLine = lines.takeFirst().trimmed().split(' ');
+    if (requestLine.count() != 3 || requestLine[0] != "GET") {
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+
+    bool keepAlive = requestLine[2] != "HTTP/1.0";
+    for (const QByteArray& line : std::as_const(lines)) {
+        if (line.trimmed().toLower() == "connection: close") {
+            keepAlive = false;
+        }
+    }
+
+    // Simulate a host that drops off the network mid-request
+    if (QRandomGenerator::global()->generateDouble() < m_Config.failureRate) {
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+
+    int delayMs = m_Config.latencyMs;
+    if (m_Config.latencyJitterMs > 0) {
+        delayMs += QRandomGenerator::global()->bounded(m_Config.latencyJitterMs + 1);
+    }
+
+    QUrl url(QString::fromLatin1(requestLine[1]));
+    socket->setProperty("requestPending", true);
+    QTimer::singleShot(delayMs, socket, [this, socket, https, url, keepAlive]() {
+        QSslCertificate clientCert;
+        if (https) {
+            clientCert = static_cast<QSslSocket*>(socket)->peerCertificate();
+        }
+
+        Response response = handleRequest(url.path().mid(1), QUrlQuery(url), https, clientCert);
+
+        QByteArray header = "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: " + response.contentType + "\r\n"
+                            "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+        if (!keepAlive) {
+            header += "Connection: close\r\n";
+        }
+        header += "\r\n";
+
+        socket->write(header);
+        socket->write(response.body);
+        socket->setProperty("requestPending", false);
+
+        if (keepAlive) {
+            processRequests(socket, https);
+        }
+        else {
+            socket->disconnectFromHost();
+        }
+    });
+}
+
+MockHost::Response MockHost::handleRequest(const QString& command, const QUrlQuery& query, bool https, const QSslCertificate& clientCert)
+{
+    Response response;
+    response.contentType = "application/xml";
+
+    if (command == "serverinfo") {
+        response.body = getServerInfo(https, clientCert);
+    }
+    else if (command == "pair") {
+        response.body = pair(query, https, clientCert);
+    }
+    else if (command == "unpair") {
+        resetPairing();
+        response.body = statusXml(200, "OK");
+    }
+    else if (!https || !isPaired(clientCert)) {
+        // Everything else requires a paired client over HTTPS
+        response.body = statusXml(401, "The client is not authorized. Certificate verification failed.");
+    }
+    else if (command == "applist") {
+        response.body = getAppList();
+    }
+    else if (command == "appasset") {
+        int appId = query.queryItemValue("appid").toInt();
+        if (appId >= FIRST_APP_ID && appId < FIRST_APP_ID + m_Config.appCount) {
+            response.contentType = "image/png";
+            response.body = getBoxArt(appId);
+        }
+        else {
+            response.body = statusXml(404, "Cannot find requested app");
+        }
+    }
+    else if (command == "launch" || command == "resume") {
+        int appId = query.queryItemValue("appid").toInt();
+        if (command == "resume" && m_CurrentGameId == 0) {
+            response.body = statusXml(503, "No running app to resume");
+        }
+        else if (command == "launch" && (appId < FIRST_APP_ID || appId >= FIRST_APP_ID + m_Config.appCount)) {
+            response.body = statusXml(404, "Cannot find requested app");
+        }
+        else {
+            if (command == "launch") {
+                m_CurrentGameId = appId;
+            }
+
+            // There's nothing listening for RTSP, so streaming will fail after this
+            response.body = statusXml(200, "OK",
+                                      "<sessionUrl0>rtsp://127.0.0.1:48010</sessionUrl0>"
+                                      "<gamesession>1</gamesession>"
+                                      "<resume>1</resume>");
+            qInfo() << m_Config.name << "started app" << m_CurrentGameId;
+        }
+    }
+    else if (command == "cancel") {
+        m_CurrentGameId = 0;
+        response.body = statusXml(200, "OK", "<cancel>1</cancel>");
+        qInfo() << m_Config.name << "quit the running app";
+    }
+    else {
+        response.body = statusXml(404, "Not found");
+    }
+
+    return response;
+}
+
+QByteArray MockHost::getServerInfo(bool https, const QSslCertificate& clientCert)
+{
+    bool paired = https && isPaired(clientCert);
+
+    // Like GFE and Sunshine, HTTPS requests are only served to paired clients
+    if (https && !paired) {
+        return statusXml(401, "The client is not authorized. Certificate verification failed.");
+    }
+
+    QByteArray content;
+    content += "<hostname>" + m_Config.name.toHtmlEscaped().toUtf8() + "</hostname>";
+    content += "<appversion>" APP_VERSION "</appversion>";
+    content += "<GfeVersion>" GFE_VERSION "</GfeVersion>";
+    content += "<uniqueid>" + m_UniqueId.toLatin1() + "</uniqueid>";
+    content += "<HttpsPort>" + QByteArray::number(m_Config.httpsPort) + "</HttpsPort>";
+    content += "<ExternalPort>" + QByteArray::number(m_Config.httpPort) + "</ExternalPort>";
+    content += "<MaxLumaPixelsHEVC>1869449984</MaxLumaPixelsHEVC>";
+    content += "<mac>00:00:00:00:00:00</mac>";
+    content += "<LocalIP>127.0.0.1</LocalIP>";
+    content += "<ServerCodecModeSupport>" + QByteArray::number(SERVER_CODEC_MODE_SUPPORT) + "</ServerCodecModeSupport>";
+    content += "<SupportedDisplayMode>"
+               "<DisplayMode><Width>1920</Width><Height>1080</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+               "<DisplayMode><Width>3840</Width><Height>2160</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+               "</SupportedDisplayMode>";
+    content += "<PairStatus>" + QByteArray(paired ? "1" : "0") + "</PairStatus>";
+    content += "<currentgame>" + QByteArray::number(m_CurrentGameId) + "</currentgame>";
+    content += m_CurrentGameId != 0 ? "<state>SUNSHINE_SERVER_BUSY</state>" : "<state>SUNSHINE_SERVER_FREE</state>";
+
+    return statusXml(200, "OK", content);
+}
+
+QByteArray MockHost::getAppList()
+{
+    QByteArray content;
+    for (int i = 0; i < m_Config.appCount; i++) {
+        content += "<App>";
+        content += "<IsHdrSupported>" + QByteArray(i % 2 ? "1" : "0") + "</IsHdrSupported>";
+        content += "<AppTitle>Mock App " + QByteArray::number(i + 1) + "</AppTitle>";
+        content += "<ID>" + QByteArray::number(FIRST_APP_ID + i) + "</ID>";
+        content += "</App>";
+    }
+
+    return statusXml(200, "OK", content);
+}
+
+QByteArray MockHost::getBoxArt(int appId)
+{
+    auto it = m_BoxArtCache.constFind(appId);
+    if (it != m_BoxArtCache.constEnd()) {
+        return *it;
+    }
+
+    // Give each app its own color, so box art mixups are visible
+    QImage image(BOX_ART_WIDTH, BOX_ART_HEIGHT, QImage::Format_RGB32);
+    image.fill(QColor::fromHsv((appId * 37) % 360, 160, 200));
+
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+
+    m_BoxArtCache.insert(appId, png);
+    return png;
+}
+
+QByteArray MockHost::pair(const QUrlQuery& query, bool https, const QSslCertificate& clientCert)
+{
+    QByteArray notPaired = statusXml(200, "OK", "<paired>0</paired>");
+
+    if (query.queryItemValue("phrase") == "getservercert") {
+        // Only one client can pair at a time. The client unpairs to cancel.
+        if (!m_PairingClientCert.isNull()) {
+            return statusXml(200, "OK", "<paired>1</paired>");
+        }
+
+        QByteArray clientPem = QByteArray::fromHex(query.queryItemValue("clientcert").toLatin1());
+        QByteArray salt = QByteArray::fromHex(query.queryItemValue("salt").toLatin1());
+        m_PairingClientCert = QSslCertificate(clientPem);
+        if (m_PairingClientCert.isNull() || salt.size() != 16) {
+            resetPairing();
+            return notPaired;
+        }
+
+        QByteArray saltedPin = salt + m_Config.pin.toUtf8();
+        m_PairingAesKey = QCryptographicHash::hash(saltedPin, QCryptographicHash::Sha256).left(16);
+
+        qInfo() << m_Config.name << "started pairing, PIN is" << m_Config.pin;
+        return statusXml(200, "OK", "<paired>1</paired><plaincert>" + m_PemCert.toHex() + "</plaincert>");
+    }
+    else if (query.hasQueryItem("clientchallenge")) {
+        QByteArray challenge = QByteArray::fromHex(query.queryItemValue("clientchallenge").toLatin1());
+        if (m_PairingAesKey.isEmpty() || challenge.size() != 16) {
+            resetPairing();
+            return notPaired;
+        }
+
+        QByteArray clientChallenge = aes128Ecb(challenge, m_PairingAesKey, false);
+        m_PairingServerSecret = generateRandomBytes(16);
+        m_PairingServerChallenge = generateRandomBytes(16);
+
+        // Prove that we know the PIN and hold the key for our certificate
+        QByteArray serverResponse = QCryptographicHash::hash(clientChallenge +
+                                                             getSignatureFromPemCert(m_PemCert) +
+                                                             m_PairingServerSecret,
+                                                             QCryptographicHash::Sha256);
+        QByteArray challengeResponse = aes128Ecb(serverResponse + m_PairingServerChallenge, m_PairingAesKey, true);
+        return statusXml(200, "OK", "<paired>1</paired><challengeresponse>" + challengeResponse.toHex() + "</challengeresponse>");
+    }
+    else if (query.hasQueryItem("serverchallengeresp")) {
+        QByteArray response = QByteArray::fromHex(query.queryItemValue("serverchallengeresp").toLatin1());
+        if (m_PairingServerSecret.isEmpty() || response.size() != 32) {
+            resetPairing();
+            return notPaired;
+        }
+
+        m_PairingClientHash = aes128Ecb(response, m_PairingAesKey, false);
+
+        QByteArray pairingSecret = m_PairingServerSecret + signMessage(m_PairingServerSecret, m_PrivateKey);
+        return statusXml(200, "OK", "<paired>1</paired><pairingsecret>" + pairingSecret.toHex() + "</pairingsecret>");
+    }
+    else if (query.hasQueryItem("clientpairingsecret")) {
+        QByteArray pairingSecret = QByteArray::fromHex(query.queryItemValue("clientpairingsecret").toLatin1());
+        if (m_PairingClientHash.isEmpty() || pairingSecret.size() <= 16) {
+            resetPairing();
+            return notPaired;
+        }
+
+        QByteArray clientSecret = pairingSecret.left(16);
+        QByteArray clientSignature = pairingSecret.mid(16);
+        QByteArray clientPem = m_PairingClientCert.toPem();
+
+        // The client hash only matches if the client used the same PIN
+        QByteArray expectedClientHash = QCryptographicHash::hash(m_PairingServerChallenge +
+                                                                 getSignatureFromPemCert(clientPem) +
+                                                                 clientSecret,
+                                                                 QCryptographicHash::Sha256);
+        if (expectedClientHash != m_PairingClientHash ||
+                !verifySignature(clientSecret, clientSignature, clientPem)) {
+            qWarning() << m_Config.name << "rejected pairing: incorrect PIN";
+            resetPairing();
+            return notPaired;
+        }
+
+        if (!m_PairedClients.contains(m_PairingClientCert)) {
+            m_PairedClients.append(m_PairingClientCert);
+            saveState();
+        }
+
+        qInfo() << m_Config.name << "paired a new client";
+        resetPairing();
+        return statusXml(200, "OK", "<paired>1</paired>");
+    }
+    else if (query.queryItemValue("phrase") == "pairchallenge") {
+        return statusXml(200, "OK", https && isPaired(clientCert) ? "<paired>1</paired>" : "<paired>0</paired>");
+    }
+
+    return notPaired;
+}
+
+void MockHost::resetPairing()
+{
+    m_PairingClientCert = QSslCertificate();
+    m_PairingAesKey.clear();
+    m_PairingServerSecret.clear();
+    m_PairingServerChallenge.clear();
+    m_PairingClientHash.clear();
+}
+
+QByteArray MockHost::statusXml(int statusCode, const QString& statusMessage, const QByteArray& content)
+{
+    return "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+           "<root status_code=\"" + QByteArray::number(statusCode) + "\" "
+           "status_message=\"" + statusMessage.toHtmlEscaped().toUtf8() + "\">" +
+           content +
+           "</root>";
+}
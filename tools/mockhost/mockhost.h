@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QUrlQuery>
+#include <QHash>
+
+#include <openssl/evp.h>
+
+class MockHost;
+
+class MockHostConfig
+{
+public:
+    QString name;
+    quint16 httpPort;
+    quint16 httpsPort;
+    int appCount;
+    int latencyMs;
+    int latencyJitterMs;
+    double failureRate;
+    QString pin;
+};
+
+// Accepts HTTP or HTTPS connections for a MockHost. HTTPS clients are asked for
+// a certificate but it isn't validated, since the host only checks whether it
+// was paired, just like GFE and Sunshine.
+class MockHttpServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    MockHttpServer(MockHost* host, bool https);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    MockHost* m_Host;
+    bool m_Https;
+};
+
+/**
+ * @brief The MockHost class emulates the HTTP API of a GameStream host.
+ *
+ * It serves serverinfo, applist, appasset, launch, resume, cancel, pair and unpair
+ * well enough for NvHTTP, NvPairingManager and ComputerManager to treat it as a
+ * Sunshine host. Pairing runs the full challenge exchange, so a wrong PIN fails
+ * the same way it does with a real host. No stream is ever started.
+ *
+ * Each response is delayed by the configured latency, and requests fail at the
+ * configured rate by dropping the connection without a response. The host identity
+ * and paired clients are kept in QSettings so clients stay paired across restarts.
+ */
+class MockHost : public QObject
+{
+    Q_OBJECT
+
+public:
+    MockHost(const MockHostConfig& config, QObject* parent = nullptr);
+    ~MockHost();
+
+    bool start();
+
+    void resetState();
+
+    void handleConnection(QTcpSocket* socket, bool https);
+
+private:
+    class Response
+    {
+    public:
+        QByteArray contentType;
+        QByteArray body;
+    };
+
+    void loadState();
+
+    void saveState();
+
+    void createCredentials();
+
+    bool isPaired(const QSslCertificate& clientCert);
+
+    void processRequests(QTcpSocket* socket, bool https);
+
+    Response handleRequest(const QString& command, const QUrlQuery& query, bool https, const QSslCertificate& clientCert);
+
+    QByteArray getServerInfo(bool https, const QSslCertificate& clientCert);
+
+    QByteArray getAppList();
+
+    QByteArray getBoxArt(int appId);
+
+    QByteArray pair(const QUrlQuery& query, bool https, const QSslCertificate& clientCert);
+
+    void resetPairing();
+
+    static QByteArray statusXml(int statusCode, const QString& statusMessage, const QByteArray& content = QByteArray());
+
+    MockHostConfig m_Config;
+    MockHttpServer m_HttpServer;
+    MockHttpServer m_HttpsServer;
+    QString m_UniqueId;
+    QByteArray m_PemCert;
+    QByteArray m_PemKey;
+    QSslCertificate m_SslCert;
+    QSslKey m_SslKey;
+    EVP_PKEY* m_PrivateKey;
+    QList<QSslCertificate> m_PairedClients;
+    int m_CurrentGameId;
+    QHash<int, QByteArray> m_BoxArtCache;
+
+    // State of the pairing in progress, if any
+    QSslCertificate m_PairingClientCert;
+    QByteArray m_PairingAesKey;
+    QByteArray m_PairingServerSecret;
+    QByteArray m_PairingServerChallenge;
+    QByteArray m_PairingClientHash;
+
+    friend class MockHttpServer;
+};
@@ -0,0 +1,45 @@
+QT = core gui network
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = mockhost
+TEMPLATE = app
+
+# Include global qmake defs
+include(../../globaldefs.pri)
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+win32 {
+    contains(QT_ARCH, i386) {
+        LIBS += -L$$PWD/../../libs/windows/lib/x86
+        INCLUDEPATH += $$PWD/../../libs/windows/include/x86
+    }
+    contains(QT_ARCH, x86_64) {
+        LIBS += -L$$PWD/../../libs/windows/lib/x64
+        INCLUDEPATH += $$PWD/../../libs/windows/include/x64
+    }
+    contains(QT_ARCH, arm64) {
+        LIBS += -L$$PWD/../../libs/windows/lib/arm64
+        INCLUDEPATH += $$PWD/../../libs/windows/include/arm64
+    }
+
+    INCLUDEPATH += $$PWD/../../libs/windows/include
+    LIBS += -llibssl -llibcrypto
+}
+macx:!disable-prebuilts {
+    INCLUDEPATH += $$PWD/../../libs/mac/include
+    LIBS += -L$$PWD/../../libs/mac/lib -lssl.3 -lcrypto.3
+}
+unix:if(!macx|disable-prebuilts) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += openssl
+}
+
+SOURCES += \
+    main.cpp \
+    mockhost.cpp
+
+HEADERS += \
+    mockhost.h
@@ -0,0 +1,188 @@
+#include "nvserverinfo.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QXmlStreamReader>
+
+#include <cstdio>
+
+// Reproduces NvHTTP::getXmlString(), which the client used to call once per field
+static QString legacyGetXmlString(const QString& xml, const QString& tagName)
+{
+    QXmlStreamReader xmlReader(xml);
+
+    while (!xmlReader.atEnd())
+    {
+        if (xmlReader.readNext() != QXmlStreamReader::StartElement)
+        {
+            continue;
+        }
+
+        if (xmlReader.name() == tagName)
+        {
+            return xmlReader.readElementText();
+        }
+    }
+
+    return nullptr;
+}
+
+// Reproduces the root status check of NvHTTP::verifyResponseStatus()
+static bool legacyVerifyResponseStatus(const QString& xml, int* statusCode)
+{
+    QXmlStreamReader xmlReader(xml);
+
+    while (xmlReader.readNextStartElement())
+    {
+        if (xmlReader.name() == QString("root"))
+        {
+            *statusCode = (int)xmlReader.attributes().value("status_code").toUInt();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Reproduces NvHTTP::getDisplayModeList()
+static QVector<NvDisplayMode> legacyGetDisplayModeList(const QString& serverInfo)
+{
+    QXmlStreamReader xmlReader(serverInfo);
+    QVector<NvDisplayMode> modes;
+
+    while (!xmlReader.atEnd()) {
+        while (xmlReader.readNextStartElement()) {
+            auto name = xmlReader.name();
+            if (name == QString("DisplayMode")) {
+                modes.append(NvDisplayMode());
+            }
+            else if (name == QString("Width")) {
+                modes.last().width = xmlReader.readElementText().toInt();
+            }
+            else if (name == QString("Height")) {
+                modes.last().height = xmlReader.readElementText().toInt();
+            }
+            else if (name == QString("RefreshRate")) {
+                modes.last().refreshRate = xmlReader.readElementText().toInt();
+            }
+        }
+    }
+
+    return modes;
+}
+
+// Performs the same lookups that NvHTTP::getServerInfo(), NvHTTP::getCurrentGame()
+// and the NvComputer constructor made on each poll before the single-pass parser
+static NvServerInfo parseLegacy(const QByteArray& response)
+{
+    // Responses used to be decoded into a QString first
+    QString serverInfo = QString::fromUtf8(response);
+    NvServerInfo info;
+
+    info.hasRoot = legacyVerifyResponseStatus(serverInfo, &info.statusCode);
+    info.httpsPort = legacyGetXmlString(serverInfo, "HttpsPort");
+    info.hostname = legacyGetXmlString(serverInfo, "hostname");
+    info.uniqueId = legacyGetXmlString(serverInfo, "uniqueid");
+    info.mac = legacyGetXmlString(serverInfo, "mac");
+    info.serverCodecModeSupport = legacyGetXmlString(serverInfo, "ServerCodecModeSupport");
+    info.maxLumaPixelsHEVC = legacyGetXmlString(serverInfo, "MaxLumaPixelsHEVC");
+    info.displayModes = legacyGetDisplayModeList(serverInfo);
+    info.localIp = legacyGetXmlString(serverInfo, "LocalIP");
+    info.httpsPort = legacyGetXmlString(serverInfo, "HttpsPort");
+    info.externalPort = legacyGetXmlString(serverInfo, "ExternalPort");
+    info.externalIp = legacyGetXmlString(serverInfo, "ExternalIP");
+    info.state = legacyGetXmlString(serverInfo, "state");
+    info.pairStatus = legacyGetXmlString(serverInfo, "PairStatus");
+    if (legacyGetXmlString(serverInfo, "state").endsWith("_SERVER_BUSY")) {
+        info.currentGame = legacyGetXmlString(serverInfo, "currentgame");
+    }
+    info.appVersion = legacyGetXmlString(serverInfo, "appversion");
+    info.gfeVersion = legacyGetXmlString(serverInfo, "GfeVersion");
+    info.gpuType = legacyGetXmlString(serverInfo, "gputype");
+
+    return info;
+}
+
+static bool isSameResult(const NvServerInfo& a, const NvServerInfo& b)
+{
+    return a.hasRoot == b.hasRoot &&
+            a.statusCode == b.statusCode &&
+            a.hostname == b.hostname &&
+            a.uniqueId == b.uniqueId &&
+            a.mac == b.mac &&
+            a.localIp == b.localIp &&
+            a.httpsPort == b.httpsPort &&
+            a.state == b.state &&
+            a.pairStatus == b.pairStatus &&
+            a.appVersion == b.appVersion &&
+            a.gpuType == b.gpuType &&
+            a.displayModes == b.displayModes;
+}
+
+template <typename Parser>
+static double measureParseUs(const QByteArray& response, int iterations, Parser parser)
+{
+    QElapsedTimer timer;
+    int checksum = 0;
+
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        checksum += parser(response).hostname.length();
+    }
+    qint64 elapsedNs = timer.nsecsElapsed();
+
+    // Keep the results alive so the parse can't be optimized out
+    if (checksum == 0) {
+        fprintf(stderr, "Parsed an empty hostname\n");
+    }
+
+    return (double)elapsedNs / iterations / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the cost of parsing a serverinfo response.");
+    parser.addHelpOption();
+
+    QCommandLineOption iterationsOption("iterations", "Number of parses to time for each parser.", "count", "20000");
+    parser.addOption(iterationsOption);
+    parser.addPositionalArgument("file", "Captured serverinfo response (defaults to a bundled GFE response).", "[file]");
+    parser.process(app);
+
+    int iterations = parser.value(iterationsOption).toInt();
+    if (iterations <= 0) {
+        fprintf(stderr, "Invalid iteration count\n");
+        return -1;
+    }
+
+    QString path = parser.positionalArguments().isEmpty() ? ":/serverinfo.xml" : parser.positionalArguments().first();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Unable to open %s\n", qPrintable(path));
+        return -1;
+    }
+    QByteArray response = file.readAll();
+
+    if (!isSameResult(parseLegacy(response), NvServerInfo::parse(response))) {
+        fprintf(stderr, "The parsers disagree on %s\n", qPrintable(path));
+        return -1;
+    }
+
+    // Warm up both paths before timing them
+    measureParseUs(response, qMin(iterations, 1000), parseLegacy);
+    measureParseUs(response, qMin(iterations, 1000), NvServerInfo::parse);
+
+    double legacyUs = measureParseUs(response, iterations, parseLegacy);
+    double singlePassUs = measureParseUs(response, iterations, NvServerInfo::parse);
+
+    printf("serverinfo response: %d bytes, %d iterations\n", (int)response.size(), iterations);
+    printf("  per-field scans: %8.2f us per parse\n", legacyUs);
+    printf("  single pass:     %8.2f us per parse (%.1fx faster)\n", singlePassUs, legacyUs / singlePassUs);
+
+    return 0;
+}